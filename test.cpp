@@ -1,235 +1,1405 @@
+/*
+	uGON benchmark
+
+	Times gon_parse (with and without a GonPool allocator), gon_load_baked against loading and parsing the text, gon_reparse_range after a one-character edit, the streaming GonParser, GonReader, gon_serialize (indented and minified), gon_serialized_size, gon_serialize_n, gon_serialize_file, GonFilePrinter, gon_get_field (and gon_get_field_key with GON_USING_ATOMS), path queries (chained gon_get_field against gon_path_get and gon_path_set_get), struct binding (gon_get_float per member against gon_bind and ugon::load) number conversion, and gon_load_many against loading each file in turn (for the files given) over a matrix of corpus shapes and sizes.
+	Results are printed as a table, and can also be written as JSON and/or CSV so that runs from different versions can be compared.
+
+	Usage: ugon_bench [options] [file.gon ...]
+		--sizes  4k,256k,16m     corpus sizes to generate for each shape
+		--shapes nested,wide     corpus shapes to generate (nested, wide, numeric, strings)
+		--time   0.25            minimum seconds to spend on each benchmark
+		--json   results.json    write results as JSON
+		--csv    results.csv     write results as CSV
+		--speed-test             run the original comparison against strlen (and rapidxml / GON if available) on test.gon and test.xml
+		--speed-gon  file.gon    run the speed test on another GON file (such as one written by tools/gon_gen)
+		--speed-xml  file.xml    and its XML twin
+		--many                   treat the .gon files as one batch: skip the per-file benchmarks, and time loading them all (needs GON_USING_THREADS)
+		--verify                 instead of timing anything, check that every way of reading each corpus gives the same fields as gon_parse (see Verification below), returning 1 on any difference
+	Any .gon files given on the command line are benchmarked in addition to the generated corpora, including loading them from disk with gon_load_file.
+
+	If rapidxml/rapidxml.hpp or gon/gon.h are present, the build defines UGON_BENCH_RAPIDXML and UGON_BENCH_GON respectively.
+*/
 
 #include <stdio.h>
-#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
-#include <windows.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define BENCH_HAS_TSC
+#endif
+
+#ifdef UGON_BENCH_RAPIDXML
 #include "rapidxml/rapidxml.hpp"
-#include "ugon.h"
+#endif
+#ifdef UGON_BENCH_GON
 #include "gon/gon.h"
+#endif
+
+/*
+	Allocation counting
+
+	ugon.h calls malloc, calloc, realloc and free directly, so we route them through counters while including it.
+*/
+static std::atomic<uint64_t> bench_alloc_count(0);
+static std::atomic<uint64_t> bench_alloc_bytes(0);
+
+static void* bench_malloc(size_t size) {
+	bench_alloc_count++;
+	bench_alloc_bytes += size;
+	return malloc(size);
+}
+
+static void* bench_calloc(size_t count, size_t size) {
+	bench_alloc_count++;
+	bench_alloc_bytes += count * size;
+	return calloc(count, size);
+}
+
+static void* bench_realloc(void* ptr, size_t size) {
+	bench_alloc_count++;
+	bench_alloc_bytes += size;
+	return realloc(ptr, size);
+}
+
+#define malloc(size)        bench_malloc(size)
+#define calloc(count, size) bench_calloc(count, size)
+#define realloc(ptr, size)  bench_realloc(ptr, size)
+#include "ugon.h"
+#undef malloc
+#undef calloc
+#undef realloc
+#include "ugon.hpp"
+
+// The first 64 members of an object in the wide corpus, for comparing ugon::load against gon_bind
+#define WIDE_MEMBERS(X) \
+	X(key_0) X(key_1) X(key_2) X(key_3) X(key_4) X(key_5) X(key_6) X(key_7) \
+	X(key_8) X(key_9) X(key_10) X(key_11) X(key_12) X(key_13) X(key_14) X(key_15) \
+	X(key_16) X(key_17) X(key_18) X(key_19) X(key_20) X(key_21) X(key_22) X(key_23) \
+	X(key_24) X(key_25) X(key_26) X(key_27) X(key_28) X(key_29) X(key_30) X(key_31) \
+	X(key_32) X(key_33) X(key_34) X(key_35) X(key_36) X(key_37) X(key_38) X(key_39) \
+	X(key_40) X(key_41) X(key_42) X(key_43) X(key_44) X(key_45) X(key_46) X(key_47) \
+	X(key_48) X(key_49) X(key_50) X(key_51) X(key_52) X(key_53) X(key_54) X(key_55) \
+	X(key_56) X(key_57) X(key_58) X(key_59) X(key_60) X(key_61) X(key_62) X(key_63)
+#define WIDE_DECLARE(member) double member = 0;
+struct WideEntity { WIDE_MEMBERS(WIDE_DECLARE) };
+UGON_REFLECT(WideEntity, WIDE_MEMBERS)
+
+
+/*
+	Timing
+*/
+
+static inline double bench_seconds(void) {
+	using namespace std::chrono;
+	return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+static inline uint64_t bench_cycles(void) {
+	#ifdef BENCH_HAS_TSC
+	return __rdtsc();
+	#else
+	return 0;
+	#endif
+}
+
+typedef struct BenchResult {
+	std::string benchmark;
+	std::string corpus;
+	size_t   bytes;				// bytes of GON text processed per rep
+	size_t   fields;			// fields in the corpus
+	uint64_t reps;
+	double   best_seconds;
+	double   mean_seconds;
+	uint64_t best_cycles;
+	double   allocs_per_rep;
+	double   alloc_bytes_per_rep;
+	uint64_t ops_per_rep;		// operations per rep (lookups for gon_get_field, otherwise 1)
+} BenchResult;
+
+static double bench_min_time = 0.25;
 
-__int64 CounterStart = 0;
+/*
+	Runs body repeatedly until at least bench_min_time seconds have been spent in it (and at least 3 reps).
+	setup is run before each rep, outside of the timed region.
+*/
+#define BENCH_RUN(result, setup, body) do {											\
+	double   sum_ = 0, best_ = 1e300;												\
+	uint64_t best_cycles_ = UINT64_MAX, reps_ = 0;									\
+	uint64_t allocs_ = 0, alloc_bytes_ = 0;											\
+	while (reps_ < 3 || sum_ < bench_min_time) {									\
+		setup;																		\
+		uint64_t a0_ = bench_alloc_count, b0_ = bench_alloc_bytes;					\
+		double   t0_ = bench_seconds();												\
+		uint64_t c0_ = bench_cycles();												\
+		body;																		\
+		uint64_t c1_ = bench_cycles();												\
+		double   t1_ = bench_seconds();												\
+		allocs_ += bench_alloc_count - a0_;											\
+		alloc_bytes_ += bench_alloc_bytes - b0_;									\
+		sum_ += t1_ - t0_;															\
+		if (t1_ - t0_ < best_) best_ = t1_ - t0_;									\
+		if (c1_ - c0_ < best_cycles_) best_cycles_ = c1_ - c0_;						\
+		reps_++;																	\
+	}																				\
+	(result).reps                = reps_;											\
+	(result).best_seconds        = best_;											\
+	(result).mean_seconds        = sum_ / reps_;									\
+	(result).best_cycles         = best_cycles_;									\
+	(result).allocs_per_rep      = (double)allocs_ / reps_;							\
+	(result).alloc_bytes_per_rep = (double)alloc_bytes_ / reps_;					\
+} while (0)
 
-typedef union time_64 {
-	uint64_t t64;
-	struct {
-		uint32_t t32_low;
-		uint32_t t32_high;
-	};
-} time_64;
- 
-#define start_timer(cycles_low, cycles_high) asm volatile (\
-	"CPUID\n\t"/*serialize*/\
-	"RDTSC\n\t"/*read the clock*/\
-	"mov %%edx, %0\n\t"\
-	"mov %%eax, %1\n\t": "=r" (cycles_high), "=r"\
-	(cycles_low):: "%rax", "%rbx", "%rcx", "%rdx");\
 
-#define stop_timer(cycles_low, cycles_high) __asm __volatile (\
-	"RDTSCP\n\t"/*read the clock*/\
-	"mov %%edx, %0\n\t"\
-	"mov %%eax, %1\n\t"\
-	"CPUID\n\t": "=r" (cycles_high), "=r"\
-	(cycles_low):: "%rax", "%rbx", "%rcx", "%rdx");\
+/*
+	Corpus generation
 
+	Each shape is repeated until the corpus reaches the requested size.
+*/
 
-inline void start_perf_counter(void) {
-	LARGE_INTEGER li;
-	if (!QueryPerformanceFrequency(&li))
-		puts("QueryPerformanceFrequency failed!\n");
+static void corpus_nested(std::string& out, int i) {
+	// the same structure as test.gon
+	out += "object_" + std::to_string(i) + " {\n";
+	std::string indent = "  ";
+	for (int depth = 0; depth < 5; depth++) {
+		out += indent + "name asdf\n";
+		out += indent + "number 35.35\n";
+		out += indent + "string \"this is a string\"\n";
+		if (depth < 4) out += indent + "object {\n";
+		indent += "  ";
+	}
+	for (int depth = 4; depth >= 0; depth--) {
+		indent.resize(indent.size() - 2);
+		out += indent + "}\n";
+	}
+}
 
-	QueryPerformanceCounter(&li);
-	CounterStart = li.QuadPart;
+static void corpus_wide(std::string& out, int i) {
+	out += "entity_" + std::to_string(i) + " {\n";
+	for (int k = 0; k < 256; k++)
+		out += "  key_" + std::to_string(k) + " " + std::to_string(k * 7 + i) + "\n";
+	out += "}\n";
 }
 
-inline double get_perf_counter(void) {
-	LARGE_INTEGER li;
-	QueryPerformanceCounter(&li);
-	return (double)(li.QuadPart - CounterStart)/* / PCFreq*/;
+static void corpus_numeric(std::string& out, int i) {
+	out += "data_" + std::to_string(i) + " [ ";
+	for (int k = 0; k < 64; k++) {
+		char buf[32];
+		snprintf(buf, sizeof(buf), "%.4f ", (double)((k * 2654435761u + i) % 100000) / 7.0);
+		out += buf;
+	}
+	out += "]\n";
 }
 
-void read_text_file(const char* file_name, char** buffer, size_t* size) {
-	FILE* fp;
+static void corpus_strings(std::string& out, int i) {
+	out += "text_" + std::to_string(i) + " \"";
+	for (int k = 0; k < 8; k++) out += "The quick brown fox, {jumps} over the \\\"lazy\\\" dog. ";
+	out += "\"\n";
+}
+
+typedef void (*CorpusProc)(std::string& out, int i);
+
+typedef struct CorpusShape {
+	const char* name;
+	CorpusProc  proc;
+} CorpusShape;
 
-	fopen_s(&fp, file_name, "rb");
-	if (!fp) perror(file_name), exit(1);
+static const CorpusShape corpus_shapes[] = {
+	{ "nested",  corpus_nested  },
+	{ "wide",    corpus_wide    },
+	{ "numeric", corpus_numeric },
+	{ "strings", corpus_strings },
+};
+
+static std::string build_corpus(CorpusProc proc, size_t size) {
+	std::string out;
+	out.reserve(size + 4096);
+	for (int i = 0; out.size() < size; i++) proc(out, i);
+	return out;
+}
+
+static bool read_text_file(const char* file_name, char** buffer, size_t* size) {
+	FILE* fp = fopen(file_name, "rb");
+	if (!fp) { perror(file_name); return false; }
 
 	fseek(fp, 0L, SEEK_END);
 	*size = ftell(fp);
 	rewind(fp);
 
 	*buffer = (char*)malloc(sizeof(char) * (*size + 1L));
-	if (!*buffer) fclose(fp), fputs("memory alloc fails", stderr), exit(1);
+	if (!*buffer) { fclose(fp); fputs("memory alloc fails\n", stderr); return false; }
 
-	if (!fread(*buffer, sizeof(char), *size, fp))
-		fclose(fp), free(*buffer), fputs("entire read fails", stderr), exit(1);
+	if (*size && !fread(*buffer, sizeof(char), *size, fp)) {
+		fclose(fp), free(*buffer);
+		fputs("entire read fails\n", stderr);
+		return false;
+	}
+	(*buffer)[*size] = 0;
 
 	fclose(fp);
+	return true;
 }
 
-void gon_test(void) {
+
+/*
+	Benchmarks
+*/
+
+// Replays a parsed file through the GonFilePrinter
+static void print_fields(GonFilePrinter* printer, GonFile* gon) {
+	int parent = 0;
+	for (int i = 1; i < gon->fields[0].size; i++) {
+		GonField* field = &gon->fields[i];
+		while (field->parent != parent) {
+			gon_printer_step_out(printer);
+			parent = gon->fields[parent].parent;
+		}
+		bool is_field = field->type == GON_TYPE_FIELD;
+		char* name = gon_name(field);
+		gon_printer_append_n(printer, field->type, name, name ? gon_name_length(field) : 0, is_field ? gon_value(field) : NULL, is_field ? gon_value_length(field) : 0);
+		if (field->type != GON_TYPE_FIELD) parent = i;
+	}
+	while (parent != 0) {
+		gon_printer_step_out(printer);
+		parent = gon->fields[parent].parent;
+	}
+}
+
+static void bench_corpus(std::vector<BenchResult>& results, const char* corpus_name, const char* text, size_t size) {
+	char* buffer = (char*)malloc(size + 1);
+	memcpy(buffer, text, size + 1);
+
+	// parse once up front, both to validate the corpus and to have fields for the other benchmarks
 	GonFile gon = gon_create();
-	read_text_file("test.gon", &gon.file, &gon.file_length);
-	gon_parse(&gon);
+	gon.file        = buffer;
+	gon.file_length = size;
+	if (gon_parse(&gon)) {
+		printf("skipping corpus %s: parse failed\n", corpus_name);
+		gon_free(&gon);
+		return;
+	}
+	size_t field_count = gon.fields[0].size;
 
-	char buf[1024];
-	gon_serialize(&gon, buf, 2);
+	BenchResult base;
+	base.corpus      = corpus_name;
+	base.bytes       = size;
+	base.fields      = field_count;
+	base.ops_per_rep = 1;
 
-	puts(buf);
+	// gon_parse, into a fresh GonFile each time
+	{
+		BenchResult r = base;
+		r.benchmark = "gon_parse";
+		char* copy = (char*)malloc(size + 1);
+		GonFile g;
+		BENCH_RUN(r, (memcpy(copy, text, size + 1), g = gon_create(), g.file = copy, g.file_length = size), gon_parse(&g); gon_free_fields(&g));
+		results.push_back(r);
+
+		// and again, reusing the fields buffer from the previous parse
+		r.benchmark = "gon_parse_reuse";
+		g = gon_create();
+		g.file = copy;
+		g.file_length = size;
+		BENCH_RUN(r, memcpy(copy, text, size + 1), gon_parse(&g));
+		gon_free_fields(&g);
+		results.push_back(r);
+
+		// and into a fresh GonFile each time, but with the fields buffer coming from a pool
+		r.benchmark = "gon_parse_pool";
+		GonPool pool;
+		memset(&pool, 0, sizeof(pool));
+		GonAllocator allocator = gon_pool_allocator(&pool);
+		BENCH_RUN(r, (memcpy(copy, text, size + 1), g = gon_create(), g.allocator = &allocator, g.file = copy, g.file_length = size), gon_parse(&g); gon_free_fields(&g));
+		gon_pool_free(&pool);
+		free(copy);
+		results.push_back(r);
+	}
+
+	// gon_load_baked, from a file baked once up front, against gon_load_file + gon_parse of the same text
+	{
+		const char* text_path  = "ugon_bench.gon";
+		const char* baked_path = "ugon_bench.gonb";
+		FILE* fp = fopen(text_path, "wb");
+		bool written = fp && fwrite(text, 1, size, fp) == size;
+		if (fp) fclose(fp);
+		if (written && !gon_bake(&gon, baked_path)) {
+			BenchResult r = base;
+			r.benchmark = "gon_load_parse";
+			GonFile g;
+			BENCH_RUN(r, g = gon_create(), gon_load_file(&g, text_path); gon_parse(&g); gon_free(&g));
+			results.push_back(r);
+
+			r.benchmark = "gon_load_baked";
+			BENCH_RUN(r, g = gon_create(), gon_load_baked(&g, baked_path); gon_free(&g));
+			results.push_back(r);
+		}
+		remove(text_path);
+		remove(baked_path);
+	}
+
+	// GonReader, pulling every event without building the fields
+	{
+		BenchResult r = base;
+		r.benchmark = "gon_reader_next";
+		char* copy = (char*)malloc(size + 1);
+		GonFile g = gon_create();
+		g.file = copy;
+		g.file_length = size;
+		GonReader reader;
+		GonEvent  event;
+		BENCH_RUN(r, memcpy(copy, text, size + 1), gon_reader_init(&reader, &g); while ((event = gon_reader_next(&reader)) != GON_EVENT_EOF && event != GON_EVENT_ERROR) {} gon_reader_free(&reader));
+		free(copy);
+		results.push_back(r);
+	}
+
+	// GonParser, fed 64k at a time as if the file were arriving over a pipe
+	{
+		BenchResult r = base;
+		r.benchmark = "gon_parser_feed";
+		GonParser p;
+		BENCH_RUN(r, p = gon_parser_create(), for (size_t o = 0; o < size; o += 65536) gon_parser_feed(&p, text + o, size - o < 65536 ? size - o : 65536); gon_parser_finish(&p); gon_free(&p.gon));
+		results.push_back(r);
+	}
+
+	#ifdef GON_USING_THREADS
+	{
+		BenchResult r = base;
+		r.benchmark = "gon_parse_threaded";
+		char* copy = (char*)malloc(size + 1);
+		GonFile g;
+		BENCH_RUN(r, (memcpy(copy, text, size + 1), g = gon_create(), g.file = copy, g.file_length = size), gon_parse_threaded(&g, 8); gon_free_fields(&g));
+		free(copy);
+		results.push_back(r);
+	}
+	#endif
+
+	// gon_reparse_range, flipping the first character of a value near the middle of the file back and forth, as an editor saving a small change would
+	#if defined(GON_USING_DYNAMIC_BUFFER) && !defined(GON_USING_COMPACT_FIELDS)
+	{
+		size_t at = field_count;
+		for (size_t i = field_count / 2; i < field_count && at == field_count; i++) {
+			GonField* f = &gon.fields[i];
+			if (f->type == GON_TYPE_FIELD && (f->flags & GON_FLAG_VALUE_PLAIN) && f->value[0] != 'x') at = i;
+		}
+		if (at < field_count) {
+			BenchResult r = base;
+			r.benchmark = "gon_reparse_range";
+			size_t offset = gon.fields[at].value - buffer;
+			char* flipped = (char*)malloc(size + 1);
+			memcpy(flipped, text, size + 1);
+			flipped[offset] = 'x';
+
+			GonFile live = gon_create();
+			live.file = (char*)malloc(size + 1);
+			memcpy(live.file, text, size + 1);
+			live.file_length = size;
+			gon_parse(&live);
+			GonFile edited;
+			bool flip = true;
+			BENCH_RUN(r, (edited = gon_create(), edited.file = (char*)malloc(size + 1), memcpy(edited.file, flip ? flipped : text, size + 1), edited.file_length = size, flip = !flip),
+				gon_reparse_range(&live, &edited, offset, offset + 1, NULL));
+			gon_free(&live);
+			free(flipped);
+			results.push_back(r);
+		}
+	}
+	#endif
+
+	// gon_serialize into a buffer large enough for the output
+	{
+		BenchResult r = base;
+		r.benchmark = "gon_serialize";
+		size_t out_size = gon_serialized_size(&gon, 2) + 1;	// minified output is never longer
+		char* out = (char*)malloc(out_size);
+		BENCH_RUN(r, (void)0, gon_serialize(&gon, out, 2));
+		results.push_back(r);
+
+		r = base;
+		r.benchmark = "gon_serialized_size";
+		BENCH_RUN(r, (void)0, out_size = gon_serialized_size(&gon, 2) + 1);
+		results.push_back(r);
+
+		r = base;
+		r.benchmark = "gon_serialize_n";
+		BENCH_RUN(r, (void)0, gon_serialize_n(&gon, out, out_size, 2));
+		results.push_back(r);
+
+		r = base;
+		r.benchmark = "gon_serialize_minified";
+		BENCH_RUN(r, (void)0, gon_serialize(&gon, out, GON_MINIFIED));
+		free(out);
+		results.push_back(r);
+	}
+
+	// gon_serialize_file and GonFilePrinter write to a temporary file
+	FILE* fp = tmpfile();
+	if (fp) {
+		BenchResult r = base;
+		r.benchmark = "gon_serialize_file";
+		BENCH_RUN(r, rewind(fp), gon_serialize_file(&gon, fp, 2); fflush(fp));
+		results.push_back(r);
+
+		r.benchmark = "gon_printer";
+		GonFilePrinter printer;
+		BENCH_RUN(r, (rewind(fp), gon_printer_init(&printer, fp, 2)), print_fields(&printer, &gon); gon_printer_flush(&printer); fflush(fp));
+		results.push_back(r);
+		fclose(fp);
+	}
+
+	// gon_get_field: look up (up to 64 of) the children of every object by name
+	{
+		std::vector<std::pair<GonField*, std::string> > lookups;
+		for (size_t i = 0; i < field_count; i++) {
+			GonField* object = &gon.fields[i];
+			if (object->type != GON_TYPE_OBJECT) continue;
+			GonField* child = object + 1;
+			int count = gon_count(object);
+			for (int c = 0; c < count; c++) {
+				if (c % (count / 64 + 1) == 0) lookups.push_back(std::make_pair(object, std::string(gon_name(child), gon_name_length(child))));
+				if (child->type != GON_TYPE_FIELD) child += child->size;
+				child++;
+			}
+		}
+		if (!lookups.empty()) {
+			BenchResult r = base;
+			r.benchmark   = "gon_get_field";
+			r.ops_per_rep = lookups.size();
+			size_t found = 0;
+			BENCH_RUN(r, (void)0, for (size_t i = 0; i < lookups.size(); i++) found += gon_get_field(lookups[i].first, lookups[i].second.c_str()) != NULL);
+			if (found % lookups.size()) printf("warning: gon_get_field missed fields in corpus %s\n", corpus_name);
+			results.push_back(r);
+
+			#ifdef GON_USING_ATOMS
+			// the same lookups with the keys worked out up front
+			std::vector<unsigned int> keys(lookups.size());
+			for (size_t i = 0; i < lookups.size(); i++) keys[i] = gon_atom(lookups[i].second.c_str(), lookups[i].second.size());
+			r.benchmark = "gon_get_field_key";
+			found = 0;
+			BENCH_RUN(r, (void)0, for (size_t i = 0; i < lookups.size(); i++) found += gon_get_field_key(lookups[i].first, keys[i]) != NULL);
+			if (found % lookups.size()) printf("warning: gon_get_field_key missed fields in corpus %s\n", corpus_name);
+			results.push_back(r);
+			#endif
+		}
+	}
+
+	// path queries: the name paths to (up to 256 of) the fields in the first top-level object, looked up in every top-level object with the same shape
+	// once by chaining gon_get_field, once per path with gon_path_get, and all at once with gon_path_set_get
+	{
+		std::vector<GonField*> entities;
+		for (GonField* child = gon.fields + 1; child < gon.fields + field_count; child += child->type == GON_TYPE_FIELD ? 1 : child->size + 1)
+			if (child->type == GON_TYPE_OBJECT) entities.push_back(child);
+
+		std::vector<std::vector<std::string> > chains;
+		std::vector<std::string> texts;
+		if (!entities.empty()) {
+			std::vector<std::pair<GonField*, std::vector<std::string> > > stack(1, std::make_pair(entities[0], std::vector<std::string>()));
+			while (!stack.empty() && chains.size() < 256) {
+				GonField* object = stack.back().first;
+				std::vector<std::string> prefix = stack.back().second;
+				stack.pop_back();
+				GonField* child = object + 1;
+				for (int c = gon_count(object); c > 0 && chains.size() < 256; c--) {
+					std::vector<std::string> chain = prefix;
+					chain.push_back(std::string(gon_name(child), gon_name_length(child)));
+					if (child->type == GON_TYPE_OBJECT) stack.push_back(std::make_pair(child, chain));
+					else if (gon_find_child(object, chain.back().c_str(), chain.back().size(), 0) == child) {
+						std::string text;
+						for (size_t k = 0; k < chain.size(); k++) {
+							if (k) text += '/';
+							for (size_t j = 0; j < chain[k].size(); j++) {
+								if (chain[k][j] == '/' || chain[k][j] == '[' || chain[k][j] == '\\') text += '\\';
+								text += chain[k][j];
+							}
+						}
+						chains.push_back(chain);
+						texts.push_back(text);
+					}
+					child += child->type == GON_TYPE_FIELD ? 1 : child->size + 1;
+				}
+			}
+		}
+
+		std::vector<GonPath> paths(texts.size());
+		std::vector<const char*> path_texts;
+		bool compiled = !texts.empty();
+		for (size_t i = 0; i < texts.size(); i++) {
+			compiled = compiled && !gon_path_compile(&paths[i], texts[i].c_str());
+			path_texts.push_back(texts[i].c_str());
+		}
+		GonPathSet set;
+		if (compiled && !gon_path_set_compile(&set, &path_texts[0], (int)path_texts.size())) {
+			BenchResult r = base;
+			r.ops_per_rep = entities.size() * chains.size();
+			size_t found = 0;
+
+			r.benchmark = "gon_get_field_chain";
+			BENCH_RUN(r, (void)0, for (size_t e = 0; e < entities.size(); e++) for (size_t i = 0; i < chains.size(); i++) {
+				GonField* field = entities[e];
+				for (size_t k = 0; field && k < chains[i].size(); k++) field = field->type == GON_TYPE_OBJECT ? gon_get_field(field, chains[i][k].c_str()) : NULL;
+				found += field != NULL;
+			});
+			results.push_back(r);
+
+			r.benchmark = "gon_path_get";
+			BENCH_RUN(r, (void)0, for (size_t e = 0; e < entities.size(); e++) for (size_t i = 0; i < paths.size(); i++) found += gon_path_get(entities[e], &paths[i]) != NULL);
+			results.push_back(r);
+
+			r.benchmark = "gon_path_set_get";
+			std::vector<GonField*> out(paths.size());
+			BENCH_RUN(r, (void)0, for (size_t e = 0; e < entities.size(); e++) found += gon_path_set_get(&set, entities[e], &out[0]));
+			results.push_back(r);
+			gon_path_set_free(&set);
+			if (found == 1) puts("");	// keeps the lookups from being optimized away
+		}
+		for (size_t i = 0; i < paths.size(); i++) gon_path_free(&paths[i]);
+	}
+
+	// struct binding: the numeric values directly inside the first top-level object (up to 64), read from every top-level object
+	// once per member with gon_get_float, and in one walk with gon_bind
+	{
+		std::vector<GonField*> entities;
+		for (GonField* child = gon.fields + 1; child < gon.fields + field_count; child += child->type == GON_TYPE_FIELD ? 1 : child->size + 1)
+			if (child->type == GON_TYPE_OBJECT) entities.push_back(child);
+
+		std::vector<std::string> names;
+		if (!entities.empty()) {
+			GonField* child = entities[0] + 1;
+			for (int c = gon_count(entities[0]); c > 0 && names.size() < 64; c--) {
+				double value;
+				std::string name(gon_name(child), gon_name_length(child));
+				if (gon_field_double(child, &value) == GON_VALUE_OK && gon_find_child(entities[0], name.c_str(), name.size(), 0) == child) names.push_back(name);
+				child += child->type == GON_TYPE_FIELD ? 1 : child->size + 1;
+			}
+		}
+
+		std::vector<GonBinding> bindings(names.size());
+		for (size_t i = 0; i < names.size(); i++) {
+			GonBinding binding = { names[i].c_str(), GON_BIND_DOUBLE, i * sizeof(double), "0", NULL, 0, sizeof(double), 0, 0 };
+			bindings[i] = binding;
+		}
+		GonBinder binder;
+		if (!names.empty() && !gon_binder_compile(&binder, &bindings[0], (int)bindings.size())) {
+			BenchResult r = base;
+			r.ops_per_rep = entities.size() * names.size();
+			std::vector<double> values(names.size());
+			double sum = 0;
+
+			r.benchmark = "gon_get_float_members";
+			BENCH_RUN(r, (void)0, for (size_t e = 0; e < entities.size(); e++) for (size_t i = 0; i < names.size(); i++) sum += gon_get_float(entities[e], names[i].c_str(), 0));
+			results.push_back(r);
+
+			r.benchmark = "gon_bind";
+			BENCH_RUN(r, (void)0, for (size_t e = 0; e < entities.size(); e++) { gon_bind(&binder, entities[e], &values[0]); sum += values[0]; });
+			results.push_back(r);
+
+			// the same members through the C++ binding, where the corpus has them
+			if (names.size() == 64 && names[0] == "key_0" && names[63] == "key_63") {
+				r.benchmark = "ugon::load";
+				WideEntity entity;
+				BENCH_RUN(r, (void)0, for (size_t e = 0; e < entities.size(); e++) { ugon::load(entities[e], entity); sum += entity.key_0; });
+				results.push_back(r);
+			}
+			gon_binder_free(&binder);
+			if (sum == 1e300) puts("");
+		}
+	}
+
+	// number conversion: every value that is a number, with atof for comparison and then through a warmed-up GonValueCache
+	{
+		std::vector<GonField*> numbers;
+		for (size_t i = 1; i < field_count; i++) {
+			double value;
+			if (gon_field_double(&gon.fields[i], &value) == GON_VALUE_OK) numbers.push_back(&gon.fields[i]);
+		}
+		if (!numbers.empty()) {
+			BenchResult r = base;
+			r.ops_per_rep = numbers.size();
+			double sum = 0, value = 0;
+
+			r.benchmark = "atof";
+			BENCH_RUN(r, (void)0, for (size_t i = 0; i < numbers.size(); i++) sum += atof(gon_value(numbers[i])));
+			results.push_back(r);
+
+			r.benchmark = "gon_field_double";
+			BENCH_RUN(r, (void)0, for (size_t i = 0; i < numbers.size(); i++) sum += gon_field_double(numbers[i], &value) ? 0 : value);
+			results.push_back(r);
+
+			r.benchmark = "gon_cached_double";
+			GonValueCache cache = gon_value_cache_create(&gon);
+			BENCH_RUN(r, (void)0, for (size_t i = 0; i < numbers.size(); i++) sum += gon_cached_double(&cache, numbers[i], &value) ? 0 : value);
+			gon_value_cache_clear(&cache);
+			results.push_back(r);
+			if (sum == 1e300) puts("");	// keeps the conversions from being optimized away
+		}
+	}
 
 	gon_free(&gon);
 }
 
-uint64_t time_strlen(const char* buffer, size_t size, uint64_t reps) {
-	int len = 0;
-	time_64 start_time, end_time, 
-		min_time = {.t64 = INT64_MAX}, 
-		sum_time = {.t64 = 0};
+// Loading and parsing a file from disk, reading it into a buffer as the old test did versus gon_load_file
+static void bench_file_load(std::vector<BenchResult>& results, const char* path, size_t size) {
+	BenchResult r;
+	r.corpus      = path;
+	r.bytes       = size;
+	r.ops_per_rep = 1;
+
+	r.benchmark = "read+gon_parse";
+	GonFile g = gon_create();
+	BENCH_RUN(r, (void)0, read_text_file(path, &g.file, &g.file_length); gon_parse(&g); gon_free(&g); g = gon_create());
+	results.push_back(r);
+
+	r.benchmark = "gon_load_file+parse";
+	BENCH_RUN(r, (void)0, gon_load_file(&g, path); r.fields = gon_parse(&g) ? 0 : g.fields[0].size; gon_free(&g); g = gon_create());
+	results.push_back(r);
+	results[results.size() - 2].fields = r.fields;
+}
+
 
-	for (int i = 0; i < reps; i++) {
-		start_timer(start_time.t32_low, start_time.t32_high);
-		len = strlen(buffer);
-		stop_timer(end_time.t32_low, end_time.t32_high);
+/*
+	Output
+*/
 
-		time_64 this_time;
-		this_time.t64 = end_time.t64 - start_time.t64;
-		sum_time.t64 += this_time.t64;
-		if (this_time.t64 < min_time.t64) min_time.t64 = this_time.t64;
+static void print_results(const std::vector<BenchResult>& results) {
+	printf("\n%-24s %-16s %12s %10s %10s %10s %12s %12s %12s\n", "benchmark", "corpus", "bytes", "fields", "reps", "GB/s", "cycles/byte", "allocs/rep", "ns/op");
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchResult& r = results[i];
+		printf("%-24s %-16s %12zu %10zu %10llu %10.3f %12.3f %12.1f %12.1f\n",
+			r.benchmark.c_str(), r.corpus.c_str(), r.bytes, r.fields, (unsigned long long)r.reps,
+			r.bytes / r.best_seconds / 1e9,
+			(double)r.best_cycles / r.bytes,
+			r.allocs_per_rep,
+			r.best_seconds * 1e9 / r.ops_per_rep);
 	}
+}
+
+#ifdef GON_USING_THREADS
+// Loading every file given on the command line, one after another and then all at once with gon_load_many
+static void bench_load_many(std::vector<BenchResult>& results, const std::vector<const char*>& paths) {
+	BenchResult r;
+	r.corpus      = "all files";
+	r.bytes       = 0;
+	r.fields      = 0;
+	r.ops_per_rep = paths.size();
+	std::vector<GonFile> out(paths.size());
+	GonLoadStats stats;
+	gon_load_many(&paths[0], (int)paths.size(), &out[0], 0, &stats);
+	for (size_t i = 0; i < out.size(); i++) gon_free(&out[i]);
+	r.bytes  = stats.bytes;
+	r.fields = stats.fields;
+
+	r.benchmark = "gon_load_file+parse";
+	BENCH_RUN(r, (void)0, for (size_t i = 0; i < paths.size(); i++) { out[i] = gon_create(); if (!gon_load_file(&out[i], paths[i])) gon_parse(&out[i]); gon_free(&out[i]); });
+	results.push_back(r);
+
+	r.benchmark = "gon_load_many";
+	BENCH_RUN(r, (void)0, gon_load_many(&paths[0], (int)paths.size(), &out[0], 0, &stats); for (size_t i = 0; i < out.size(); i++) gon_free(&out[i]));
+	results.push_back(r);
+	printf("gon_load_many: %d files (%d failed) on %d threads, %d stolen, sizing %.3fms, reading %.3fms and parsing %.3fms over all threads\n",
+		stats.files, stats.failed, stats.threads, stats.steals, stats.size_seconds * 1e3, stats.load_seconds * 1e3, stats.parse_seconds * 1e3);
+}
+#endif
 
-	printf("strlen timing report:\nsum time: %llu\navg time: %llu\nmin time: %llu\n", sum_time.t64, sum_time.t64 / reps, min_time.t64);
-	printf("len: %i\n\n", len);
+static const char* config_string(void) {
+	return ""
+	#ifdef GON_USING_SIMD
+	"simd "
+	#endif
+	#ifdef GON_USING_THREADS
+	"threads "
+	#endif
+	#ifdef GON_USING_INDEX
+	"index "
+	#endif
+	#ifdef GON_NON_DESTRUCTIVE
+	"non-destructive "
+	#endif
+	#ifdef GON_USING_COMPACT_FIELDS
+	"compact "
+	#endif
+	#ifdef GON_USING_RESERVED_FIELDS
+	"reserved "
+	#endif
+	#ifdef GON_USING_ATOMS
+	"atoms "
+	#endif
+	"";
+}
 
-	return sum_time.t64;
+static bool write_json(const char* path, const std::vector<BenchResult>& results) {
+	FILE* fp = fopen(path, "wb");
+	if (!fp) { perror(path); return false; }
+	fprintf(fp, "{\n  \"config\": \"%s\",\n  \"sizeof_gon_field\": %zu,\n  \"has_cycle_counter\": %s,\n  \"results\": [\n", config_string(), sizeof(GonField), bench_cycles() ? "true" : "false");
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchResult& r = results[i];
+		fprintf(fp, "    { \"benchmark\": \"%s\", \"corpus\": \"%s\", \"bytes\": %zu, \"fields\": %zu, \"reps\": %llu, "
+			"\"best_seconds\": %.9f, \"mean_seconds\": %.9f, \"gb_per_second\": %.6f, \"cycles_per_byte\": %.6f, "
+			"\"allocs_per_rep\": %.3f, \"alloc_bytes_per_rep\": %.1f, \"ops_per_rep\": %llu, \"ns_per_op\": %.3f }%s\n",
+			r.benchmark.c_str(), r.corpus.c_str(), r.bytes, r.fields, (unsigned long long)r.reps,
+			r.best_seconds, r.mean_seconds, r.bytes / r.best_seconds / 1e9, (double)r.best_cycles / r.bytes,
+			r.allocs_per_rep, r.alloc_bytes_per_rep, (unsigned long long)r.ops_per_rep, r.best_seconds * 1e9 / r.ops_per_rep,
+			i + 1 < results.size() ? "," : "");
+	}
+	fputs("  ]\n}\n", fp);
+	fclose(fp);
+	return true;
+}
+
+static bool write_csv(const char* path, const std::vector<BenchResult>& results) {
+	FILE* fp = fopen(path, "wb");
+	if (!fp) { perror(path); return false; }
+	fputs("benchmark,corpus,config,bytes,fields,reps,best_seconds,mean_seconds,gb_per_second,cycles_per_byte,allocs_per_rep,alloc_bytes_per_rep,ops_per_rep,ns_per_op\n", fp);
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchResult& r = results[i];
+		fprintf(fp, "%s,%s,%s,%zu,%zu,%llu,%.9f,%.9f,%.6f,%.6f,%.3f,%.1f,%llu,%.3f\n",
+			r.benchmark.c_str(), r.corpus.c_str(), config_string(), r.bytes, r.fields, (unsigned long long)r.reps,
+			r.best_seconds, r.mean_seconds, r.bytes / r.best_seconds / 1e9, (double)r.best_cycles / r.bytes,
+			r.allocs_per_rep, r.alloc_bytes_per_rep, (unsigned long long)r.ops_per_rep, r.best_seconds * 1e9 / r.ops_per_rep);
+	}
+	fclose(fp);
+	return true;
 }
 
-uint64_t time_ugon(const char* buffer, size_t size, uint64_t reps) {
+
+/*
+	Verification
+
+	--verify reads each corpus in every way the build supports, and checks that each one gives the same fields as gon_parse:
+	gon_parse_threaded, GonParser fed 1 and 7 bytes at a time, GonReader, gon_serialize (indented and minified) parsed back, gon_bake loaded with gon_load_baked,
+	and gon_reparse_range after a series of random edits, each checked against a full parse of the edited text.
+	With GON_USING_SIMD, the masks from the dispatched classifier are checked against gon_classify_blocks_scalar, and the main loop is run with the masks as well as without.
+	The corpora are the generated shapes, a hand-written file of awkward cases (escapes, UTF-8, brackets against names and values, empty containers, CRLF), seeded random documents, and any files on the command line.
+*/
+typedef struct VerifyField {
+	int  type;
+	int  parent;
+	int  size;				// for objects and arrays (and the root, where it is the total number of fields)
+	int  count;
+	bool has_name;
+	std::string name;		// with escapes removed
+	std::string value;
+} VerifyField;
+
+static int verify_checks   = 0;
+static int verify_failures = 0;
+
+static const char* verify_mixed =
+	"# escapes, quoting, UTF-8 and tight brackets\n"
+	"name \"Zoë Ångström\"\n"
+	"città Zürich\n"
+	"\"quoted name\" \"a \\\"quoted\\\" value\"\n"
+	"\"a\" b\n"
+	"emoji \"😀 {not} [an] #object\"\n"
+	"empty_object {}\n"
+	"empty_array []\n"
+	"list [ 1 2.5 -3 \"four\" { x 1 } [ a b ] {} [] ]\n"
+	"tight{a 1 b{c 2}d[3 4]}e \"\"\n"
+	"path \"back\\\\slash\" \"\\\"\" q\n"
+	"日本語 { キー 値 ключ значение ключ дубль }\n"
+	"crlf 1\r\n\tindented\t\"tab\"\r\n"
+	"multi \"line one\nline two\"\n"
+	"last value # trailing comment";
+
+static uint64_t verify_rng = 88172645463325252ull;
+
+static uint32_t verify_random(uint32_t n) {
+	verify_rng ^= verify_rng << 13;
+	verify_rng ^= verify_rng >> 7;
+	verify_rng ^= verify_rng << 17;
+	return (uint32_t)(verify_rng % n);
+}
+
+// Appends a random object or array body of up to 6 members, with nesting up to 4 levels deep
+static void verify_generate(std::string& out, int depth, bool in_array) {
+	int members = verify_random(6);
+	for (int i = 0; i < members; i++) {
+		if (!in_array) out += (verify_random(5) == 0 ? "\"n " + std::to_string(verify_random(9)) + "\"" : "k" + std::to_string(verify_random(12))) + " ";
+		uint32_t kind = depth < 4 ? verify_random(6) : 0;
+		if      (kind == 1) { out += "{ "; verify_generate(out, depth + 1, false); out += "} "; }
+		else if (kind == 2) { out += "[ "; verify_generate(out, depth + 1, true);  out += "] "; }
+		else if (verify_random(4) == 0) out += "\"v\\\"" + std::to_string(verify_random(99)) + "\" ";
+		else out += std::to_string(verify_random(999)) + " ";
+		if (verify_random(8) == 0) out += "# note }\n";
+	}
+}
+
+static void verify_fail(const char* corpus, const char* mode, const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	printf("FAIL %s: %s: ", corpus, mode);
+	vprintf(format, args);
+	putchar('\n');
+	va_end(args);
+	verify_failures++;
+}
+
+// Gives a fresh copy of the text that a GonFile can own, followed by a null as gon_parse requires
+static GonFile verify_file(const std::string& text) {
 	GonFile gon = gon_create();
-	char* buffer_copy = (char*)malloc(sizeof(char) * (size + 1L));
+	gon.file = (char*)malloc(text.size() + 1);
+	memcpy(gon.file, text.c_str(), text.size() + 1);
+	gon.file_length = text.size();
+	return gon;
+}
 
-	gon.file = buffer_copy;
-	gon.file_length = size;
+static std::string verify_string(const char* text, size_t length, bool escaped) {
+	std::string s(text, length);
+	if (escaped && length) s.resize(gon_unescape(&s[0], s.data(), s.size()));
+	return s;
+}
 
-	time_64 start_time, end_time, 
-		min_time = {.t64 = INT64_MAX}, 
-		sum_time = {.t64 = 0};
+// Flattens parsed fields, removing any escapes the mode has left in (as GON_NON_DESTRUCTIVE does)
+static std::vector<VerifyField> verify_dump(GonFile* gon) {
+	std::vector<VerifyField> out(gon->fields[0].size);
+	for (size_t i = 0; i < out.size(); i++) {
+		GonField*    field = &gon->fields[i];
+		VerifyField& f     = out[i];
+		f.type     = field->type;
+		f.parent   = field->parent;
+		f.size     = field->type == GON_TYPE_FIELD ? 0 : field->size;
+		f.count    = field->type == GON_TYPE_FIELD ? 0 : gon_count(field);
+		f.has_name = i && gon_name(field);
+		if (f.has_name) {
+			const char* name   = gon_name(field);		// unescapes in place, and clears the flag, unless the input is not to be modified
+			size_t      length = gon_name_length(field);
+			f.name = verify_string(name, length, field->flags & GON_FLAG_NAME_ESCAPED);
+		}
+		if (field->type == GON_TYPE_FIELD) {
+			const char* value  = gon_value(field);
+			size_t      length = gon_value_length(field);
+			f.value = verify_string(value, length, field->flags & GON_FLAG_VALUE_ESCAPED);
+		}
+	}
+	return out;
+}
 
-	for (int i = 0; i < reps; i++) {
-		memcpy(buffer_copy, buffer, sizeof(char) * (size + 1L));
+// Flattens the events from a GonReader the same way, working out each container's size and count from where it ends
+static bool verify_dump_reader(GonFile* gon, std::vector<VerifyField>* out) {
+	GonReader reader;
+	if (gon_reader_init(&reader, gon)) return false;
+	VerifyField root = { GON_TYPE_OBJECT, 0, 0, 0, false, "", "" };
+	out->assign(1, root);
+	std::vector<int> open(1, 0);
+	GonEvent event;
+	while ((event = gon_reader_next(&reader)) != GON_EVENT_EOF && event != GON_EVENT_ERROR) {
+		if (event == GON_EVENT_END) {
+			(*out)[open.back()].size = (int)out->size() - open.back() - 1;
+			open.pop_back();
+			continue;
+		}
+		VerifyField f = { event == GON_EVENT_FIELD ? GON_TYPE_FIELD : event == GON_EVENT_BEGIN_ARRAY ? GON_TYPE_ARRAY : GON_TYPE_OBJECT, open.back(), 0, 0, reader.name != NULL, "", "" };
+		#ifdef GON_NON_DESTRUCTIVE
+		bool name_escaped = reader.name_escaped, value_escaped = reader.value_escaped;
+		#else
+		bool name_escaped = false, value_escaped = false;
+		#endif
+		if (reader.name) f.name = verify_string(reader.name, reader.name_length, name_escaped);
+		if (event == GON_EVENT_FIELD) f.value = verify_string(reader.value, reader.value_length, value_escaped);
+		(*out)[open.back()].count++;
+		out->push_back(f);
+		if (event != GON_EVENT_FIELD) open.push_back((int)out->size() - 1);
+	}
+	gon_reader_free(&reader);
+	(*out)[0].size = (int)out->size();
+	return event == GON_EVENT_EOF && open.size() == 1;
+}
 
-		start_timer(start_time.t32_low, start_time.t32_high);
-		gon_parse(&gon);
-		stop_timer(end_time.t32_low, end_time.t32_high);
+static void verify_same(const char* corpus, const char* mode, const std::vector<VerifyField>& want, const std::vector<VerifyField>& got) {
+	verify_checks++;
+	if (want.size() != got.size()) {
+		verify_fail(corpus, mode, "%zu fields, expected %zu", got.size(), want.size());
+		return;
+	}
+	for (size_t i = 0; i < want.size(); i++) {
+		const VerifyField& a = want[i];
+		const VerifyField& b = got[i];
+		if (a.type != b.type || a.parent != b.parent || a.size != b.size || a.count != b.count)
+			verify_fail(corpus, mode, "field %zu has type %d, parent %d, size %d, count %d, expected %d, %d, %d, %d", i, b.type, b.parent, b.size, b.count, a.type, a.parent, a.size, a.count);
+		else if (a.has_name != b.has_name || a.name != b.name)
+			verify_fail(corpus, mode, "field %zu is named \"%s\", expected \"%s\"", i, b.name.c_str(), a.name.c_str());
+		else if (a.value != b.value)
+			verify_fail(corpus, mode, "field %zu has value \"%s\", expected \"%s\"", i, b.value.c_str(), a.value.c_str());
+		else continue;
+		return;
+	}
+}
+
+// Checks what verify_dump() leaves out, for files parsed from the same text as the expected one: the plain flags, atom keys, and which child each name finds (through the index, if there is one)
+static void verify_same_lookups(const char* corpus, const char* mode, GonFile* want, GonFile* got) {
+	verify_checks++;
+	int count = want->fields[0].size;
+	if (got->fields[0].size != count) return;			// already reported by verify_same()
+	for (int i = 0; i < count; i++) {
+		GonField* a = &want->fields[i];
+		GonField* b = &got->fields[i];
+		if ((a->flags ^ b->flags) & (GON_FLAG_NAME_PLAIN | GON_FLAG_VALUE_PLAIN)) {
+			verify_fail(corpus, mode, "field %d has flags %d, expected %d", i, b->flags, a->flags);
+			return;
+		}
+		#ifdef GON_USING_ATOMS
+		if (a->key != b->key) {
+			verify_fail(corpus, mode, "field %d has key %u, expected %u", i, b->key, a->key);
+			return;
+		}
+		#endif
+		if (a->type != GON_TYPE_OBJECT) continue;
+		GonField* child = a + 1;
+		for (int c = gon_count(a); c > 0; c--) {
+			const char* name   = gon_name(child);
+			size_t      length = gon_name_length(child);
+			if (child->flags & GON_FLAG_NAME_ESCAPED) {		// still escaped (as with GON_NON_DESTRUCTIVE), so only found by the same text, which GonParser has already unescaped
+				child += child->type == GON_TYPE_FIELD ? 1 : child->size + 1;
+				continue;
+			}
+			GonField* found_a = gon_find_child(a, name, length, 0);
+			GonField* found_b = gon_find_child(b, name, length, 0);
+			if (!found_a || !found_b || found_a - want->fields != found_b - got->fields) {
+				verify_fail(corpus, mode, "looking up \"%.*s\" in field %d found field %d, expected %d", (int)length, name, i, found_b ? (int)(found_b - got->fields) : -1, found_a ? (int)(found_a - want->fields) : -1);
+				return;
+			}
+			child += child->type == GON_TYPE_FIELD ? 1 : child->size + 1;
+		}
+	}
+}
+
+#if defined(GON_USING_DYNAMIC_BUFFER) && !defined(GON_USING_COMPACT_FIELDS)
+#ifdef GON_USING_INDEX
+static void verify_index_objects(GonFile* gon) {
+	for (int i = 0; i < gon->fields[0].size; i++)
+		if (gon->fields[i].type == GON_TYPE_OBJECT && gon_count(&gon->fields[i])) gon_index_object(&gon->fields[i]);
+}
+#endif
 
-		time_64 this_time;
-		this_time.t64 = end_time.t64 - start_time.t64;
-		sum_time.t64 += this_time.t64;
-		if (this_time.t64 < min_time.t64) min_time.t64 = this_time.t64;
+// Edits the text at random, bringing the parse up to date with gon_reparse_range after each edit and checking it against a full parse
+static void verify_reparse(const char* corpus, const std::string& original, int edits) {
+	static const char* pieces[] = { "a", "key", "\"q x\"", "\"e\\\"s\"", "1", "2.5", "#c\n", "\n", " ", "{", "}", "[", "]", "\"", "ü", "\"\"", "x{y 1}", "[1 2]", "{}", "[]" };
+	std::string text = original;
+	GonFile gon = verify_file(text);
+	if (gon_parse(&gon)) {
+		gon_free(&gon);
+		return;
 	}
+	#ifdef GON_USING_INDEX
+	verify_index_objects(&gon);
+	#endif
+	for (int e = 0; e < edits; e++) {
+		std::string next = text;
+		size_t at  = verify_random((uint32_t)next.size() + 1);
+		size_t cut = verify_random(4) ? verify_random(6) : 0;
+		if (at + cut > next.size()) cut = next.size() - at;
+		std::string put;
+		for (int k = verify_random(3); k > 0; k--) put += pieces[verify_random(sizeof(pieces) / sizeof(pieces[0]))];
+		if (verify_random(3) == 0 && at + put.size() <= next.size()) cut = put.size();		// same length, which reparses in place
+		next.replace(at, cut, put);
 
-	printf("ugon timing report:\nsum time: %llu\navg time: %llu\nmin time: %llu\n\n", sum_time.t64, sum_time.t64 / reps, min_time.t64);
+		// the range is everything between the common prefix and the common suffix
+		size_t prefix = 0, suffix = 0, shorter = next.size() < text.size() ? next.size() : text.size();
+		while (prefix < shorter && next[prefix] == text[prefix]) prefix++;
+		while (suffix < shorter - prefix && next[next.size() - 1 - suffix] == text[text.size() - 1 - suffix]) suffix++;
 
+		GonFile want = verify_file(next);
+		bool valid = !gon_parse(&want);
+		GonFile edited = verify_file(next);
+		int result = gon_reparse_range(&gon, &edited, prefix, next.size() - suffix, NULL);
+		verify_checks++;
+		if (result != !valid) verify_fail(corpus, "gon_reparse_range", "edit %d returned %d where gon_parse returned %d", e, result, !valid);
+		else if (valid) {
+			verify_same(corpus, "gon_reparse_range", verify_dump(&want), verify_dump(&gon));
+			verify_same_lookups(corpus, "gon_reparse_range", &want, &gon);
+			text = next;
+		}
+		if (result) gon_free(&edited);
+		gon_free(&want);
+	}
 	gon_free(&gon);
-
-	return sum_time.t64;
 }
+#endif
+
+static void verify_corpus(const char* corpus, const std::string& text) {
+	GonFile want = verify_file(text);
+	if (gon_parse(&want)) {
+		printf("skipping corpus %s: parse failed\n", corpus);
+		gon_free(&want);
+		return;
+	}
+	std::vector<VerifyField> expected = verify_dump(&want);
 
-uint64_t time_gon(const char* buffer, uint64_t reps) {
-	time_64 start_time, end_time, 
-		min_time = {.t64 = INT64_MAX}, 
-		sum_time = {.t64 = 0};
+	#ifdef GON_USING_SIMD
+	{
+		size_t size = gon_classify_size(text.size());
+		uint64_t* fast = gon_classify(text.c_str(), text.size(), gon_classify_dispatch(), NULL);
+		uint64_t* slow = gon_classify(text.c_str(), text.size(), gon_classify_blocks_scalar, NULL);
+		verify_checks++;
+		if (fast && slow && memcmp(fast, slow, size)) verify_fail(corpus, "gon_classify", "masks differ from gon_classify_blocks_scalar");
+		free(slow);
 
-	std::string str(buffer);
+		// gon_parse leaves the masks out for structure-dense input, so run the main loop with them here
+		GonFile got = verify_file(text);
+		GonScanner scan;
+		memset(&scan, 0, sizeof(scan));
+		scan.file  = got.file;
+		scan.last  = got.file + got.file_length;
+		scan.masks = fast;
+		if (gon_parse_scanned(&got, &scan)) verify_fail(corpus, "masked gon_parse", "parse failed");
+		else {
+			verify_same(corpus, "masked gon_parse", expected, verify_dump(&got));
+			verify_same_lookups(corpus, "masked gon_parse", &want, &got);
+		}
+		free(fast);
+		gon_free(&got);
+	}
+	#endif
 
-	for (int i = 0; i < reps; i++) {
-		std::string string_copy = str;
-		start_timer(start_time.t32_low, start_time.t32_high);
-		GonObject gon = GonObject::LoadFromBuffer(string_copy);
-		stop_timer(end_time.t32_low, end_time.t32_high);
+	#ifdef GON_USING_THREADS
+	{
+		GonFile got = verify_file(text);
+		if (gon_parse_threaded(&got, 8)) verify_fail(corpus, "gon_parse_threaded", "parse failed");
+		else {
+			verify_same(corpus, "gon_parse_threaded", expected, verify_dump(&got));
+			verify_same_lookups(corpus, "gon_parse_threaded", &want, &got);
+		}
+		gon_free(&got);
+	}
+	#endif
+
+	static const size_t feed_sizes[] = { 1, 7 };
+	for (size_t s = 0; s < sizeof(feed_sizes) / sizeof(feed_sizes[0]); s++) {
+		char mode[32];
+		snprintf(mode, sizeof(mode), "GonParser by %zu", feed_sizes[s]);
+		GonParser parser = gon_parser_create();
+		bool failed = false;
+		for (size_t o = 0; o < text.size() && !failed; o += feed_sizes[s])
+			failed = gon_parser_feed(&parser, text.c_str() + o, text.size() - o < feed_sizes[s] ? text.size() - o : feed_sizes[s]) != 0;
+		if (failed || gon_parser_finish(&parser)) verify_fail(corpus, mode, "parse failed");
+		else {
+			verify_same(corpus, mode, expected, verify_dump(&parser.gon));
+			verify_same_lookups(corpus, mode, &want, &parser.gon);
+		}
+		gon_free(&parser.gon);
+	}
+
+	{
+		GonFile got = verify_file(text);
+		std::vector<VerifyField> events;
+		if (!verify_dump_reader(&got, &events)) verify_fail(corpus, "GonReader", "read failed");
+		else verify_same(corpus, "GonReader", expected, events);
+		gon_free(&got);
+	}
 
-		time_64 this_time;
-		this_time.t64 = end_time.t64 - start_time.t64;
-		sum_time.t64 += this_time.t64;
-		if (this_time.t64 < min_time.t64) min_time.t64 = this_time.t64;
+	static const int tab_widths[] = { 2, GON_MINIFIED };
+	for (size_t t = 0; t < sizeof(tab_widths) / sizeof(tab_widths[0]); t++) {
+		const char* mode = tab_widths[t] == GON_MINIFIED ? "gon_serialize minified" : "gon_serialize";
+		std::string out(gon_serialized_size(&want, tab_widths[t]), '\0');
+		gon_serialize_n(&want, &out[0], out.size() + 1, tab_widths[t]);
+		GonFile got = verify_file(out);
+		if (gon_parse(&got)) verify_fail(corpus, mode, "output does not parse");
+		else verify_same(corpus, mode, expected, verify_dump(&got));
+		gon_free(&got);
 	}
 
-	printf("gon timing report:\nsum time: %llu\navg time: %llu\nmin time: %llu\n\n", sum_time.t64, sum_time.t64 / reps, min_time.t64);
+	{
+		const char* path = "ugon_verify.gonb";
+		GonFile got = gon_create();
+		if (gon_bake(&want, path) || gon_load_baked(&got, path)) verify_fail(corpus, "gon_load_baked", "bake or load failed");
+		else verify_same(corpus, "gon_load_baked", expected, verify_dump(&got));
+		gon_free(&got);
+		got = gon_create();
+		if (gon_load_baked_verified(&got, path)) verify_fail(corpus, "gon_load_baked_verified", "load failed");
+		else verify_same(corpus, "gon_load_baked_verified", expected, verify_dump(&got));
+		gon_free(&got);
 
-	return sum_time.t64;
+		// points the last record's parent past the end, which both loaders must refuse
+		size_t last = (size_t)want.fields[0].size - 1;
+		unsigned int bits = 1000000u | (unsigned int)GON_TYPE_FIELD << 30;
+		FILE* fp = last ? fopen(path, "r+b") : NULL;
+		if (fp && fseek(fp, (long)(GON_BAKED_FIELDS_OFFSET + last * sizeof(GonBakedField) + sizeof(unsigned int)), SEEK_SET) == 0 && fwrite(&bits, sizeof(bits), 1, fp) == 1) {
+			fclose(fp);
+			got = gon_create();
+			if (!gon_load_baked_verified(&got, path)) verify_fail(corpus, "gon_load_baked_verified", "damaged record was accepted");
+			gon_free(&got);
+			#ifndef GON_USING_COMPACT_FIELDS
+			got = gon_create();
+			if (!gon_load_baked(&got, path)) verify_fail(corpus, "gon_load_baked", "damaged record was accepted");
+			gon_free(&got);
+			#endif
+		}
+		else if (fp) fclose(fp);
+		remove(path);
+	}
+
+	#if defined(GON_USING_DYNAMIC_BUFFER) && !defined(GON_USING_COMPACT_FIELDS)
+	verify_reparse(corpus, text, text.size() > 65536 ? 4 : 40);
+	#endif
+
+	gon_free(&want);
 }
 
-uint64_t time_rapidxml(char* buffer, size_t size, uint64_t reps) {
-	using namespace rapidxml;
+static int verify(const std::vector<const char*>& files) {
+	printf("uGON verification (config: %s)\n", config_string());
+	for (size_t i = 0; i < sizeof(corpus_shapes) / sizeof(corpus_shapes[0]); i++) {
+		std::string name = std::string(corpus_shapes[i].name) + "/200k";
+		verify_corpus(name.c_str(), build_corpus(corpus_shapes[i].proc, 200 * 1024));
+	}
+	verify_corpus("mixed", verify_mixed);
+	for (int i = 0; i < 200; i++) {
+		std::string text = "doc { ";
+		verify_generate(text, 0, false);
+		verify_generate(text, 0, false);
+		text += "} tail 1";
+		char name[32];
+		snprintf(name, sizeof(name), "random/%d", i);
+		verify_corpus(name, text);
+	}
+	for (size_t f = 0; f < files.size(); f++) {
+		char* text;
+		size_t size;
+		if (!read_text_file(files[f], &text, &size)) return 1;
+		verify_corpus(files[f], std::string(text, size));
+		free(text);
+	}
+	printf("%d checks, %d failed\n", verify_checks, verify_failures);
+	return verify_failures != 0;
+}
 
-	char* buffer_copy = (char*)malloc(sizeof(char) * (size + 1L));;
 
-	time_64 start_time, end_time, 
-		min_time = {.t64 = INT64_MAX}, 
-		sum_time = {.t64 = 0};
+/*
+	Original tests, comparing against strlen and (if available) rapidxml and the original GON parser
+*/
 
-	for (int i = 0; i < reps; i++) {
-		memcpy(buffer_copy, buffer, sizeof(char) * (size + 1L));
-		xml_document<> doc;
-		start_timer(start_time.t32_low, start_time.t32_high);
-		doc.parse<0>(buffer_copy);
-		stop_timer(end_time.t32_low, end_time.t32_high);
+void gon_test(void) {
+	GonFile gon = gon_create();
+	if (gon_load_file(&gon, "test.gon")) return;
+	gon_parse(&gon);
+
+	size_t size = gon_serialized_size(&gon, 2) + 1;
+	char* buf = (char*)malloc(size);
+	gon_serialize_n(&gon, buf, size, 2);
+
+	puts(buf);
+
+	free(buf);
+	gon_free(&gon);
+}
 
-		time_64 this_time;
-		this_time.t64 = end_time.t64 - start_time.t64;
-		sum_time.t64 += this_time.t64;
-		if (this_time.t64 < min_time.t64) min_time.t64 = this_time.t64;
+static double time_strlen(const char* buffer, uint64_t reps) {
+	size_t len = 0;
+	double t0 = bench_seconds();
+	for (uint64_t i = 0; i < reps; i++) {
+		len += strlen(buffer);
+		buffer += (len == 0);	// keeps the compiler from hoisting strlen out of the loop
 	}
+	double sum = bench_seconds() - t0;
+	printf("strlen timing report:\nsum time: %f\navg time: %e\nlen: %zu\n\n", sum, sum / reps, (size_t)(len / reps));
+	return sum;
+}
 
-	free(buffer_copy);
+static double time_ugon(const char* buffer, size_t size, uint64_t reps) {
+	GonFile gon = gon_create();
+	char* buffer_copy = (char*)malloc(sizeof(char) * (size + 1L));
+	gon.file = buffer_copy;
+	gon.file_length = size;
 
-	printf("rapidxml timing report:\nsum time: %llu\navg time: %llu\nmin time: %llu\n", sum_time.t64, sum_time.t64 / reps, min_time.t64);
+	double sum = 0, min = 1e300;
+	for (uint64_t i = 0; i < reps; i++) {
+		memcpy(buffer_copy, buffer, sizeof(char) * (size + 1L));
+		double t0 = bench_seconds();
+		gon_parse(&gon);
+		double t = bench_seconds() - t0;
+		sum += t;
+		if (t < min) min = t;
+	}
 
-	return sum_time.t64;
+	printf("ugon timing report:\nsum time: %f\navg time: %e\nmin time: %e\n\n", sum, sum / reps, min);
+	gon_free(&gon);
+	return sum;
 }
 
+#ifdef UGON_BENCH_GON
+static double time_gon(const char* buffer, uint64_t reps) {
+	std::string str(buffer);
+	double sum = 0, min = 1e300;
+	for (uint64_t i = 0; i < reps; i++) {
+		std::string string_copy = str;
+		double t0 = bench_seconds();
+		GonObject gon = GonObject::LoadFromBuffer(string_copy);
+		double t = bench_seconds() - t0;
+		sum += t;
+		if (t < min) min = t;
+	}
+	printf("gon timing report:\nsum time: %f\navg time: %e\nmin time: %e\n\n", sum, sum / reps, min);
+	return sum;
+}
+#endif
 
-void speed_test(void) {
-	printf("sizeof(GonField): %llu\n\n", sizeof(GonField));
+#ifdef UGON_BENCH_RAPIDXML
+static double time_rapidxml(char* buffer, size_t size, uint64_t reps) {
+	using namespace rapidxml;
+	char* buffer_copy = (char*)malloc(sizeof(char) * (size + 1L));
+	double sum = 0, min = 1e300;
+	for (uint64_t i = 0; i < reps; i++) {
+		memcpy(buffer_copy, buffer, sizeof(char) * (size + 1L));
+		xml_document<> doc;
+		double t0 = bench_seconds();
+		doc.parse<0>(buffer_copy);
+		double t = bench_seconds() - t0;
+		sum += t;
+		if (t < min) min = t;
+	}
+	free(buffer_copy);
+	printf("rapidxml timing report:\nsum time: %f\navg time: %e\nmin time: %e\n\n", sum, sum / reps, min);
+	return sum;
+}
+#endif
 
-	int reps = 10000000;
-	int len = 0;
+void speed_test(const char* gon_path, const char* xml_path) {
+	printf("sizeof(GonField): %zu\n\n", sizeof(GonField));
 
 	char* buffer;
 	size_t size;
-	read_text_file("test.gon", &buffer, &size);
-	buffer[size] = 0;
-	int gon_len = size;
+	if (!read_text_file(gon_path, &buffer, &size)) return;
+	size_t gon_len = size;
 
-	uint64_t strlen_sum_time = time_strlen(buffer, size, reps);
-
-	//uint64_t gon_sum_time = time_gon(buffer, reps);
-
-	uint64_t ugon_sum_time = time_ugon(buffer, size, reps);
-	free(buffer);
+	// a million reps of test.gon, and about the same total number of bytes for larger files
+	uint64_t reps = 1000000;
+	if (size > 1000) reps = 1000000000 / size;
+	if (reps < 3)    reps = 3;
 
-	read_text_file("test.xml", &buffer, &size);
-	buffer[size] = 0;
-	int xml_len = size;
-	uint64_t rapidxml_sum_time = time_rapidxml(buffer, size, reps);
+	double strlen_sum_time = time_strlen(buffer, reps);
+	double ugon_sum_time   = time_ugon(buffer, size, reps);
+	#ifdef UGON_BENCH_GON
+	double gon_sum_time    = time_gon(buffer, reps);
+	#endif
 	free(buffer);
 
 	puts("\nTiming ratios:");
-	printf("ugon time     /  strlen time: %f\n", (double)ugon_sum_time     / (double)strlen_sum_time);
-	//printf(" gon time     /  ugon time: %f\n",   (double)gon_sum_time      / (double)ugon_sum_time);
-	printf("rapidxml time /  ugon time: %f\n",   (double)rapidxml_sum_time / (double)ugon_sum_time);
-	
+	printf("ugon time     /  strlen time: %f\n", ugon_sum_time / strlen_sum_time);
+	#ifdef UGON_BENCH_GON
+	printf(" gon time     /  ugon time: %f\n",   gon_sum_time / ugon_sum_time);
+	#endif
+
+	#ifdef UGON_BENCH_RAPIDXML
+	if (read_text_file(xml_path, &buffer, &size)) {
+		size_t xml_len = size;
+		double rapidxml_sum_time = time_rapidxml(buffer, size, reps);
+		free(buffer);
+		printf("rapidxml time /  ugon time: %f\n", rapidxml_sum_time / ugon_sum_time);
+		printf("   xml time / xml len: %e\n", (rapidxml_sum_time / reps) / xml_len);
+	}
+	#endif
+
 	puts("\nTime spent per character:");
-	printf("strlen time / gon len: %f\n", ((double)strlen_sum_time   / (double)reps) / (double)gon_len);
-	//printf("   gon time / gon len: %f\n", ((double)gon_sum_time      / (double)reps) / (double)gon_len);
-	printf("  ugon time / gon len: %f\n", ((double)ugon_sum_time     / (double)reps) / (double)gon_len);
-	printf("   xml time / xml len: %f\n", ((double)rapidxml_sum_time / (double)reps) / (double)xml_len);
+	printf("strlen time / gon len: %e\n", (strlen_sum_time / reps) / gon_len);
+	printf("  ugon time / gon len: %e\n", (ugon_sum_time   / reps) / gon_len);
+}
 
-	puts("\nFile Lengths:");
-	printf("gon_len: %i\n", gon_len);
-	printf("xml_len: %i\n", xml_len);
+
+static size_t parse_size(const char* s) {
+	char* end;
+	double value = strtod(s, &end);
+	switch (*end) {
+		case 'k': case 'K': value *= 1024; break;
+		case 'm': case 'M': value *= 1024 * 1024; break;
+		case 'g': case 'G': value *= 1024.0 * 1024 * 1024; break;
+	}
+	return (size_t)value;
 }
 
-int main(void) {
-	gon_test();
-	speed_test();
+static std::vector<std::string> split_list(const char* s) {
+	std::vector<std::string> list;
+	std::string item;
+	for (; ; s++) {
+		if (*s == ',' || *s == 0) {
+			if (!item.empty()) list.push_back(item);
+			item.clear();
+			if (*s == 0) break;
+		}
+		else item += *s;
+	}
+	return list;
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> sizes  = split_list("4k,256k,16m");
+	std::vector<std::string> shapes = split_list("nested,wide,numeric,strings");
+	std::vector<const char*> files;
+	const char* json_path = NULL;
+	const char* csv_path  = NULL;
+	bool run_speed_test = false;
+	bool many = false;
+	bool run_verify = false;
+	const char* speed_gon_path = "test.gon";
+	const char* speed_xml_path = "test.xml";
+
+	for (int i = 1; i < argc; i++) {
+		bool has_value = i + 1 < argc;
+		if      (!strcmp(argv[i], "--sizes")  && has_value) sizes  = split_list(argv[++i]);
+		else if (!strcmp(argv[i], "--shapes") && has_value) shapes = split_list(argv[++i]);
+		else if (!strcmp(argv[i], "--time")   && has_value) bench_min_time = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--json")   && has_value) json_path = argv[++i];
+		else if (!strcmp(argv[i], "--csv")    && has_value) csv_path  = argv[++i];
+		else if (!strcmp(argv[i], "--speed-test")) run_speed_test = true;
+		else if (!strcmp(argv[i], "--many")) many = true;
+		else if (!strcmp(argv[i], "--verify")) run_verify = true;
+		else if (!strcmp(argv[i], "--speed-gon") && has_value) run_speed_test = true, speed_gon_path = argv[++i];
+		else if (!strcmp(argv[i], "--speed-xml") && has_value) run_speed_test = true, speed_xml_path = argv[++i];
+		else if (argv[i][0] == '-') {
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 1;
+		}
+		else files.push_back(argv[i]);
+	}
+
+	if (run_verify) return verify(files);
+
+	if (run_speed_test) {
+		if (!strcmp(speed_gon_path, "test.gon")) gon_test();
+		speed_test(speed_gon_path, speed_xml_path);
+		return 0;
+	}
+
+	printf("uGON benchmark (config: %s, sizeof(GonField): %zu)\n", config_string(), sizeof(GonField));
+
+	std::vector<BenchResult> results;
+	for (size_t s = 0; s < shapes.size(); s++) {
+		const CorpusShape* shape = NULL;
+		for (size_t i = 0; i < sizeof(corpus_shapes) / sizeof(corpus_shapes[0]); i++)
+			if (shapes[s] == corpus_shapes[i].name) shape = &corpus_shapes[i];
+		if (!shape) {
+			fprintf(stderr, "unknown shape %s\n", shapes[s].c_str());
+			return 1;
+		}
+		for (size_t z = 0; z < sizes.size(); z++) {
+			std::string corpus = build_corpus(shape->proc, parse_size(sizes[z].c_str()));
+			std::string name   = shapes[s] + "/" + sizes[z];
+			printf("running %s (%zu bytes)\n", name.c_str(), corpus.size());
+			bench_corpus(results, name.c_str(), corpus.c_str(), corpus.size());
+		}
+	}
+	for (size_t f = 0; f < files.size() && !many; f++) {
+		char* text;
+		size_t size;
+		if (!read_text_file(files[f], &text, &size)) return 1;
+		printf("running %s (%zu bytes)\n", files[f], size);
+		bench_corpus(results, files[f], text, size);
+		bench_file_load(results, files[f], size);
+		free(text);
+	}
+	#ifdef GON_USING_THREADS
+	if (many && !files.empty()) bench_load_many(results, files);
+	#endif
+
+	print_results(results);
+	if (json_path && !write_json(json_path, results)) return 1;
+	if (csv_path  && !write_csv(csv_path, results))   return 1;
 	return 0;
-}
\ No newline at end of file
+}
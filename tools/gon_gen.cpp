@@ -0,0 +1,565 @@
+/*
+	uGON corpus generator
+
+	Writes a pseudo-random GON document of (roughly) the requested size, and optionally an equivalent XML and/or JSON document.
+	The same seed and options always produce the same output, so corpora can be regenerated rather than checked in.
+
+	Usage: gon_gen [options] out.gon
+		--seed      N        seed for the random number generator (default 1)
+		--size      64m      stop once the GON output reaches this many bytes (k/m/g suffixes)
+		--preset    name     starting point for the options below (mixed, flat, records, numeric, strings, deep)
+		--depth     N        maximum object / array nesting depth below each record
+		--fanout    N        average number of children per object
+		--objects   P        probability that a child is an object
+		--arrays    P        probability that a child is an array
+		--array-objects P    probability that an array holds objects rather than values
+		--array-length N     average number of values in an array
+		--numeric   P        probability that a value is a number
+		--quoted    P        probability that a string value is quoted (names are quoted at a quarter of this rate)
+		--escapes   P        probability that a quoted string contains escape sequences
+		--comments  P        probability of a comment line before each field
+		--blobs     P        probability that a value is a long string blob
+		--blob-size N        average length of a blob
+		--tab-width N        indentation per level (0 for none)
+		--xml       out.xml  also write an equivalent XML document
+		--json      out.json also write an equivalent JSON document
+
+	The GON document is a list of records (record_0, record_1, ...) at the root, each of which is an object generated from the options above.
+	In the XML twin, every field becomes an element, array values become <item> elements, and characters that are not valid in an element name become '_'.
+	In the JSON twin, the root becomes an object, numbers are written as numbers and every other value as a string. JSON has no comments, so those are dropped.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*
+	Random numbers
+
+	splitmix64, so that the output only depends on the seed and not on the platform's rand().
+*/
+
+typedef struct GenRandom {
+	uint64_t state;
+} GenRandom;
+
+static inline uint64_t gen_next(GenRandom* r) {
+	uint64_t z = (r->state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+// uniform in [0, 1)
+static inline double gen_unit(GenRandom* r) {
+	return (gen_next(r) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static inline bool gen_chance(GenRandom* r, double p) {
+	return gen_unit(r) < p;
+}
+
+// uniform in [lo, hi]
+static inline int gen_range(GenRandom* r, int lo, int hi) {
+	return lo + (int)(gen_next(r) % (uint64_t)(hi - lo + 1));
+}
+
+// somewhere between half and one and a half times average
+static inline int gen_around(GenRandom* r, int average) {
+	if (average <= 1) return average;
+	return gen_range(r, average / 2, average + average / 2);
+}
+
+
+/*
+	Output
+
+	Each document is written through its own buffer, so that multi-gigabyte outputs never have to be held in memory.
+*/
+
+#define GEN_BUFFER_SIZE (1 << 16)
+
+typedef struct GenWriter {
+	FILE*  fp;
+	char*  buffer;
+	size_t length;
+	size_t total;		// bytes written so far, including those still in the buffer
+} GenWriter;
+
+static void gen_flush(GenWriter* w) {
+	if (w->fp && w->length) fwrite(w->buffer, 1, w->length, w->fp);
+	w->length = 0;
+}
+
+static void gen_write(GenWriter* w, const char* s, size_t length) {
+	if (!w->fp) return;
+	w->total += length;
+	if (w->length + length > GEN_BUFFER_SIZE) {
+		gen_flush(w);
+		if (length > GEN_BUFFER_SIZE) {
+			fwrite(s, 1, length, w->fp);
+			return;
+		}
+	}
+	memcpy(w->buffer + w->length, s, length);
+	w->length += length;
+}
+
+static inline void gen_puts(GenWriter* w, const char* s) {
+	gen_write(w, s, strlen(s));
+}
+
+static inline void gen_putc(GenWriter* w, char c) {
+	gen_write(w, &c, 1);
+}
+
+static void gen_indent(GenWriter* w, int depth, int tab_width) {
+	for (int i = 0; i < depth * tab_width; i++) gen_putc(w, ' ');
+}
+
+static bool gen_open(GenWriter* w, const char* path) {
+	memset(w, 0, sizeof(GenWriter));
+	if (!path) return true;
+	w->fp = fopen(path, "wb");
+	if (!w->fp) { perror(path); return false; }
+	w->buffer = (char*)malloc(GEN_BUFFER_SIZE);
+	return true;
+}
+
+static void gen_close(GenWriter* w) {
+	gen_flush(w);
+	if (w->fp) fclose(w->fp);
+	free(w->buffer);
+}
+
+
+/*
+	Options
+*/
+
+typedef struct GenOptions {
+	uint64_t seed;
+	size_t size;
+	int    depth;
+	int    fanout;
+	double objects;
+	double arrays;
+	double array_objects;
+	int    array_length;
+	double numeric;
+	double quoted;
+	double escapes;
+	double comments;
+	double blobs;
+	int    blob_size;
+	int    tab_width;
+} GenOptions;
+
+typedef struct GenPreset {
+	const char* name;
+	GenOptions  options;
+} GenPreset;
+
+//                                      seed size      depth fanout objects arrays array_objects array_length numeric quoted escapes comments blobs blob_size tab_width
+static const GenPreset gen_presets[] = {
+	{ "mixed",   {  1, 1 << 20,  4,    8,    0.20,   0.10,  0.30,         16,          0.40,   0.30,  0.10,   0.05,    0.01, 4096,     2 } },
+	{ "flat",    {  1, 1 << 20,  1,    64,   0.00,   0.00,  0.00,         0,           0.50,   0.20,  0.05,   0.00,    0.00, 0,        2 } },
+	{ "records", {  1, 1 << 20,  3,    6,    0.00,   1.00,  1.00,         64,          0.50,   0.30,  0.05,   0.00,    0.00, 0,        2 } },
+	{ "numeric", {  1, 1 << 20,  2,    4,    0.00,   1.00,  0.00,         256,         1.00,   0.00,  0.00,   0.00,    0.00, 0,        2 } },
+	{ "strings", {  1, 1 << 20,  1,    8,    0.00,   0.00,  0.00,         0,           0.00,   1.00,  0.30,   0.00,    0.50, 16384,    2 } },
+	{ "deep",    {  1, 1 << 20,  32,   4,    0.25,   0.00,  0.00,         0,           0.40,   0.30,  0.10,   0.05,    0.00, 0,        2 } },
+};
+
+static const GenPreset* gen_find_preset(const char* name) {
+	for (size_t i = 0; i < sizeof(gen_presets) / sizeof(gen_presets[0]); i++)
+		if (strcmp(gen_presets[i].name, name) == 0) return &gen_presets[i];
+	return NULL;
+}
+
+
+/*
+	Generation
+
+	Every value is generated once into a scratch buffer and then written to each document in its own syntax.
+	For strings, the scratch buffer holds the raw characters, and each writer does its own quoting and escaping.
+*/
+
+typedef struct GenState {
+	GenOptions* options;
+	GenRandom   random;
+	GenWriter   gon, xml, json;
+	char*       scratch;
+	size_t      scratch_capacity;
+	bool*       json_first;		// per depth, true until the first child of the current JSON object or array has been written
+} GenState;
+
+static const char* gen_words[] = {
+	"alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel", "india", "juliet", "kilo", "lima",
+	"mike", "november", "oscar", "papa", "quebec", "romeo", "sierra", "tango", "uniform", "victor", "whiskey", "xray",
+	"yankee", "zulu", "name", "position", "velocity", "sprite", "color", "scale", "layer", "enabled", "speed", "id",
+};
+#define GEN_WORD_COUNT (sizeof(gen_words) / sizeof(gen_words[0]))
+
+// characters which are only allowed inside of quotes, and which make a string need them
+static const char gen_quoted_chars[] = " ,{}[]#\t";
+
+static void gen_reserve(GenState* g, size_t length) {
+	if (length <= g->scratch_capacity) return;
+	while (g->scratch_capacity < length) g->scratch_capacity = g->scratch_capacity ? g->scratch_capacity * 2 : 256;
+	g->scratch = (char*)realloc(g->scratch, g->scratch_capacity);
+}
+
+// Generates a string into the scratch buffer and returns its length
+// Naked strings are made of word characters only, quoted strings may contain anything the parser accepts inside of quotes
+static size_t gen_string(GenState* g, bool quoted, bool escapes, int length) {
+	gen_reserve(g, length + 64);
+	size_t n = 0;
+	while ((int)n < length) {
+		const char* word = gen_words[gen_next(&g->random) % GEN_WORD_COUNT];
+		size_t word_length = strlen(word);
+		memcpy(g->scratch + n, word, word_length);
+		n += word_length;
+		if ((int)n >= length) break;
+		if (!quoted)                              g->scratch[n++] = '_';
+		else if (escapes && gen_chance(&g->random, 0.25)) g->scratch[n++] = "\"\\\n\t"[gen_next(&g->random) % 4];
+		else                                      g->scratch[n++] = gen_quoted_chars[gen_next(&g->random) % (sizeof(gen_quoted_chars) - 1)];
+	}
+	// a quoted string must not be empty of text, and must contain something that needs the quotes
+	if (quoted) g->scratch[n++] = ' ';
+	return n;
+}
+
+// Generates a number into the scratch buffer and returns its length
+static size_t gen_number(GenState* g) {
+	gen_reserve(g, 64);
+	switch (gen_next(&g->random) % 3) {
+		case 0:  return snprintf(g->scratch, 64, "%d", gen_range(&g->random, -100000, 100000));
+		case 1:  return snprintf(g->scratch, 64, "%.4f", (gen_unit(&g->random) - 0.5) * 2000.0);
+		default: return snprintf(g->scratch, 64, "%.6e", (gen_unit(&g->random) - 0.5) * 1e12);
+	}
+}
+
+static void gen_gon_string(GenWriter* w, const char* s, size_t length, bool quoted) {
+	if (!quoted) { gen_write(w, s, length); return; }
+	gen_putc(w, '"');
+	for (size_t i = 0; i < length; i++) {
+		switch (s[i]) {
+			case '"':  gen_write(w, "\\\"", 2); break;
+			case '\\': gen_write(w, "\\\\", 2); break;
+			default:   gen_putc(w, s[i]);       break;
+		}
+	}
+	gen_putc(w, '"');
+}
+
+static void gen_xml_text(GenWriter* w, const char* s, size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		switch (s[i]) {
+			case '&': gen_puts(w, "&amp;"); break;
+			case '<': gen_puts(w, "&lt;");  break;
+			case '>': gen_puts(w, "&gt;");  break;
+			default:  gen_putc(w, s[i]);    break;
+		}
+	}
+}
+
+static void gen_xml_tag(GenWriter* w, const char* name, bool close) {
+	gen_putc(w, '<');
+	if (close) gen_putc(w, '/');
+	for (const char* c = name; *c; c++) {
+		bool valid = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || *c == '_' || (c != name && ((*c >= '0' && *c <= '9') || *c == '-' || *c == '.'));
+		gen_putc(w, valid ? *c : '_');
+	}
+	gen_putc(w, '>');
+}
+
+static void gen_json_string(GenWriter* w, const char* s, size_t length) {
+	gen_putc(w, '"');
+	for (size_t i = 0; i < length; i++) {
+		switch (s[i]) {
+			case '"':  gen_write(w, "\\\"", 2); break;
+			case '\\': gen_write(w, "\\\\", 2); break;
+			case '\n': gen_write(w, "\\n", 2);  break;
+			case '\t': gen_write(w, "\\t", 2);  break;
+			default:   gen_putc(w, s[i]);       break;
+		}
+	}
+	gen_putc(w, '"');
+}
+
+// Writes the separator and (for objects) the key before a JSON value
+static void gen_json_key(GenState* g, int depth, const char* name) {
+	if (!g->json_first[depth]) gen_putc(&g->json, ',');
+	g->json_first[depth] = false;
+	gen_putc(&g->json, '\n');
+	gen_indent(&g->json, depth + 1, g->options->tab_width);
+	if (name) {
+		gen_json_string(&g->json, name, strlen(name));
+		gen_puts(&g->json, ": ");
+	}
+}
+
+static void gen_comment(GenState* g, int depth) {
+	int length = gen_range(&g->random, 8, 64);
+	gen_string(g, true, false, length);
+	gen_indent(&g->gon, depth, g->options->tab_width);
+	gen_puts(&g->gon, "# ");
+	gen_write(&g->gon, g->scratch, length);
+	gen_putc(&g->gon, '\n');
+
+	if (g->xml.fp) {
+		gen_indent(&g->xml, depth, g->options->tab_width);
+		gen_puts(&g->xml, "<!-- ");
+		for (int i = 0; i < length; i++) gen_putc(&g->xml, g->scratch[i] == '-' ? '_' : g->scratch[i]);
+		gen_puts(&g->xml, " -->\n");
+	}
+}
+
+// Writes a single value; name is NULL for values in an array
+static void gen_value(GenState* g, int depth, const char* name) {
+	GenOptions* o = g->options;
+	size_t length;
+	bool   numeric = false, quoted = false;
+
+	if (gen_chance(&g->random, o->blobs)) {
+		quoted = true;
+		length = gen_string(g, true, gen_chance(&g->random, o->escapes), gen_around(&g->random, o->blob_size));
+	}
+	else if (gen_chance(&g->random, o->numeric)) {
+		numeric = true;
+		length = gen_number(g);
+	}
+	else {
+		quoted = gen_chance(&g->random, o->quoted);
+		length = gen_string(g, quoted, quoted && gen_chance(&g->random, o->escapes), gen_range(&g->random, 3, 24));
+	}
+
+	gen_gon_string(&g->gon, g->scratch, length, quoted);
+
+	if (g->xml.fp) {
+		gen_xml_tag(&g->xml, name ? name : "item", false);
+		gen_xml_text(&g->xml, g->scratch, length);
+		gen_xml_tag(&g->xml, name ? name : "item", true);
+	}
+
+	if (g->json.fp) {
+		gen_json_key(g, depth, name);
+		if (numeric) gen_write(&g->json, g->scratch, length);
+		else         gen_json_string(&g->json, g->scratch, length);
+	}
+}
+
+static void gen_object(GenState* g, int depth, const char* name);
+static void gen_array(GenState* g, int depth, const char* name);
+
+// Writes the children of an object, one per line
+static void gen_children(GenState* g, int depth) {
+	GenOptions* o = g->options;
+	int count = gen_around(&g->random, o->fanout);
+	if (count < 1) count = 1;
+
+	char name[64];
+	for (int i = 0; i < count; i++) {
+		if (gen_chance(&g->random, o->comments)) gen_comment(g, depth);
+
+		// names are usually naked words, with a numeric suffix so that wide objects have many distinct keys
+		const char* word = gen_words[gen_next(&g->random) % GEN_WORD_COUNT];
+		if (gen_chance(&g->random, o->quoted * 0.25)) snprintf(name, sizeof(name), "%s %d", word, i);
+		else                                          snprintf(name, sizeof(name), "%s_%d", word, i);
+
+		gen_indent(&g->gon, depth, o->tab_width);
+		gen_gon_string(&g->gon, name, strlen(name), strchr(name, ' ') != NULL);
+		gen_putc(&g->gon, ' ');
+		if (g->xml.fp) gen_indent(&g->xml, depth, o->tab_width);
+
+		double roll = gen_unit(&g->random);
+		bool   room = depth < o->depth;
+		if      (room && roll < o->objects)             gen_object(g, depth, name);
+		else if (room && roll < o->objects + o->arrays) gen_array(g, depth, name);
+		else                                            gen_value(g, depth, name);
+
+		gen_putc(&g->gon, '\n');
+		if (g->xml.fp) gen_putc(&g->xml, '\n');
+	}
+}
+
+// Writes an object whose name has already been written to the GON output (name is NULL for objects in an array)
+static void gen_object(GenState* g, int depth, const char* name) {
+	gen_puts(&g->gon, "{\n");
+	if (g->xml.fp) {
+		gen_xml_tag(&g->xml, name ? name : "item", false);
+		gen_putc(&g->xml, '\n');
+	}
+	if (g->json.fp) {
+		gen_json_key(g, depth, name);
+		gen_putc(&g->json, '{');
+		g->json_first[depth + 1] = true;
+	}
+
+	gen_children(g, depth + 1);
+
+	gen_indent(&g->gon, depth, g->options->tab_width);
+	gen_putc(&g->gon, '}');
+	if (g->xml.fp) {
+		gen_indent(&g->xml, depth, g->options->tab_width);
+		gen_xml_tag(&g->xml, name ? name : "item", true);
+	}
+	if (g->json.fp) {
+		gen_putc(&g->json, '\n');
+		gen_indent(&g->json, depth + 1, g->options->tab_width);
+		gen_putc(&g->json, '}');
+	}
+}
+
+// Writes an array of values (on one line) or of objects (one per line)
+static void gen_array(GenState* g, int depth, const char* name) {
+	GenOptions* o = g->options;
+	bool objects = depth + 1 < o->depth && gen_chance(&g->random, o->array_objects);
+	int  count   = gen_around(&g->random, o->array_length);
+
+	gen_puts(&g->gon, objects ? "[\n" : "[ ");
+	if (g->xml.fp) gen_xml_tag(&g->xml, name, false);
+	if (g->json.fp) {
+		gen_json_key(g, depth, name);
+		gen_putc(&g->json, '[');
+		g->json_first[depth + 1] = true;
+	}
+
+	for (int i = 0; i < count; i++) {
+		if (objects) {
+			gen_indent(&g->gon, depth + 1, o->tab_width);
+			if (g->xml.fp) {
+				gen_putc(&g->xml, '\n');
+				gen_indent(&g->xml, depth + 1, o->tab_width);
+			}
+			gen_object(g, depth + 1, NULL);
+			gen_putc(&g->gon, '\n');
+		}
+		else {
+			gen_value(g, depth + 1, NULL);
+			gen_putc(&g->gon, ' ');
+		}
+	}
+
+	if (objects) gen_indent(&g->gon, depth, o->tab_width);
+	gen_putc(&g->gon, ']');
+	if (g->xml.fp) {
+		if (objects) {
+			gen_putc(&g->xml, '\n');
+			gen_indent(&g->xml, depth, o->tab_width);
+		}
+		gen_xml_tag(&g->xml, name, true);
+	}
+	if (g->json.fp) {
+		gen_putc(&g->json, '\n');
+		gen_indent(&g->json, depth + 1, o->tab_width);
+		gen_putc(&g->json, ']');
+	}
+}
+
+// Writes records to the root until the GON output reaches the requested size
+static void gen_document(GenState* g) {
+	GenOptions* o = g->options;
+	if (g->json.fp) gen_putc(&g->json, '{');
+	g->json_first[0] = true;
+
+	char name[32];
+	for (uint64_t record = 0; g->gon.total < o->size; record++) {
+		snprintf(name, sizeof(name), "record_%llu", (unsigned long long)record);
+		gen_puts(&g->gon, name);
+		gen_putc(&g->gon, ' ');
+		gen_object(g, 0, name);
+		gen_putc(&g->gon, '\n');
+		if (g->xml.fp) gen_putc(&g->xml, '\n');
+	}
+
+	if (g->json.fp) gen_puts(&g->json, "\n}\n");
+}
+
+
+static size_t parse_size(const char* s) {
+	char* end;
+	double value = strtod(s, &end);
+	switch (*end) {
+		case 'k': case 'K': value *= 1024; break;
+		case 'm': case 'M': value *= 1024 * 1024; break;
+		case 'g': case 'G': value *= 1024.0 * 1024 * 1024; break;
+	}
+	return (size_t)value;
+}
+
+int main(int argc, char** argv) {
+	GenOptions options = gen_presets[0].options;
+	const char* gon_path  = NULL;
+	const char* xml_path  = NULL;
+	const char* json_path = NULL;
+
+	// the preset has to be applied before any of the options which override it
+	for (int i = 1; i + 1 < argc; i++) {
+		if (strcmp(argv[i], "--preset") == 0) {
+			const GenPreset* preset = gen_find_preset(argv[i + 1]);
+			if (!preset) {
+				fprintf(stderr, "unknown preset %s\n", argv[i + 1]);
+				return 1;
+			}
+			options = preset->options;
+		}
+	}
+
+	for (int i = 1; i < argc; i++) {
+		bool has_value = i + 1 < argc;
+		const char* arg = argv[i];
+		if      (!strcmp(arg, "--preset")        && has_value) i++;
+		else if (!strcmp(arg, "--seed")          && has_value) options.seed          = strtoull(argv[++i], NULL, 0);
+		else if (!strcmp(arg, "--size")          && has_value) options.size          = parse_size(argv[++i]);
+		else if (!strcmp(arg, "--depth")         && has_value) options.depth         = atoi(argv[++i]);
+		else if (!strcmp(arg, "--fanout")        && has_value) options.fanout        = atoi(argv[++i]);
+		else if (!strcmp(arg, "--objects")       && has_value) options.objects       = atof(argv[++i]);
+		else if (!strcmp(arg, "--arrays")        && has_value) options.arrays        = atof(argv[++i]);
+		else if (!strcmp(arg, "--array-objects") && has_value) options.array_objects = atof(argv[++i]);
+		else if (!strcmp(arg, "--array-length")  && has_value) options.array_length  = atoi(argv[++i]);
+		else if (!strcmp(arg, "--numeric")       && has_value) options.numeric       = atof(argv[++i]);
+		else if (!strcmp(arg, "--quoted")        && has_value) options.quoted        = atof(argv[++i]);
+		else if (!strcmp(arg, "--escapes")       && has_value) options.escapes       = atof(argv[++i]);
+		else if (!strcmp(arg, "--comments")      && has_value) options.comments      = atof(argv[++i]);
+		else if (!strcmp(arg, "--blobs")         && has_value) options.blobs         = atof(argv[++i]);
+		else if (!strcmp(arg, "--blob-size")     && has_value) options.blob_size     = atoi(argv[++i]);
+		else if (!strcmp(arg, "--tab-width")     && has_value) options.tab_width     = atoi(argv[++i]);
+		else if (!strcmp(arg, "--xml")           && has_value) xml_path  = argv[++i];
+		else if (!strcmp(arg, "--json")          && has_value) json_path = argv[++i];
+		else if (arg[0] == '-') {
+			fprintf(stderr, "unknown option %s\n", arg);
+			return 1;
+		}
+		else gon_path = arg;
+	}
+	if (!gon_path) {
+		fputs("usage: gon_gen [options] out.gon (see the top of tools/gon_gen.cpp for options)\n", stderr);
+		return 1;
+	}
+	if (options.depth < 1)  options.depth  = 1;
+	if (options.fanout < 1) options.fanout = 1;
+
+	GenState g;
+	memset(&g, 0, sizeof(g));
+	g.options      = &options;
+	g.random.state = options.seed;
+	g.json_first   = (bool*)calloc(options.depth + 2, sizeof(bool));
+	if (!gen_open(&g.gon, gon_path) || !gen_open(&g.xml, xml_path) || !gen_open(&g.json, json_path)) return 1;
+
+	gen_document(&g);
+
+	printf("%s: %zu bytes\n", gon_path, g.gon.total);
+	if (xml_path)  printf("%s: %zu bytes\n", xml_path,  g.xml.total);
+	if (json_path) printf("%s: %zu bytes\n", json_path, g.json.total);
+
+	gen_close(&g.gon);
+	gen_close(&g.xml);
+	gen_close(&g.json);
+	free(g.scratch);
+	free(g.json_first);
+	return 0;
+}
@@ -0,0 +1,362 @@
+/*
+	uGON minimal perfect hash generator
+
+	Reads the names used in one or more sample GON files (and/or a list of keys) and writes a C header with a GonSchema over them.
+	The schema maps each name to a key number with one hash and one compare (see Schemas in ugon.h), and rejects any other name.
+
+	Usage: gon_mphf [options] [sample.gon ...]
+		--keys   keys.txt    also read keys from a text file, one per line
+		--depth  N           only take names of fields N levels below the root (1 for the root's own children, 2 for the fields of each top-level object, ...)
+		--name   entity      prefix for everything in the header (default: the output file name without any "_schema", or "gon")
+		--seed   N           first seed to try (default 0)
+		--out    entity.h    write the header here rather than to stdout
+
+	The header defines an enum of key numbers (ENTITY_KEY_HP, ...), the key and displacement tables, and a const GonSchema named entity_schema.
+	It must be included after ugon.h. Running the tool again on the same keys and options always writes the same header.
+
+	Keys are gathered into buckets of about four by the high bits of their hash. The largest buckets are placed first, each by searching for a displacement that sends all of its keys to free slots.
+	If no displacement works, or two keys have the same 64-bit hash, the next seed is tried.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include "ugon.h"
+
+
+/*
+	Key set
+
+	Keys are kept in the order they are first seen, without duplicates.
+*/
+
+typedef struct MphKey {
+	char*  text;
+	size_t length;
+} MphKey;
+
+typedef struct MphKeys {
+	MphKey* keys;
+	int     count;
+	int     capacity;
+} MphKeys;
+
+static bool mph_add_key(MphKeys* set, const char* text, size_t length) {
+	for (int i = 0; i < set->count; i++) {
+		if (set->keys[i].length == length && memcmp(set->keys[i].text, text, length) == 0) return true;
+	}
+	if (set->count == set->capacity) {
+		int capacity = set->capacity ? set->capacity * 2 : 64;
+		MphKey* keys = (MphKey*)realloc(set->keys, capacity * sizeof(MphKey));
+		if (!keys) return false;
+		set->keys     = keys;
+		set->capacity = capacity;
+	}
+	char* copy = (char*)malloc(length + 1);
+	if (!copy) return false;
+	memcpy(copy, text, length);
+	copy[length] = '\0';
+	set->keys[set->count].text   = copy;
+	set->keys[set->count].length = length;
+	set->count++;
+	return true;
+}
+
+static bool mph_read_sample(MphKeys* set, const char* path, int depth) {
+	GonFile gon = gon_create();
+	if (gon_load_file(&gon, path) || gon_parse(&gon)) {
+		fprintf(stderr, "%s: could not be loaded\n", path);
+		gon_free(&gon);
+		return false;
+	}
+	int  field_count = gon.fields[0].size;
+	int* depths      = (int*)calloc(field_count, sizeof(int));
+	bool ok = depths != NULL;
+	for (int i = 1; ok && i < field_count; i++) {
+		GonField* field = &gon.fields[i];
+		depths[i] = depths[field->parent] + 1;
+		const char* name = gon_name(field);
+		if (!name || (depth && depths[i] != depth)) continue;
+		ok = mph_add_key(set, name, gon_name_length(field));
+	}
+	free(depths);
+	gon_free(&gon);
+	return ok;
+}
+
+static bool mph_read_key_list(MphKeys* set, const char* path) {
+	FILE* fp = fopen(path, "rb");
+	if (!fp) {
+		perror(path);
+		return false;
+	}
+	char line[4096];
+	bool ok = true;
+	while (ok && fgets(line, sizeof(line), fp)) {
+		size_t length = strlen(line);
+		while (length && (line[length - 1] == '\n' || line[length - 1] == '\r')) length--;
+		if (length) ok = mph_add_key(set, line, length);
+	}
+	fclose(fp);
+	return ok;
+}
+
+
+/*
+	Building the hash
+*/
+
+typedef struct MphTable {
+	uint64_t      seed;
+	int           bucket_count;
+	unsigned int* displacements;	// one per bucket
+	int*          slots;			// key (index into the key set) placed at each key number
+} MphTable;
+
+#define MPH_MAX_DISPLACEMENT (1u << 24)
+#define MPH_MAX_SEEDS        1000
+
+// Tries to place every key with one seed, returning false if some bucket cannot be placed
+static bool mph_try_seed(const MphKeys* set, MphTable* table, uint64_t* hashes, int* bucket_of, int* order, int* bucket_sizes, unsigned int* scratch) {
+	int n = set->count;
+	int b = table->bucket_count;
+	for (int i = 0; i < n; i++) {
+		hashes[i]    = gon_mph_hash(set->keys[i].text, set->keys[i].length, table->seed);
+		bucket_of[i] = gon_mph_bucket(hashes[i], b);
+	}
+	for (int i = 0; i < n; i++) {
+		for (int j = i + 1; j < n; j++) if (hashes[i] == hashes[j]) return false;
+	}
+
+	// order the keys by bucket, with the largest buckets first
+	memset(bucket_sizes, 0, b * sizeof(int));
+	for (int i = 0; i < n; i++) bucket_sizes[bucket_of[i]]++;
+	for (int i = 0; i < n; i++) order[i] = i;
+	for (int i = 1; i < n; i++) {
+		int key = order[i], j = i;
+		while (j > 0) {
+			int other = order[j - 1];
+			int size_key = bucket_sizes[bucket_of[key]], size_other = bucket_sizes[bucket_of[other]];
+			if (size_other > size_key || (size_other == size_key && bucket_of[other] <= bucket_of[key])) break;
+			order[j] = other;
+			j--;
+		}
+		order[j] = key;
+	}
+
+	for (int i = 0; i < n; i++) table->slots[i] = -1;
+	memset(table->displacements, 0, b * sizeof(unsigned int));
+	for (int start = 0; start < n; ) {
+		int bucket = bucket_of[order[start]];
+		int size   = bucket_sizes[bucket];
+		bool placed = false;
+		for (unsigned int d = 0; !placed && d < MPH_MAX_DISPLACEMENT; d++) {
+			placed = true;
+			for (int k = 0; placed && k < size; k++) {
+				unsigned int slot = gon_mph_key(hashes[order[start + k]], d, n);
+				if (table->slots[slot] >= 0) placed = false;
+				for (int m = 0; placed && m < k; m++) if (scratch[m] == slot) placed = false;
+				scratch[k] = slot;
+			}
+			if (placed) {
+				table->displacements[bucket] = d;
+				for (int k = 0; k < size; k++) table->slots[scratch[k]] = order[start + k];
+			}
+		}
+		if (!placed) return false;
+		start += size;
+	}
+	return true;
+}
+
+static bool mph_build(const MphKeys* set, MphTable* table, uint64_t first_seed) {
+	int n = set->count;
+	table->bucket_count  = (n + 3) / 4;
+	table->displacements = (unsigned int*)malloc(table->bucket_count * sizeof(unsigned int));
+	table->slots         = (int*)malloc(n * sizeof(int));
+	uint64_t*     hashes       = (uint64_t*)malloc(n * sizeof(uint64_t));
+	int*          bucket_of    = (int*)malloc(n * sizeof(int));
+	int*          order        = (int*)malloc(n * sizeof(int));
+	int*          bucket_sizes = (int*)malloc(table->bucket_count * sizeof(int));
+	unsigned int* scratch      = (unsigned int*)malloc(n * sizeof(unsigned int));
+	bool ok = table->displacements && table->slots && hashes && bucket_of && order && bucket_sizes && scratch;
+
+	bool built = false;
+	for (int attempt = 0; ok && !built && attempt < MPH_MAX_SEEDS; attempt++) {
+		table->seed = first_seed + attempt;
+		built = mph_try_seed(set, table, hashes, bucket_of, order, bucket_sizes, scratch);
+	}
+	free(hashes);
+	free(bucket_of);
+	free(order);
+	free(bucket_sizes);
+	free(scratch);
+	return built;
+}
+
+
+/*
+	Output
+*/
+
+// Writes a key as a C string literal, with octal escapes for anything unusual
+static void mph_write_literal(FILE* out, const MphKey* key) {
+	fputc('"', out);
+	for (size_t i = 0; i < key->length; i++) {
+		unsigned char c = (unsigned char)key->text[i];
+		if (c == '"' || c == '\\' || c == '?') fprintf(out, "\\%c", c);	// '?' so that keys cannot form trigraphs
+		else if (c < 32 || c > 126) fprintf(out, "\\%03o", c);
+		else fputc(c, out);
+	}
+	fputc('"', out);
+}
+
+// Builds an enum name for a key, such as ENTITY_KEY_MAX_HP, falling back on the key number when the key has nothing usable or the name is already taken
+static void mph_enum_name(char* dst, size_t size, const char* upper_prefix, const MphKey* key, int number, char (*taken)[128], int taken_count) {
+	size_t length = (size_t)snprintf(dst, size, "%s_KEY_", upper_prefix);
+	size_t start  = length;
+	for (size_t i = 0; i < key->length && length + 1 < size; i++) {
+		unsigned char c = (unsigned char)key->text[i];
+		dst[length++] = isalnum(c) ? (char)toupper(c) : '_';
+	}
+	dst[length] = '\0';
+	for (int attempt = 0; ; attempt++) {
+		bool unusable = length == start;
+		for (int i = 0; !unusable && i < taken_count; i++) unusable = strcmp(taken[i], dst) == 0;
+		if (!unusable) return;
+		if (attempt) snprintf(dst, size, "%s_KEY_%d_%d", upper_prefix, number, attempt);
+		else         snprintf(dst, size, "%s_KEY_%d", upper_prefix, number);
+		length = start + 1;
+	}
+}
+
+static void mph_write_header(FILE* out, const MphKeys* set, const MphTable* table, const char* prefix, const char* sources) {
+	int n = set->count;
+	char upper[64];		// half the size of an enum name, so that a name always has room for the key after the prefix
+	size_t p = 0;
+	for (; prefix[p] && p + 1 < sizeof(upper); p++) upper[p] = (char)toupper((unsigned char)prefix[p]);
+	upper[p] = '\0';
+
+	fprintf(out, "/*\n\tGenerated by tools/gon_mphf from %s. Do not edit.\n", sources);
+	fprintf(out, "\t%d keys in %d buckets, seed %llu.\n*/\n\n", n, table->bucket_count, (unsigned long long)table->seed);
+	fprintf(out, "#ifndef %s_SCHEMA_H\n#define %s_SCHEMA_H\n\n", upper, upper);
+
+	// names[0] is the count, taken up front so that a key called "count" gets a name of its own
+	char (*names)[128] = (char (*)[128])calloc(n + 1, 128);
+	snprintf(names[0], sizeof(names[0]), "%s_KEY_COUNT", upper);
+	fprintf(out, "enum {\n");
+	for (int k = 0; k < n; k++) {
+		const MphKey* key = &set->keys[table->slots[k]];
+		mph_enum_name(names[k + 1], sizeof(names[k + 1]), upper, key, k, names, k + 1);
+		fprintf(out, "\t%s = %d,\t// ", names[k + 1], k);
+		mph_write_literal(out, key);
+		fputc('\n', out);
+	}
+	fprintf(out, "\t%s = %d\n};\n\n", names[0], n);
+	free(names);
+
+	fprintf(out, "static const char* const %s_schema_keys[%d] = {\n", prefix, n);
+	for (int k = 0; k < n; k++) {
+		fputc('\t', out);
+		mph_write_literal(out, &set->keys[table->slots[k]]);
+		fputs(",\n", out);
+	}
+	fprintf(out, "};\n\n");
+
+	fprintf(out, "static const int %s_schema_lengths[%d] = {", prefix, n);
+	for (int k = 0; k < n; k++) fprintf(out, "%s%zu", !k ? "\n\t" : k % 16 ? ", " : ",\n\t", set->keys[table->slots[k]].length);
+	fprintf(out, "\n};\n\n");
+
+	fprintf(out, "static const unsigned int %s_schema_displacements[%d] = {", prefix, table->bucket_count);
+	for (int b = 0; b < table->bucket_count; b++) fprintf(out, "%s%u", !b ? "\n\t" : b % 16 ? ", " : ",\n\t", table->displacements[b]);
+	fprintf(out, "\n};\n\n");
+
+	fprintf(out, "static const GonSchema %s_schema = {\n", prefix);
+	fprintf(out, "\t%s_schema_keys, %s_schema_lengths, %d,\n", prefix, prefix, n);
+	fprintf(out, "\t%s_schema_displacements, %d,\n", prefix, table->bucket_count);
+	fprintf(out, "\t%lluull\n};\n\n", (unsigned long long)table->seed);
+	fprintf(out, "#endif\n");
+}
+
+// Turns an output path such as "gen/entity_schema.h" into a prefix such as "entity" (without the "_schema", since every name gets that added back)
+static void mph_prefix_from_path(char* dst, size_t size, const char* path) {
+	const char* base = path;
+	for (const char* c = path; *c; c++) if (*c == '/' || *c == '\\') base = c + 1;
+	size_t length = 0;
+	for (; base[length] && base[length] != '.' && length + 1 < size; length++)
+		dst[length] = isalnum((unsigned char)base[length]) ? base[length] : '_';
+	if (length > 7 && !memcmp(dst + length - 7, "_schema", 7)) length -= 7;
+	dst[length] = '\0';
+	if (!length || isdigit((unsigned char)dst[0])) snprintf(dst, size, "gon");
+}
+
+int main(int argc, char** argv) {
+	const char* out_path  = NULL;
+	const char* name      = NULL;
+	uint64_t    seed      = 0;
+	int         depth     = 0;
+	MphKeys     set       = { NULL, 0, 0 };
+	char        sources[1024] = "";
+	int         source_count  = 0;
+
+	for (int i = 1; i < argc; i++) {
+		bool has_value = i + 1 < argc;
+		const char* arg = argv[i];
+		if      (!strcmp(arg, "--depth") && has_value) depth    = atoi(argv[++i]);
+		else if (!strcmp(arg, "--name")  && has_value) name     = argv[++i];
+		else if (!strcmp(arg, "--seed")  && has_value) seed     = strtoull(argv[++i], NULL, 0);
+		else if (!strcmp(arg, "--out")   && has_value) out_path = argv[++i];
+		else if (!strcmp(arg, "--keys")  && has_value) {
+			if (!mph_read_key_list(&set, argv[++i])) return 1;
+			if (source_count++ < 4) snprintf(sources + strlen(sources), sizeof(sources) - strlen(sources), "%s%s", source_count > 1 ? ", " : "", argv[i]);
+		}
+		else if (arg[0] == '-') {
+			fprintf(stderr, "unknown option %s\n", arg);
+			return 1;
+		}
+		else {
+			if (!mph_read_sample(&set, arg, depth)) return 1;
+			if (source_count++ < 4) snprintf(sources + strlen(sources), sizeof(sources) - strlen(sources), "%s%s", source_count > 1 ? ", " : "", arg);
+		}
+	}
+	if (!source_count) {
+		fputs("usage: gon_mphf [options] [sample.gon ...] (see the top of tools/gon_mphf.cpp for options)\n", stderr);
+		return 1;
+	}
+	if (source_count > 4) snprintf(sources + strlen(sources), sizeof(sources) - strlen(sources), " and %d more", source_count - 4);
+	if (!set.count) {
+		fputs("no keys found\n", stderr);
+		return 1;
+	}
+
+	char prefix[128];
+	if (name) mph_prefix_from_path(prefix, sizeof(prefix), name);
+	else if (out_path) mph_prefix_from_path(prefix, sizeof(prefix), out_path);
+	else snprintf(prefix, sizeof(prefix), "gon");
+
+	MphTable table;
+	if (!mph_build(&set, &table, seed)) {
+		fprintf(stderr, "could not build a perfect hash for %d keys\n", set.count);
+		return 1;
+	}
+
+	FILE* out = out_path ? fopen(out_path, "wb") : stdout;
+	if (!out) {
+		perror(out_path);
+		return 1;
+	}
+	mph_write_header(out, &set, &table, prefix, sources);
+	if (out_path) {
+		fclose(out);
+		fprintf(stderr, "%s: %d keys\n", out_path, set.count);
+	}
+
+	for (int i = 0; i < set.count; i++) free(set.keys[i].text);
+	free(set.keys);
+	free(table.displacements);
+	free(table.slots);
+	return 0;
+}
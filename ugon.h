@@ -5,6 +5,9 @@
 	For detailed information and explanations on how the parser works, see the included documentation.
 */ 
 
+#ifndef UGON_H
+#define UGON_H
+
 /*
 	Field Buffer Settings
 
@@ -13,16 +16,145 @@
 	When using static buffer mode, the maximum field count is defined with the macro GON_FIELD_BUFFER_SIZE.
 	When using dynamic buffer mode, the default starting size for the buffer is defined with the macro GON_FIELD_BUFFER_DEFAULT_SIZE.
 	You also have the option to define GON_REALLOC_ON_COMPLETE when in dynamic buffer mode. This will realloc the gon fields buffer once parsing has completed, reducing it to the smallest size necessary.
+
+	If GON_USING_RESERVED_FIELDS is defined as well, the fields buffer is a reserved range of address space rather than a malloc'd block.
+	gon_parse() reserves room for the most fields the file could hold (one per byte) before it starts, and the OS only commits pages as fields are written into them, so the buffer is never copied as it grows.
+	Other growth (e.g. with GonParser) reserves at least GON_RESERVED_FIELDS_MIN fields at a time.
+	Reservations made for GON_HUGE_PAGE_MIN_SIZE bytes of fields or more are marked for transparent huge pages where available (madvise on Linux). This goes by the fields asked for rather than the rounded-up reservation, so small files never fault in a whole huge page.
+	gon_flatten_fields() copies the fields into a malloc'd buffer of exactly the right size and releases the reservation. With GON_REALLOC_ON_COMPLETE, this is done at the end of every parse.
 */
 
 #define GON_USING_DYNAMIC_BUFFER
 #ifdef GON_USING_DYNAMIC_BUFFER
 #define GON_FIELD_BUFFER_DEFAULT_SIZE 32
 //#define GON_REALLOC_ON_COMPLETE
+//#define GON_USING_RESERVED_FIELDS
+#ifdef GON_USING_RESERVED_FIELDS
+#define GON_RESERVED_FIELDS_MIN (1 << 20)
+#define GON_HUGE_PAGE_MIN_SIZE  (32 << 20)
+#endif
 #else
 #define GON_FIELD_BUFFER_SIZE 32
 #endif
 
+/*
+	SIMD Settings
+
+	If GON_USING_SIMD is defined, gon_parse will first classify the whole input into bitmasks (one bit per byte, in blocks of 64 bytes) before running the main loop.
+	The main loop then finds the end of each name, value, whitespace run and comment by searching these masks, rather than stepping through the file one byte at a time.
+	The masks are built with AVX2 or SSE2 depending on what the CPU supports at runtime, and with the lookup tables below on any other target.
+	All three paths build the same masks, so the resulting GonField array is identical to the one produced without GON_USING_SIMD.
+	This costs an extra half byte of memory per byte of input for the duration of gon_parse, so it is only worth enabling for large files.
+
+	The masks only pay off for long strings (quoted text, long names and values): building them costs about as much per byte as the main loop saves, so structure-dense input (short names and numbers, lots of braces) parses up to 2x slower with them.
+	gon_parse therefore measures the average token length in the first GON_SIMD_SAMPLE_SIZE bytes of the input, and only builds the masks if it is at least GON_SIMD_MIN_TOKEN_LENGTH bytes. Otherwise it scans with the lookup tables, as without GON_USING_SIMD, though still a little (around 10-15%) slower than a build without it, as every scan checks for the masks.
+	gon_parse_threaded() and GonReader always use the masks.
+*/
+//#define GON_USING_SIMD
+#ifdef GON_USING_SIMD
+#define GON_SIMD_SAMPLE_SIZE      1024
+#define GON_SIMD_MIN_TOKEN_LENGTH 24
+#endif
+
+/*
+	Thread Settings
+
+	If GON_USING_THREADS is defined, gon_parse_threaded() may be used in place of gon_parse() to split very large files across several threads.
+	The file is divided into one range per thread, with each range starting on a new line. Each thread tokenizes its own range, the ranges are linked together on the calling thread, and then each thread builds the fields for its own range.
+	The result is the same GonField array that gon_parse() would produce.
+	Each thread is given at least GON_THREAD_MIN_CHUNK_SIZE bytes of the file, so small files will simply be parsed on the calling thread.
+	Threaded parsing requires GON_USING_DYNAMIC_BUFFER.
+*/
+//#define GON_USING_THREADS
+#ifdef GON_USING_THREADS
+#ifndef GON_THREAD_MIN_CHUNK_SIZE
+#define GON_THREAD_MIN_CHUNK_SIZE (1 << 20)
+#endif
+#endif
+
+/*
+	Index Settings
+
+	If GON_USING_INDEX is defined, objects can be given a hash table over their children, which gon_get_field() will use instead of comparing the name of every child.
+	gon_build_index() builds a table for every object with at least GON_INDEX_MIN_COUNT children.
+	If GON_INDEX_ADAPTIVE_LOOKUPS is greater than zero, gon_get_field() will also build the table for such an object by itself once it has been searched that many times.
+	This adds a pointer to every GonField. The tables are freed by gon_free().
+*/
+//#define GON_USING_INDEX
+#ifdef GON_USING_INDEX
+#define GON_INDEX_MIN_COUNT        16
+#define GON_INDEX_ADAPTIVE_LOOKUPS 8
+#endif
+
+/*
+	Atom Settings
+
+	If GON_USING_ATOMS is defined, every field name is interned in one atom table shared by the whole process, and each GonField carries the 32-bit key of its name.
+	The parsers and gon_load_baked() fill the keys in, so two fields have the same key exactly when they have the same name, in any GonFile and on any thread.
+	gon_atom() gets the key of a name once up front, and gon_get_field_key() then finds a child by comparing keys as integers. gon_get_field() looks its name up in the table and does the same.
+	Looking a name up never takes a lock, so any number of threads can parse and search at once. Only adding a name that has not been seen before takes a lock.
+	The table only grows, up to GON_ATOM_MAX names, and is kept until gon_atoms_free(). A parse which would take it past that fails.
+	This adds 8 bytes to every GonField, and cannot be combined with GON_USING_COMPACT_FIELDS.
+*/
+//#define GON_USING_ATOMS
+#ifdef GON_USING_ATOMS
+#define GON_ATOM_MAX (1 << 20)
+#endif
+
+/*
+	Non-Destructive Settings
+
+	By default, gon_parse() places a null after every name and value in the input buffer, so that they can be used directly as C strings.
+	If GON_NON_DESTRUCTIVE is defined, the parser never writes to the input buffer. The ends of names and values are then only marked by each GonField's name_length and value_length.
+	This lets the buffer be read-only, shared between threads, or mapped from a file without a private copy (gon_load_file() maps it read-only in this mode).
+	Names and values are then NOT null-terminated, so use the lengths (or gon_name_length() / gon_value_length(), which work in either mode) when reading them.
+	The input buffer must still be followed by one readable null byte, which gon_load_file() guarantees.
+*/
+//#define GON_NON_DESTRUCTIVE
+
+/*
+	Compact Field Settings
+
+	If GON_USING_COMPACT_FIELDS is defined, each GonField takes 16 bytes rather than 32 (on 64-bit targets).
+	Names and values are stored as 32-bit offsets from the start of the file, the type and flags are packed into the top bits of the parent index, and objects do not store their child count.
+	In their place, every field stores its own index, which lets gon_name(), gon_value() and gon_count() find the file from any field.
+	So in this mode, use those functions rather than reading name, value and count directly. They work the same way in the default mode.
+	Compact fields also have no room for the name and value lengths or the GON_FLAG_*_PLAIN flags, so gon_name_length() and gon_value_length() fall back to strlen, and the serializers check every string for characters that need quotes.
+	Files must be under 4GB, and may have at most 2^28 fields.
+	This mode requires GON_USING_DYNAMIC_BUFFER, and cannot be combined with GON_NON_DESTRUCTIVE (there is no room left for the lengths) or GON_USING_THREADS.
+*/
+//#define GON_USING_COMPACT_FIELDS
+
+/*
+	File Loading Settings
+
+	gon_load_file() reads a file into a GonFile, ready for gon_parse(). The file is always followed by at least one null byte, which the parser relies on.
+	If GON_USING_MMAP is defined, the file is mapped copy-on-write (mmap with MAP_PRIVATE, or a FILE_MAP_COPY view on Windows) rather than read into a malloc'd buffer, so there is no copy up front and the parser only duplicates the pages it writes nulls into.
+	Files smaller than GON_MMAP_MIN_SIZE are still read, since for those the cost of setting up the mapping outweighs the copy.
+	gon_free() unmaps the file if it was mapped, and frees it otherwise.
+*/
+#define GON_USING_MMAP
+#ifdef GON_USING_MMAP
+#define GON_MMAP_MIN_SIZE (1 << 16)
+#endif
+
+/*
+	Output Settings
+
+	gon_serialize_file() and the GonFilePrinter gather their output in a staging buffer of GON_WRITE_BUFFER_SIZE bytes, and only call fwrite() when it fills up (or once at the end).
+	gon_serialize_file() keeps this buffer on the stack, and each GonFilePrinter holds its own.
+*/
+#define GON_WRITE_BUFFER_SIZE (1 << 15)
+
+#ifdef GON_USING_COMPACT_FIELDS
+#if !defined(GON_USING_DYNAMIC_BUFFER) || defined(GON_NON_DESTRUCTIVE) || defined(GON_USING_THREADS)
+#error "GON_USING_COMPACT_FIELDS requires GON_USING_DYNAMIC_BUFFER, and cannot be combined with GON_NON_DESTRUCTIVE or GON_USING_THREADS"
+#endif
+#ifdef GON_USING_ATOMS
+#error "GON_USING_ATOMS cannot be combined with GON_USING_COMPACT_FIELDS"
+#endif
+#endif
+
 // Lookup table for whitespace characters
 const unsigned char gon_lookup_whitespace[256] = {
 	0,0,0,0,0,0,0,0,0,1,1,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
@@ -43,452 +175,5336 @@ typedef enum GonType {
 
 #define gon_type_check(gon, gontype) (gon != NULL && gon->type == gontype)
 
+// Field flags
+// A quoted name or value which contains a backslash escape is flagged, so that strings without escapes (nearly all of them) never need to be looked at again
+// Unless GON_NON_DESTRUCTIVE is defined, gon_name() and gon_value() remove the escapes in place the first time they are called on the field, and clear the flag
+#define GON_FLAG_NAME_ESCAPED  1
+#define GON_FLAG_VALUE_ESCAPED 2
+// A name or value which was read without quotes is flagged as plain, since it can be written back out as it is, without checking whether it needs quotes
+// Compact fields have no room for these flags, so there they are 0 and every string is checked
+#ifndef GON_USING_COMPACT_FIELDS
+#define GON_FLAG_NAME_PLAIN    4
+#define GON_FLAG_VALUE_PLAIN   8
+#else
+#define GON_FLAG_NAME_PLAIN    0
+#define GON_FLAG_VALUE_PLAIN   0
+#endif
+
+#ifdef GON_USING_INDEX
+// One entry in an object's hash table
+typedef struct GonIndexSlot {
+	unsigned int hash;	// hash of the child's name
+	int          child;	// offset of the child from the object (0 if the slot is empty)
+} GonIndexSlot;
+
+// Header for an object's hash table, followed in memory by mask + 1 slots
+typedef struct GonIndex {
+	int lookups;		// number of times the object has been searched by gon_get_field()
+	int mask;			// number of slots - 1, or 0 if the table has not been built yet
+} GonIndex;
+
+struct GonFile;
+void gon_free_index(struct GonFile* gon);
+#endif
+
 // Defines a single field in the gon file
+#ifndef GON_USING_COMPACT_FIELDS
 typedef struct GonField {
 	char *name;
 	int   parent;
-	int   type;
+	unsigned char type;
+	unsigned char flags;	// GON_FLAG_* bits
 	union {
 		char *value;
-		struct { int size, count; };
+		struct {
+			int size, count;
+			#ifdef GON_USING_INDEX
+			GonIndex* index;
+			#endif
+		};
+	};
+	int   name_length;	// set by the parser, so that names and values never need strlen (and gon_get_field() can skip names of the wrong length)
+	int   value_length;
+	#ifdef GON_USING_ATOMS
+	unsigned int key;	// key of the name in the atom table, or 0 for values in an array
+	#endif
+} GonField;
+#else
+#define GON_NO_NAME 0xFFFFFFFFu
+#define GON_COMPACT_MAX_FIELDS (1u << 28)	// the most fields a parent index can count up to
+
+typedef struct GonField {
+	unsigned int name;			// offset of the name from the start of the file (GON_NO_NAME for values in an array, and the root)
+	unsigned int parent : 28;
+	unsigned int flags  : 2;	// GON_FLAG_* bits
+	unsigned int type   : 2;
+	union {
+		unsigned int value;		// offset of the value from the start of the file
+		int          size;
 	};
+	int          self;			// index of this field in the fields array
 } GonField;
 
+// Sits in the slot just before fields[0], so that any field can find the file its offsets are relative to
+typedef struct GonFieldsHeader {
+	char*      file;
+	#ifdef GON_USING_INDEX
+	GonIndex** indices;			// hash table for each object, indexed by field (NULL until the first table is built)
+	#endif
+} GonFieldsHeader;
+
+static inline GonFieldsHeader* gon_fields_header(const GonField* field) {
+	return (GonFieldsHeader*)(field - field->self - 1);
+}
+#endif
+
+/*
+	Allocators
+
+	By default the fields buffer and the SIMD masks come from malloc, realloc and free. To take them from somewhere else, point GonFile's allocator at a GonAllocator before the first gon_parse().
+	A GonAllocator is a set of callbacks and a context pointer, so it can wrap any allocator. resize and release may be NULL: without resize, blocks are moved with alloc and memcpy, and without release, nothing is ever freed.
+	Two are included, both for use from one thread at a time (so give each thread its own):
+	- GonArena hands out memory from large blocks and frees nothing until gon_arena_reset(), which makes it a good fit for parses whose results are all thrown away together.
+	- GonPool keeps freed blocks in lists by power-of-two size, and hands them out again, so a stream of GonFiles that are parsed and freed in turn stops allocating once it is warmed up.
+	The file buffer is still allocated with malloc by gon_load_file() and GonParser, and freed with free() by gon_free(). Hash tables and gon_parse_threaded()'s working memory also use malloc.
+	To parse many small messages into one GonFile, gon_reset() releases the file and hash tables but keeps the fields buffer for the next parse.
+*/
+typedef struct GonAllocator {
+	void* (*alloc)  (void* context, size_t size);
+	void* (*resize) (void* context, void* block, size_t old_size, size_t new_size);
+	void  (*release)(void* context, void* block, size_t size);
+	void*   context;
+} GonAllocator;
+
+static inline void* gon_alloc(const GonAllocator* allocator, size_t size) {
+	return allocator ? allocator->alloc(allocator->context, size) : malloc(size);
+}
+
+static inline void gon_release(const GonAllocator* allocator, void* block, size_t size) {
+	if (!allocator) free(block);
+	else if (block && allocator->release) allocator->release(allocator->context, block, size);
+}
+
+static inline void* gon_resize(const GonAllocator* allocator, void* block, size_t old_size, size_t new_size) {
+	if (!allocator) return realloc(block, new_size);
+	if (!block) return allocator->alloc(allocator->context, new_size);
+	if (allocator->resize) return allocator->resize(allocator->context, block, old_size, new_size);
+	void* block_new = allocator->alloc(allocator->context, new_size);
+	if (!block_new) return NULL;
+	memcpy(block_new, block, old_size < new_size ? old_size : new_size);
+	gon_release(allocator, block, old_size);
+	return block_new;
+}
+
+// Arena allocator
+// Blocks are carved out of chunks of at least GON_ARENA_CHUNK_SIZE bytes. Only the most recent block can be resized in place or given back
+#define GON_ARENA_CHUNK_SIZE (64 << 10)
+
+typedef struct GonArenaChunk {
+	struct GonArenaChunk* next;
+	size_t used;
+	size_t capacity;
+} GonArenaChunk;
+
+typedef struct GonArena {
+	GonArenaChunk* chunks;	// most recent first
+	size_t         total;	// capacity of every chunk, which gon_arena_reset() uses to size the one it keeps
+} GonArena;
+
+// Rounds sizes up so that every block is aligned for any GonField member
+#define gon_arena_round(size) (((size) + 15) & ~(size_t)15)
+
+static void* gon_arena_alloc(void* context, size_t size) {
+	GonArena* arena = (GonArena*)context;
+	size = gon_arena_round(size);
+	GonArenaChunk* chunk = arena->chunks;
+	if (!chunk || chunk->capacity - chunk->used < size) {
+		size_t capacity = size > GON_ARENA_CHUNK_SIZE ? size : GON_ARENA_CHUNK_SIZE;
+		chunk = (GonArenaChunk*)malloc(gon_arena_round(sizeof(GonArenaChunk)) + capacity);
+		if (!chunk) return NULL;
+		chunk->next     = arena->chunks;
+		chunk->used     = 0;
+		chunk->capacity = capacity;
+		arena->chunks   = chunk;
+		arena->total   += capacity;
+	}
+	void* block = (char*)chunk + gon_arena_round(sizeof(GonArenaChunk)) + chunk->used;
+	chunk->used += size;
+	return block;
+}
+
+// True if block is the last thing handed out from the current chunk
+static inline bool gon_arena_is_top(GonArena* arena, void* block, size_t size) {
+	GonArenaChunk* chunk = arena->chunks;
+	return chunk && (char*)block + gon_arena_round(size) == (char*)chunk + gon_arena_round(sizeof(GonArenaChunk)) + chunk->used;
+}
+
+static void* gon_arena_resize(void* context, void* block, size_t old_size, size_t new_size) {
+	GonArena* arena = (GonArena*)context;
+	if (gon_arena_is_top(arena, block, old_size)) {
+		GonArenaChunk* chunk = arena->chunks;
+		size_t start = chunk->used - gon_arena_round(old_size);
+		if (chunk->capacity - start >= gon_arena_round(new_size)) {
+			chunk->used = start + gon_arena_round(new_size);
+			return block;
+		}
+	}
+	void* block_new = gon_arena_alloc(context, new_size);
+	if (block_new) memcpy(block_new, block, old_size < new_size ? old_size : new_size);
+	return block_new;
+}
+
+static void gon_arena_release(void* context, void* block, size_t size) {
+	GonArena* arena = (GonArena*)context;
+	if (gon_arena_is_top(arena, block, size)) arena->chunks->used -= gon_arena_round(size);
+}
+
+GonAllocator gon_arena_allocator(GonArena* arena) {
+	GonAllocator allocator = { gon_arena_alloc, gon_arena_resize, gon_arena_release, arena };
+	return allocator;
+}
+
+// Frees every chunk
+void gon_arena_free(GonArena* arena) {
+	while (arena->chunks) {
+		GonArenaChunk* next = arena->chunks->next;
+		free(arena->chunks);
+		arena->chunks = next;
+	}
+	arena->total = 0;
+}
+
+// Forgets every block handed out so far, keeping one chunk big enough to hold them all next time
+void gon_arena_reset(GonArena* arena) {
+	if (arena->chunks && arena->chunks->next) {
+		size_t total = arena->total;
+		gon_arena_free(arena);
+		GonArenaChunk* chunk = (GonArenaChunk*)malloc(gon_arena_round(sizeof(GonArenaChunk)) + total);
+		if (!chunk) return;
+		chunk->next     = NULL;
+		chunk->capacity = total;
+		arena->chunks   = chunk;
+		arena->total    = total;
+	}
+	if (arena->chunks) arena->chunks->used = 0;
+}
+
+// Pool allocator
+// Blocks are rounded up to a power of two of at least 1 << GON_POOL_MIN_SHIFT bytes, and freed blocks are kept in a list for their size
+#define GON_POOL_MIN_SHIFT 6
+#define GON_POOL_CLASSES   48
+
+typedef struct GonPool {
+	void* free_lists[GON_POOL_CLASSES];	// each free block starts with a pointer to the next one
+} GonPool;
+
+static inline int gon_pool_class(size_t size) {
+	int shift = GON_POOL_MIN_SHIFT;
+	while (((size_t)1 << shift) < size) shift++;
+	return shift - GON_POOL_MIN_SHIFT;
+}
+
+static void* gon_pool_alloc(void* context, size_t size) {
+	GonPool* pool = (GonPool*)context;
+	int size_class = gon_pool_class(size);
+	if (size_class >= GON_POOL_CLASSES) return NULL;
+	void* block = pool->free_lists[size_class];
+	if (block) {
+		pool->free_lists[size_class] = *(void**)block;
+		return block;
+	}
+	return malloc((size_t)1 << (size_class + GON_POOL_MIN_SHIFT));
+}
+
+static void gon_pool_release(void* context, void* block, size_t size) {
+	GonPool* pool = (GonPool*)context;
+	int size_class = gon_pool_class(size);
+	*(void**)block = pool->free_lists[size_class];
+	pool->free_lists[size_class] = block;
+}
+
+static void* gon_pool_resize(void* context, void* block, size_t old_size, size_t new_size) {
+	if (gon_pool_class(old_size) == gon_pool_class(new_size)) return block;
+	void* block_new = gon_pool_alloc(context, new_size);
+	if (!block_new) return NULL;
+	memcpy(block_new, block, old_size < new_size ? old_size : new_size);
+	gon_pool_release(context, block, old_size);
+	return block_new;
+}
+
+GonAllocator gon_pool_allocator(GonPool* pool) {
+	GonAllocator allocator = { gon_pool_alloc, gon_pool_resize, gon_pool_release, pool };
+	return allocator;
+}
+
+// Frees every block in the pool's lists (blocks still in use are not affected)
+void gon_pool_free(GonPool* pool) {
+	for (int i = 0; i < GON_POOL_CLASSES; i++) {
+		while (pool->free_lists[i]) {
+			void* next = *(void**)pool->free_lists[i];
+			free(pool->free_lists[i]);
+			pool->free_lists[i] = next;
+		}
+	}
+}
+
 // Container for the information loaded from a gon file
 typedef struct GonFile {
 	char   *file;
 	size_t  file_length;
+	size_t  file_mapping;	// length of the mapping if file was mapped by gon_load_file(), otherwise 0
+	GonAllocator *allocator;	// where the fields buffer and SIMD masks come from, or NULL for malloc
 #ifdef GON_USING_DYNAMIC_BUFFER
 	GonField *fields;
 	size_t    field_capacity;
+	bool      fields_in_file;	// fields point into a baked file (see gon_load_baked()), so they go when it does
+#ifdef GON_USING_RESERVED_FIELDS
+	size_t    field_reserved;	// number of fields the reserved range can hold, or 0 if fields was malloc'd
+#endif
 #else
 	GonField fields[GON_FIELD_BUFFER_SIZE];
 #endif
 } GonFile;
 
-// Loads a text file into the GonFile struct
-int gon_parse(GonFile* gon) {
-	if (!gon->file) return 1;
-	char* index = gon->file;
-	char* last  = &gon->file[gon->file_length];
-
-	#ifdef GON_USING_DYNAMIC_BUFFER
-	if (!gon->fields) {
-		gon->field_capacity = GON_FIELD_BUFFER_DEFAULT_SIZE;
-		gon->fields = (GonField*)malloc(gon->field_capacity * sizeof(GonField));
+// Removes the backslash from each escape in the length bytes at src, writing the result to dst (which may be the same as src), and returns the new length
+// The escapes are found with memchr and the text between them moved with memmove, both of which the C library vectorises
+static inline size_t gon_unescape(char* dst, const char* src, size_t length) {
+	const char* end = src + length;
+	char* out = dst;
+	while (src < end) {
+		const char* escape = (const char*)memchr(src, '\\', end - src);
+		if (!escape) escape = end;
+		if (out != src) memmove(out, src, escape - src);
+		out += escape - src;
+		src = escape + 1;
+		if (src < end) *out++ = *src++;		// the escaped character is kept as it is
 	}
+	return out - dst;
+}
+
+#ifndef GON_NON_DESTRUCTIVE
+// Unescapes a flagged name or value in place, and clears the flag
+static inline void gon_unescape_in_place(GonField* field, char* text, int flag) {
+	#ifdef GON_USING_COMPACT_FIELDS
+	text[gon_unescape(text, text, strlen(text))] = 0;
+	#else
+	int* length = flag == GON_FLAG_NAME_ESCAPED ? &field->name_length : &field->value_length;
+	text[*length = (int)gon_unescape(text, text, *length)] = 0;
 	#endif
+	field->flags &= ~flag;
+}
+#endif
 
-	// create root field
-	gon->fields[0].type   = GON_TYPE_OBJECT;
-	gon->fields[0].parent = 0;
-	gon->fields[0].count  = 0;
-	gon->fields[0].name   = (char*)"root";
+// Gets a field's name, or NULL if it is a value in an array
+static inline char* gon_name(const GonField* field) {
+	#ifdef GON_USING_COMPACT_FIELDS
+	if (field->name == GON_NO_NAME) return field->self ? NULL : (char*)"root";
+	char* name = gon_fields_header(field)->file + field->name;
+	#else
+	char* name = field->name;
+	#endif
+	#ifndef GON_NON_DESTRUCTIVE
+	if (field->flags & GON_FLAG_NAME_ESCAPED) gon_unescape_in_place((GonField*)field, name, GON_FLAG_NAME_ESCAPED);
+	#endif
+	return name;
+}
 
-	int field_index = 1;
-	int parent_index = 0;
-	bool in_array = 0;
+// Gets a field's value (the field must be of type GON_TYPE_FIELD)
+static inline char* gon_value(const GonField* field) {
+	#ifdef GON_USING_COMPACT_FIELDS
+	char* value = gon_fields_header(field)->file + field->value;
+	#else
+	char* value = field->value;
+	#endif
+	#ifndef GON_NON_DESTRUCTIVE
+	if (field->flags & GON_FLAG_VALUE_ESCAPED) gon_unescape_in_place((GonField*)field, value, GON_FLAG_VALUE_ESCAPED);
+	#endif
+	return value;
+}
 
-	// need to store an index so that we can defer null-ing it until we know what comes after
-	// init'd to last so that we only overwrite existing null if none has been set yet.
-	char* null_pos = last;
+// Gets the number of children of an object or array
+// Compact fields do not store this, so it is counted by stepping over the children
+static inline int gon_count(const GonField* field) {
+	#ifdef GON_USING_COMPACT_FIELDS
+	int count = 0;
+	const GonField* end = field + field->size + (field->self != 0);		// the root's size is the total field count, rather than the number of fields inside it
+	for (const GonField* child = field + 1; child < end; child += child->type == GON_TYPE_FIELD ? 1 : child->size + 1) count++;
+	return count;
+	#else
+	return field->count;
+	#endif
+}
 
-	// parse the file one field at a time
-	while (true) {
-		// skip whitespace and comments
-		while (true) {
-			while (gon_lookup_whitespace[*index]) index++;
-			if (*index == '#') {
-				while (*index != '\n') index++;
-				continue;
-			}
-			break;
-		}
+// Length of a field's name (which must not be NULL)
+static inline size_t gon_name_length(const GonField* field) {
+	#ifdef GON_USING_COMPACT_FIELDS
+	return strlen(gon_name(field));
+	#else
+	#ifndef GON_NON_DESTRUCTIVE
+	if (field->flags & GON_FLAG_NAME_ESCAPED) gon_name(field);		// unescaping shortens it
+	#endif
+	return field->name_length;
+	#endif
+}
 
-		// break at EOF
-		if (index >= last) {
-			if (parent_index != 0) {
-				puts("GON parse error: unexpected EOF.");
-				return 1;
-			}
-			break;
-		}
+// Length of a field's value (which must be of type GON_TYPE_FIELD)
+static inline size_t gon_value_length(const GonField* field) {
+	#ifdef GON_USING_COMPACT_FIELDS
+	return strlen(gon_value(field));
+	#else
+	#ifndef GON_NON_DESTRUCTIVE
+	if (field->flags & GON_FLAG_VALUE_ESCAPED) gon_value(field);
+	#endif
+	return field->value_length;
+	#endif
+}
 
-		// check if object ends
-		if (*index == ']') {
-			if (!in_array) goto L_Error;
-			goto L_StepOutOfObject;
-		}
-		if (*index == '}'){
-			if (in_array) goto L_Error;
-			goto L_StepOutOfObject;
+// Checks a field's name against a string of the given length
+// Names of a different length are rejected without looking at them
+// With compact fields, name must also be null-terminated
+static inline bool gon_name_equals(const GonField* field, const char* name, size_t length) {
+	#ifdef GON_USING_COMPACT_FIELDS
+	const char* n = gon_name(field);		// the length is not stored, so match the first length bytes and then the null after them
+	return strncmp(n, name, length) == 0 && n[length] == 0;
+	#else
+	return gon_name_length(field) == length && memcmp(field->name, name, length) == 0;
+	#endif
+}
+
+// Sets up a new field with the given parent, and no name
+// Only the members that every field needs are set; gon_init_object() or gon_set_value() sets up the rest once the field's type is known
+static inline void gon_init_field(GonField* field, int parent, int self) {
+	field->parent = parent;
+	field->flags  = 0;
+	#ifdef GON_USING_COMPACT_FIELDS
+	field->name = GON_NO_NAME;
+	field->self = self;
+	#else
+	field->name = NULL;
+	field->name_length = 0;
+	(void)self;
+	#endif
+}
+
+// Makes a field an empty object or array
+static inline void gon_init_object(GonField* field, int type) {
+	field->type = type;
+	field->size = 0;
+	#ifndef GON_USING_COMPACT_FIELDS
+	field->count = 0;
+	#ifdef GON_USING_INDEX
+	field->index = NULL;
+	#endif
+	#endif
+}
+
+// Sets a field's name to the string from name to end
+static inline void gon_set_name(GonFile* gon, GonField* field, char* name, char* end) {
+	#ifdef GON_USING_COMPACT_FIELDS
+	field->name = (unsigned int)(name - gon->file);
+	#else
+	field->name = name;
+	field->name_length = (int)(end - name);
+	(void)gon;
+	#endif
+}
+
+// Sets a field's value to the string from value to end
+static inline void gon_set_value(GonFile* gon, GonField* field, char* value, char* end) {
+	#ifdef GON_USING_COMPACT_FIELDS
+	field->value = (unsigned int)(value - gon->file);
+	#else
+	field->value = value;
+	field->value_length = (int)(end - value);
+	(void)gon;
+	#endif
+}
+
+// FNV-1a hash of a name
+static inline unsigned int gon_hash_name(const char* name, size_t length) {
+	unsigned int hash = 2166136261u;
+	for (size_t i = 0; i < length; i++) hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+	return hash;
+}
+
+#ifdef GON_USING_ATOMS
+/*
+	Atoms
+
+	Each name in the table is a GonAtom, and its key is its position in the order the names were added (starting at 1, so that 0 can mean no name).
+	The atoms are found by name through an open-addressed hash table, and by key through a directory of blocks of GON_ATOM_BLOCK_SIZE pointers.
+	Readers never take the lock. A writer fills in each new atom, block and table before publishing the pointer to it with a release store, and readers load those pointers with acquire loads, so a reader sees either nothing or the finished object.
+	When the hash table gets half full it is replaced by a copy twice the size. The old one is kept (readers may still be probing it) and is freed along with everything else by gon_atoms_free().
+*/
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#include <limits.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+// MSVC gives volatile accesses acquire and release semantics on x86 and x64, so only the compiler needs to be kept from reordering them
+#include <intrin.h>
+static inline void* gon_load_acquire_ptr(void* const* p) {
+	void* value = *(void* const volatile*)p;
+	_ReadWriteBarrier();
+	return value;
+}
+static inline void gon_store_release_ptr(void** p, void* value) {
+	_ReadWriteBarrier();
+	*(void* volatile*)p = value;
+}
+#define gon_load_acquire(p)         gon_load_acquire_ptr((void* const*)(p))
+#define gon_store_release(p, value) gon_store_release_ptr((void**)(p), (void*)(value))
+#else
+#define gon_load_acquire(p)         __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define gon_store_release(p, value) __atomic_store_n(p, value, __ATOMIC_RELEASE)
+#endif
+
+#define GON_ATOM_BLOCK_SIZE 1024
+#define GON_ATOM_TABLE_MIN  1024
+
+typedef struct GonAtom {
+	unsigned int key;
+	unsigned int hash;		// gon_hash_name() of the name
+	int          length;
+	char         name[1];	// length bytes and a null, allocated along with the atom
+} GonAtom;
+
+typedef struct GonAtomTable {
+	unsigned int         mask;		// number of slots - 1
+	struct GonAtomTable* previous;	// the table this one replaced, kept until gon_atoms_free()
+	GonAtom*             slots[1];	// mask + 1 slots, allocated along with the table (NULL if empty)
+} GonAtomTable;
+
+GonAtomTable* gon_atom_table;
+GonAtom**     gon_atom_blocks[GON_ATOM_MAX / GON_ATOM_BLOCK_SIZE + 1];
+unsigned int  gon_atom_total;	// number of atoms, only touched with the lock held
+#ifdef _WIN32
+SRWLOCK gon_atom_lock = SRWLOCK_INIT;
+static inline void gon_atom_acquire(void) { AcquireSRWLockExclusive(&gon_atom_lock); }
+static inline void gon_atom_release(void) { ReleaseSRWLockExclusive(&gon_atom_lock); }
+#else
+pthread_mutex_t gon_atom_lock = PTHREAD_MUTEX_INITIALIZER;
+static inline void gon_atom_acquire(void) { pthread_mutex_lock(&gon_atom_lock); }
+static inline void gon_atom_release(void) { pthread_mutex_unlock(&gon_atom_lock); }
+#endif
+
+// Finds a name in a hash table, or returns NULL
+static inline GonAtom* gon_atom_probe(GonAtomTable* table, const char* name, size_t length, unsigned int hash) {
+	for (unsigned int s = hash & table->mask;; s = (s + 1) & table->mask) {
+		GonAtom* atom = (GonAtom*)gon_load_acquire(&table->slots[s]);
+		if (!atom) return NULL;
+		if (atom->hash == hash && (size_t)atom->length == length && memcmp(atom->name, name, length) == 0) return atom;
+	}
+}
+
+// Puts an atom in the first free slot for its hash (with the lock held)
+static inline void gon_atom_place(GonAtomTable* table, GonAtom* atom) {
+	unsigned int s = atom->hash & table->mask;
+	while (table->slots[s]) s = (s + 1) & table->mask;
+	gon_store_release(&table->slots[s], atom);
+}
+
+// Gets the atom with the given key, or NULL if there is none
+static inline GonAtom* gon_atom_get(unsigned int key) {
+	if (!key || key > GON_ATOM_MAX) return NULL;
+	GonAtom** block = (GonAtom**)gon_load_acquire(&gon_atom_blocks[key / GON_ATOM_BLOCK_SIZE]);
+	return block ? (GonAtom*)gon_load_acquire(&block[key % GON_ATOM_BLOCK_SIZE]) : NULL;
+}
+
+// Gets the key of a name which has already been added to the table, or 0 if no field has ever had that name
+// hash is gon_hash_name() of the name if the caller already has it, or 0 to have it worked out
+// Never takes the lock
+unsigned int gon_atom_find(const char* name, size_t length, unsigned int hash) {
+	GonAtomTable* table = (GonAtomTable*)gon_load_acquire(&gon_atom_table);
+	if (!table) return 0;
+	GonAtom* atom = gon_atom_probe(table, name, length, hash ? hash : gon_hash_name(name, length));
+	return atom ? atom->key : 0;
+}
+
+// Adds a name to the table, with the lock held
+// Another thread may have added the same name since it was looked for, so the table is searched again first
+static unsigned int gon_atom_add(const char* name, size_t length, unsigned int hash) {
+	GonAtomTable* table = gon_atom_table;
+	GonAtom* atom = table ? gon_atom_probe(table, name, length, hash) : NULL;
+	if (atom) return atom->key;
+
+	unsigned int key = gon_atom_total + 1;
+	if (key > GON_ATOM_MAX || length > INT_MAX) {
+		printf("GON atom error: More than %d different names.\n", GON_ATOM_MAX);
+		return 0;
+	}
+
+	// keep the hash table at most half full
+	if (!table || key * 2 > table->mask + 1) {
+		unsigned int slot_count = table ? (table->mask + 1) * 2 : GON_ATOM_TABLE_MIN;
+		GonAtomTable* grown = (GonAtomTable*)calloc(1, sizeof(GonAtomTable) + (slot_count - 1) * sizeof(GonAtom*));
+		if (!grown) {
+			puts("GON atom error: Unable to alloc atom table.");
+			return 0;
 		}
-		goto L_ReadName;
+		grown->mask     = slot_count - 1;
+		grown->previous = table;
+		for (unsigned int k = 1; k < key; k++) gon_atom_place(grown, gon_atom_blocks[k / GON_ATOM_BLOCK_SIZE][k % GON_ATOM_BLOCK_SIZE]);
+		gon_store_release(&gon_atom_table, grown);
+		table = grown;
+	}
 
-	L_StepOutOfObject:;
-		if (parent_index == 0) {
-			printf("GON parse error: encountered unexpected token %c at field %i.\n", *index, field_index);
-			return 1;
+	GonAtom** block = gon_atom_blocks[key / GON_ATOM_BLOCK_SIZE];
+	if (!block) {
+		block = (GonAtom**)calloc(GON_ATOM_BLOCK_SIZE, sizeof(GonAtom*));
+		if (!block) {
+			puts("GON atom error: Unable to alloc atom block.");
+			return 0;
 		}
-		gon->fields[parent_index].size = field_index - parent_index - 1;	// set parent size based on current index
-		parent_index = gon->fields[parent_index].parent;					// set parent back to parent's parent
-		in_array = (gon->fields[parent_index].type == GON_TYPE_ARRAY);		// in_array = true if new parent is array type
-		*null_pos = 0;														// places null after previous field value
-		index++;															// step over } or ]
-		continue;
+		gon_store_release(&gon_atom_blocks[key / GON_ATOM_BLOCK_SIZE], block);
+	}
+	atom = (GonAtom*)malloc(sizeof(GonAtom) + length);
+	if (!atom) {
+		puts("GON atom error: Unable to alloc atom.");
+		return 0;
+	}
+	atom->key    = key;
+	atom->hash   = hash;
+	atom->length = (int)length;
+	memcpy(atom->name, name, length);
+	atom->name[length] = 0;
+	gon_store_release(&block[key % GON_ATOM_BLOCK_SIZE], atom);
+	gon_atom_place(table, atom);
+	gon_atom_total = key;
+	return key;
+}
 
-	L_ReadName:;
-		*null_pos = 0;											// places null after previous field name/value
-		gon->fields[parent_index].count++;						// increment parent object's field count
-		memset(&gon->fields[field_index], 0, sizeof(GonField));	// init new field memory to zero
-		gon->fields[field_index].parent = parent_index;			// set new field's parent index
+// Gets the key of a name, adding the name to the table if it is new
+// Returns 0 if it could not be added (the table is full, or out of memory)
+unsigned int gon_atom(const char* name, size_t length) {
+	unsigned int hash = gon_hash_name(name, length);
+	GonAtomTable* table = (GonAtomTable*)gon_load_acquire(&gon_atom_table);
+	GonAtom* atom = table ? gon_atom_probe(table, name, length, hash) : NULL;
+	if (atom) return atom->key;
 
-		// get field / object name
-		if (!in_array) {
-			gon->fields[field_index].name = index;
+	gon_atom_acquire();
+	unsigned int key = gon_atom_add(name, length, hash);
+	gon_atom_release();
+	return key;
+}
 
-			bool in_quotes = *index == '"';
-			if (in_quotes) {
-				(gon->fields[field_index].name)++;
-				index++;
-				while (*index != '"')
-					index += 1 + (*index == '\\');
-			}
-			else while (!gon_lookup_non_text[*index]) index++;
-			null_pos = index;
-			// check that objects have a name
-			if ((index - gon->fields[field_index].name) <= in_quotes) {
-				printf("GON parse error: encountered unexpected token %c at field %i.\n", *index, field_index);
-				return 1;
-			}
-			index += in_quotes;
-		}
+// Gets the (null-terminated) name with the given key, or NULL if there is no such key
+const char* gon_atom_name(unsigned int key) {
+	GonAtom* atom = gon_atom_get(key);
+	return atom ? atom->name : NULL;
+}
 
-		// skip whitespace and comments
-		while (true) {
-			while (gon_lookup_whitespace[*index]) index++;
-			if (*index == '#') {
-				while (*index != '\n') index++;
-				continue;
+// Gets the length of the name with the given key, or 0 if there is no such key
+size_t gon_atom_length(unsigned int key) {
+	GonAtom* atom = gon_atom_get(key);
+	return atom ? (size_t)atom->length : 0;
+}
+
+// Gets the number of names in the table, which is also the largest key
+unsigned int gon_atom_count(void) {
+	gon_atom_acquire();
+	unsigned int count = gon_atom_total;
+	gon_atom_release();
+	return count;
+}
+
+// Frees the whole table, so that keys start again from 1
+// Only call this once no other thread is using the table, and no keys from before it will be used again
+void gon_atoms_free(void) {
+	for (unsigned int key = 1; key <= gon_atom_total; key++) free(gon_atom_blocks[key / GON_ATOM_BLOCK_SIZE][key % GON_ATOM_BLOCK_SIZE]);
+	for (size_t b = 0; b < sizeof(gon_atom_blocks) / sizeof(gon_atom_blocks[0]); b++) {
+		free(gon_atom_blocks[b]);
+		gon_atom_blocks[b] = NULL;
+	}
+	while (gon_atom_table) {
+		GonAtomTable* previous = gon_atom_table->previous;
+		free(gon_atom_table);
+		gon_atom_table = previous;
+	}
+	gon_atom_total = 0;
+}
+
+// Gives each named field in fields[0, count) the key of its name, returning 1 if a name could not be added to the table
+// Escaped names are unescaped first (unless GON_NON_DESTRUCTIVE is defined), so that the key matches the name gon_name() returns
+static int gon_intern_fields(GonField* fields, int count) {
+	for (int i = 0; i < count; i++) {
+		GonField* field = &fields[i];
+		field->key = field->name ? gon_atom(gon_name(field), gon_name_length(field)) : 0;
+		if (field->name && !field->key) return 1;
+	}
+	return 0;
+}
+
+// Gets the key of a field's name, or 0 if it is a value in an array
+static inline unsigned int gon_key(const GonField* field) {
+	return field->key;
+}
+#endif
+
+#ifdef GON_USING_DYNAMIC_BUFFER
+// With compact fields, the buffer has one extra slot in front of it for the GonFieldsHeader
+#ifdef GON_USING_COMPACT_FIELDS
+#define GON_FIELDS_HEADER_SLOTS 1
+#else
+#define GON_FIELDS_HEADER_SLOTS 0
+#endif
+
+#ifdef GON_USING_RESERVED_FIELDS
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+void gon_free_fields(GonFile* gon);
+
+// Reserves address space for at least count fields, moving any fields already in the buffer into it
+// Nothing is committed here; pages are committed as they are first written (or by gon_resize_fields() on Windows)
+// needed is the number of fields the caller actually asked for (count may be rounded up well past it), which decides whether huge pages are worth faulting in
+int gon_reserve_fields(GonFile* gon, size_t count, size_t needed) {
+	if (count <= gon->field_reserved) return 0;
+	size_t bytes = (count + GON_FIELDS_HEADER_SLOTS) * sizeof(GonField);
+	size_t used  = gon->fields ? (gon->field_capacity + GON_FIELDS_HEADER_SLOTS) * sizeof(GonField) : 0;
+
+	#ifdef _WIN32
+	GonField* block = (GonField*)VirtualAlloc(NULL, bytes, MEM_RESERVE, PAGE_READWRITE);
+	if (!block) return 1;
+	if (used && !VirtualAlloc(block, used, MEM_COMMIT, PAGE_READWRITE)) {
+		VirtualFree(block, 0, MEM_RELEASE);
+		return 1;
+	}
+	#else
+	GonField* block = (GonField*)mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if ((void*)block == MAP_FAILED) return 1;
+	#ifdef MADV_HUGEPAGE
+	if ((needed + GON_FIELDS_HEADER_SLOTS) * sizeof(GonField) >= GON_HUGE_PAGE_MIN_SIZE) madvise(block, bytes, MADV_HUGEPAGE);
+	#endif
+	#endif
+
+	size_t capacity = 0;
+	if (used) {
+		memcpy(block, gon->fields - GON_FIELDS_HEADER_SLOTS, used);
+		capacity = gon->field_capacity;
+		gon_free_fields(gon);
+	}
+	gon->fields = block + GON_FIELDS_HEADER_SLOTS;
+	gon->field_capacity = capacity;
+	gon->field_reserved = count;
+	return 0;
+}
+#endif
+
+// Resizes the fields buffer to hold capacity fields
+int gon_resize_fields(GonFile* gon, size_t capacity) {
+	// the parsers stop at a full buffer of this size, so a doubling never takes it past the parent bits
+	#ifdef GON_USING_COMPACT_FIELDS
+	if (capacity > GON_COMPACT_MAX_FIELDS) capacity = GON_COMPACT_MAX_FIELDS;
+	#endif
+	// fields inside a baked file are never resized, but left behind for a buffer of their own
+	if (gon->fields_in_file) {
+		gon->fields = NULL;
+		gon->field_capacity = 0;
+		gon->fields_in_file = false;
+	}
+	#ifdef GON_USING_RESERVED_FIELDS
+	// grow the reservation well past what was asked for, since a new one means a copy
+	if (capacity > gon->field_reserved && gon_reserve_fields(gon, capacity * 8 > GON_RESERVED_FIELDS_MIN ? capacity * 8 : GON_RESERVED_FIELDS_MIN, capacity)) return 1;
+	#ifdef _WIN32
+	if (!VirtualAlloc(gon->fields - GON_FIELDS_HEADER_SLOTS, (capacity + GON_FIELDS_HEADER_SLOTS) * sizeof(GonField), MEM_COMMIT, PAGE_READWRITE)) return 1;
+	#endif
+	#else
+	GonField* block = gon->fields ? gon->fields - GON_FIELDS_HEADER_SLOTS : NULL;
+	GonField* fields_new = (GonField*)gon_resize(gon->allocator, block, (gon->field_capacity + GON_FIELDS_HEADER_SLOTS) * sizeof(GonField), (capacity + GON_FIELDS_HEADER_SLOTS) * sizeof(GonField));
+	if (!fields_new) return 1;
+	if (!block && GON_FIELDS_HEADER_SLOTS) memset(fields_new, 0, sizeof(GonField));
+	gon->fields = fields_new + GON_FIELDS_HEADER_SLOTS;
+	#endif
+	gon->field_capacity = capacity;
+	return 0;
+}
+
+// Frees the fields buffer
+void gon_free_fields(GonFile* gon) {
+	if (gon->fields && !gon->fields_in_file) {
+		#ifdef GON_USING_RESERVED_FIELDS
+		if (gon->field_reserved) {
+			#ifdef _WIN32
+			VirtualFree(gon->fields - GON_FIELDS_HEADER_SLOTS, 0, MEM_RELEASE);
+			#else
+			munmap(gon->fields - GON_FIELDS_HEADER_SLOTS, (gon->field_reserved + GON_FIELDS_HEADER_SLOTS) * sizeof(GonField));
+			#endif
+		}
+		else
+		#endif
+		gon_release(gon->allocator, gon->fields - GON_FIELDS_HEADER_SLOTS, (gon->field_capacity + GON_FIELDS_HEADER_SLOTS) * sizeof(GonField));
+	}
+	gon->fields = NULL;
+	gon->field_capacity = 0;
+	gon->fields_in_file = false;
+	#ifdef GON_USING_RESERVED_FIELDS
+	gon->field_reserved = 0;
+	#endif
+}
+
+// Shrinks the fields buffer to exactly the fields in use
+// A reserved buffer is copied once into one from the allocator and the reservation released; otherwise this is a realloc
+int gon_flatten_fields(GonFile* gon) {
+	size_t count = gon->fields[0].size + 1;
+	#ifdef GON_USING_RESERVED_FIELDS
+	if (gon->field_reserved) {
+		size_t bytes = (count + GON_FIELDS_HEADER_SLOTS) * sizeof(GonField);
+		GonField* block = (GonField*)gon_alloc(gon->allocator, bytes);
+		if (!block) return 1;
+		memcpy(block, gon->fields - GON_FIELDS_HEADER_SLOTS, bytes);
+		gon_free_fields(gon);
+		gon->fields = block + GON_FIELDS_HEADER_SLOTS;
+		gon->field_capacity = count;
+		return 0;
+	}
+	#endif
+	return gon_resize_fields(gon, count);
+}
+#endif
+
+/*
+	Scanning
+
+	The main loop of gon_parse only ever needs to answer four questions about the input: where does this run of whitespace end, where does this comment end, where does this naked string end, and where is the next quote or backslash inside this quoted string.
+	The functions below answer these questions, either by stepping through the lookup tables or (in GON_USING_SIMD mode) by searching the bitmasks built in the first pass.
+*/
+
+#ifdef GON_USING_SIMD
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GON_SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define GON_TARGET_AVX2
+#else
+#define GON_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// Each 64-byte block of input gets four masks, stored next to each other
+#define GON_MASK_NON_WHITESPACE 0	// bit set if the byte is not whitespace
+#define GON_MASK_NON_TEXT       1	// bit set if the byte ends a naked string (see gon_lookup_non_text)
+#define GON_MASK_QUOTE_ESCAPE   2	// bit set if the byte is a quote or backslash
+#define GON_MASK_NEWLINE        3	// bit set if the byte ends a comment
+#define GON_MASK_COUNT          4
+
+static inline int gon_ctz64(uint64_t bits) {
+	#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanForward64(&i, bits);
+	return (int)i;
+	#else
+	return __builtin_ctzll(bits);
+	#endif
+}
+
+// Returns the offset of the first byte at or after pos which has its bit set in the given mask
+// Bytes past the end of the input have every bit set, so this always terminates
+static inline size_t gon_mask_next(const uint64_t* masks, int mask, size_t pos) {
+	const uint64_t* word = &masks[(pos >> 6) * GON_MASK_COUNT + mask];
+	uint64_t bits = *word & (~0ull << (pos & 63));
+	while (!bits) {
+		word += GON_MASK_COUNT;
+		bits  = *word;
+		pos   = (pos | 63) + 1;
+	}
+	return (pos & ~(size_t)63) + gon_ctz64(bits);
+}
+
+// Builds the masks for block_count 64-byte blocks one byte at a time, using the lookup tables
+void gon_classify_blocks_scalar(const unsigned char* src, size_t block_count, uint64_t* masks) {
+	for (size_t b = 0; b < block_count; b++, src += 64, masks += GON_MASK_COUNT) {
+		uint64_t non_whitespace = 0, non_text = 0, quote_escape = 0, newline = 0;
+		for (int i = 0; i < 64; i++) {
+			unsigned char c = src[i];
+			non_whitespace |= (uint64_t)!gon_lookup_whitespace[c]      << i;
+			non_text       |= (uint64_t)gon_lookup_non_text[c]         << i;
+			quote_escape   |= (uint64_t)(c == '"' || c == '\\')       << i;
+			newline        |= (uint64_t)(c == '\n')                    << i;
+		}
+		masks[GON_MASK_NON_WHITESPACE] = non_whitespace;
+		masks[GON_MASK_NON_TEXT]       = non_text;
+		masks[GON_MASK_QUOTE_ESCAPE]   = quote_escape;
+		masks[GON_MASK_NEWLINE]        = newline;
+	}
+}
+
+#ifdef GON_SIMD_X86
+// Builds the masks 16 bytes at a time with SSE2, which every x86-64 CPU has
+void gon_classify_blocks_sse2(const unsigned char* src, size_t block_count, uint64_t* masks) {
+	#define gon_sse_eq(v, c) _mm_cmpeq_epi8(v, _mm_set1_epi8(c))
+	for (size_t b = 0; b < block_count; b++, src += 64, masks += GON_MASK_COUNT) {
+		uint64_t whitespace = 0, non_text = 0, quote_escape = 0, newline = 0;
+		for (int i = 0; i < 64; i += 16) {
+			__m128i v  = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i nl = gon_sse_eq(v, '\n');
+			__m128i ws = _mm_or_si128(_mm_or_si128(_mm_or_si128(gon_sse_eq(v, ' '), gon_sse_eq(v, '\t')), _mm_or_si128(gon_sse_eq(v, '\r'), gon_sse_eq(v, ','))), nl);
+			__m128i br = _mm_or_si128(_mm_or_si128(gon_sse_eq(v, '{'), gon_sse_eq(v, '}')), _mm_or_si128(_mm_or_si128(gon_sse_eq(v, '['), gon_sse_eq(v, ']')), gon_sse_eq(v, 0)));
+			__m128i qe = _mm_or_si128(gon_sse_eq(v, '"'), gon_sse_eq(v, '\\'));
+			whitespace   |= (uint64_t)(uint16_t)_mm_movemask_epi8(ws)                   << i;
+			non_text     |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_or_si128(ws, br)) << i;
+			quote_escape |= (uint64_t)(uint16_t)_mm_movemask_epi8(qe)                   << i;
+			newline      |= (uint64_t)(uint16_t)_mm_movemask_epi8(nl)                   << i;
+		}
+		masks[GON_MASK_NON_WHITESPACE] = ~whitespace;
+		masks[GON_MASK_NON_TEXT]       = non_text;
+		masks[GON_MASK_QUOTE_ESCAPE]   = quote_escape;
+		masks[GON_MASK_NEWLINE]        = newline;
+	}
+	#undef gon_sse_eq
+}
+
+// Builds the masks 32 bytes at a time with AVX2
+GON_TARGET_AVX2 void gon_classify_blocks_avx2(const unsigned char* src, size_t block_count, uint64_t* masks) {
+	#define gon_avx_eq(v, c) _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))
+	for (size_t b = 0; b < block_count; b++, src += 64, masks += GON_MASK_COUNT) {
+		uint64_t whitespace = 0, non_text = 0, quote_escape = 0, newline = 0;
+		for (int i = 0; i < 64; i += 32) {
+			__m256i v  = _mm256_loadu_si256((const __m256i*)(src + i));
+			__m256i nl = gon_avx_eq(v, '\n');
+			__m256i ws = _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(gon_avx_eq(v, ' '), gon_avx_eq(v, '\t')), _mm256_or_si256(gon_avx_eq(v, '\r'), gon_avx_eq(v, ','))), nl);
+			__m256i br = _mm256_or_si256(_mm256_or_si256(gon_avx_eq(v, '{'), gon_avx_eq(v, '}')), _mm256_or_si256(_mm256_or_si256(gon_avx_eq(v, '['), gon_avx_eq(v, ']')), gon_avx_eq(v, 0)));
+			__m256i qe = _mm256_or_si256(gon_avx_eq(v, '"'), gon_avx_eq(v, '\\'));
+			whitespace   |= (uint64_t)(uint32_t)_mm256_movemask_epi8(ws)                      << i;
+			non_text     |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(ws, br)) << i;
+			quote_escape |= (uint64_t)(uint32_t)_mm256_movemask_epi8(qe)                      << i;
+			newline      |= (uint64_t)(uint32_t)_mm256_movemask_epi8(nl)                      << i;
+		}
+		masks[GON_MASK_NON_WHITESPACE] = ~whitespace;
+		masks[GON_MASK_NON_TEXT]       = non_text;
+		masks[GON_MASK_QUOTE_ESCAPE]   = quote_escape;
+		masks[GON_MASK_NEWLINE]        = newline;
+	}
+	#undef gon_avx_eq
+}
+
+static inline bool gon_cpu_has_avx2(void) {
+	#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	if (!(info[2] & (1 << 27))) return false;						// OSXSAVE
+	if ((_xgetbv(0) & 6) != 6) return false;						// OS saves YMM registers
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;								// AVX2
+	#else
+	return __builtin_cpu_supports("avx2");
+	#endif
+}
+#endif
+
+typedef void (*GonClassifyProc)(const unsigned char* src, size_t block_count, uint64_t* masks);
+
+// Selects the fastest mask builder supported by the CPU we are running on
+static inline GonClassifyProc gon_classify_dispatch(void) {
+	#ifdef GON_SIMD_X86
+	if (gon_cpu_has_avx2()) return gon_classify_blocks_avx2;
+	return gon_classify_blocks_sse2;
+	#else
+	return gon_classify_blocks_scalar;
+	#endif
+}
+
+// Builds the masks for the last partial block of the input, plus one extra block past the end
+// Every byte from file_length onward has all of its bits set
+void gon_classify_tail(const char* file, size_t file_length, GonClassifyProc classify, uint64_t* masks) {
+	size_t full_blocks = file_length >> 6;
+	size_t tail_length = file_length & 63;
+
+	// copy the last partial block into a zeroed buffer so that we never read past the end of the input
+	unsigned char tail[64] = { 0 };
+	memcpy(tail, file + (full_blocks << 6), tail_length);
+	uint64_t* tail_masks = &masks[full_blocks * GON_MASK_COUNT];
+	classify(tail, 1, tail_masks);
+
+	uint64_t past_end = ~0ull << tail_length;
+	tail_masks[GON_MASK_NON_WHITESPACE] |= past_end;
+	tail_masks[GON_MASK_NON_TEXT]       |= past_end;
+	tail_masks[GON_MASK_QUOTE_ESCAPE]   |= past_end;
+	tail_masks[GON_MASK_NEWLINE]        |= past_end;
+	for (int i = 0; i < GON_MASK_COUNT; i++) tail_masks[GON_MASK_COUNT + i] = ~0ull;
+}
+
+// Size of the masks for the entire input
+static inline size_t gon_classify_size(size_t file_length) {
+	return ((file_length >> 6) + 2) * GON_MASK_COUNT * sizeof(uint64_t);
+}
+
+// Builds the masks for the entire input, in a buffer from the allocator (which may be NULL for malloc)
+uint64_t* gon_classify(const char* file, size_t file_length, GonClassifyProc classify, const GonAllocator* allocator) {
+	size_t full_blocks = file_length >> 6;
+	uint64_t* masks = (uint64_t*)gon_alloc(allocator, gon_classify_size(file_length));
+	if (!masks) return NULL;
+
+	classify((const unsigned char*)file, full_blocks, masks);
+	gon_classify_tail(file, file_length, classify, masks);
+	return masks;
+}
+#endif
+
+typedef struct GonScanner {
+	char* file;
+	char* last;
+#ifdef GON_USING_SIMD
+	uint64_t* masks;
+	// gon_parse classifies the whole input at once, but a GonReader only classifies a window of it at a time, which gon_scan_next() slides forward whenever a search runs off the end of it
+	size_t          mask_base;		// offset of the first byte covered by the masks
+	size_t          window_end;		// offset of the end of the window, or 0 if the masks cover the rest of the input
+	GonClassifyProc classify;
+#endif
+} GonScanner;
+
+#ifdef GON_USING_SIMD
+#ifndef GON_SCAN_WINDOW_BLOCKS
+#define GON_SCAN_WINDOW_BLOCKS 1024		// number of 64-byte blocks in each window
+#endif
+
+// Classifies the window of the input starting at base, which must be a multiple of 64
+// scan->masks must have room for GON_SCAN_WINDOW_BLOCKS + 2 blocks
+void gon_scan_slide(GonScanner* scan, size_t base) {
+	size_t length = (scan->last - scan->file) - base;
+	size_t blocks = length >> 6;
+	scan->mask_base = base;
+	if (blocks > GON_SCAN_WINDOW_BLOCKS) {
+		scan->classify((const unsigned char*)scan->file + base, GON_SCAN_WINDOW_BLOCKS, scan->masks);
+		for (int i = 0; i < GON_MASK_COUNT; i++) scan->masks[GON_SCAN_WINDOW_BLOCKS * GON_MASK_COUNT + i] = ~0ull;	// stops every search at the end of the window
+		scan->window_end = base + GON_SCAN_WINDOW_BLOCKS * 64;
+	}
+	else {
+		scan->classify((const unsigned char*)scan->file + base, blocks, scan->masks);
+		gon_classify_tail(scan->file + base, length, scan->classify, scan->masks);
+		scan->window_end = 0;
+	}
+}
+
+// Returns the first byte at or after index which has its bit set in the given mask
+static inline char* gon_scan_next(GonScanner* scan, int mask, char* index) {
+	size_t pos = scan->mask_base + gon_mask_next(scan->masks, mask, index - scan->file - scan->mask_base);
+	while (scan->window_end && pos >= scan->window_end) {
+		gon_scan_slide(scan, scan->window_end);
+		pos = scan->mask_base + gon_mask_next(scan->masks, mask, pos - scan->mask_base);
+	}
+	return scan->file + pos;
+}
+#endif
+
+// Steps over whitespace and comments in text, stopping at limit
+static inline size_t gon_lex_space(const char* text, size_t pos, size_t limit) {
+	while (pos < limit) {
+		if (text[pos] == '#') while (pos < limit && text[pos] != '\n') pos++;
+		else if (gon_lookup_whitespace[(unsigned char)text[pos]]) pos++;
+		else break;
+	}
+	return pos;
+}
+
+// Steps over the name or value starting at pos (quoted or not), stopping at limit
+static inline size_t gon_lex_token(const char* text, size_t pos, size_t limit) {
+	if (pos < limit && text[pos] == '"') {
+		for (pos++; pos < limit && text[pos] != '"'; pos++) pos += text[pos] == '\\';
+		return pos < limit ? pos + 1 : limit;
+	}
+	while (pos < limit && !gon_lookup_non_text[(unsigned char)text[pos]]) pos++;
+	return pos;
+}
+
+/*
+	With GON_USING_SIMD, a scanner without masks (gon_parse() leaves them out for structure-dense input, see gon_simd_worthwhile()) falls back to the lookup tables
+*/
+
+// Skips over whitespace and comments
+static inline char* gon_scan_whitespace(GonScanner* scan, char* index) {
+	#ifdef GON_USING_SIMD
+	if (scan->masks) {
+		while (true) {
+			index = gon_scan_next(scan, GON_MASK_NON_WHITESPACE, index);
+			if (index >= scan->last || *index != '#') return index;
+			index = gon_scan_next(scan, GON_MASK_NEWLINE, index);
+		}
+	}
+	#endif
+	while (true) {
+		while (gon_lookup_whitespace[(unsigned char)*index]) index++;
+		if (*index == '#') {
+			while (index < scan->last && *index != '\n') index++;
+			continue;
+		}
+		return index;
+	}
+}
+
+// Scans to the end of a naked string, returning a pointer to the first non-text character
+static inline char* gon_scan_text(GonScanner* scan, char* index) {
+	#ifdef GON_USING_SIMD
+	if (scan->masks) return gon_scan_next(scan, GON_MASK_NON_TEXT, index);
+	#endif
+	while (!gon_lookup_non_text[(unsigned char)*index]) index++;
+	return index;
+}
+
+// Scans to the end of a quoted string, returning a pointer to the closing quote (or to the end of the file if there is none)
+// index should point to the first character after the opening quote, and escaped is set to whether the string contains a backslash
+static inline char* gon_scan_quoted(GonScanner* scan, char* index, bool* escaped) {
+	#ifdef GON_USING_SIMD
+	if (scan->masks) {
+		*escaped = false;
+		while (true) {
+			index = gon_scan_next(scan, GON_MASK_QUOTE_ESCAPE, index);
+			if (index >= scan->last) return scan->last;
+			if (*index == '"') return index;
+			*escaped = true;
+			index += 2;													// step over backslash and the character it escapes
+		}
+	}
+	#endif
+	bool backslash = false;
+	while (index < scan->last && *index != '"') {
+		backslash |= *index == '\\';
+		index += 1 + (*index == '\\');
+	}
+	*escaped = backslash;
+	return index < scan->last ? index : scan->last;
+}
+
+// Places a deferred null after a name or value (or does nothing, if the input is not to be modified)
+#ifdef GON_NON_DESTRUCTIVE
+#define gon_place_null(pos) ((void)0)
+#else
+#define gon_place_null(pos) (*(pos) = 0)
+#endif
+
+// Main parsing loop, called by gon_parse once the scanner has been set up
+int gon_parse_scanned(GonFile* gon, GonScanner* scan) {
+	char* index = gon->file;
+	char* last  = &gon->file[gon->file_length];
+
+	// free the hash tables from the previous parse, if any
+	#ifdef GON_USING_INDEX
+	gon_free_index(gon);
+	#endif
+
+	// reserve room for the most fields the file could hold (every field takes at least one byte), so that the buffer never moves during the parse
+	#ifdef GON_USING_RESERVED_FIELDS
+	if (gon->field_reserved < gon->file_length + 2) {
+		gon_free_fields(gon);
+		if (gon_reserve_fields(gon, gon->file_length + 2, gon->file_length + 2)) {
+			puts("GON parse error: Unable to reserve gon fields buffer.");
+			return 1;
+		}
+	}
+	#endif
+
+	#ifdef GON_USING_DYNAMIC_BUFFER
+	if ((!gon->field_capacity || gon->fields_in_file) && gon_resize_fields(gon, GON_FIELD_BUFFER_DEFAULT_SIZE)) {
+		puts("GON parse error: Unable to alloc gon fields buffer.");
+		return 1;
+	}
+	#endif
+
+	// create root field
+	gon_init_field(&gon->fields[0], 0, 0);
+	gon_init_object(&gon->fields[0], GON_TYPE_OBJECT);
+	#ifdef GON_USING_COMPACT_FIELDS
+	gon_fields_header(gon->fields)->file = gon->file;
+	#else
+	gon->fields[0].name   = (char*)"root";
+	gon->fields[0].name_length = 4;
+	#endif
+
+	int field_index = 1;
+	int parent_index = 0;
+	bool in_array = 0;
+
+	// need to store an index so that we can defer null-ing it until we know what comes after
+	// init'd to last so that we only overwrite existing null if none has been set yet.
+	char* null_pos = last;
+
+	// parse the file one field at a time
+	while (true) {
+		// skip whitespace and comments
+		index = gon_scan_whitespace(scan, index);
+
+		// break at EOF
+		if (index >= last) {
+			if (parent_index != 0) {
+				puts("GON parse error: unexpected EOF.");
+				return 1;
 			}
 			break;
 		}
 
-		// check if we need to realloc more space for the fields
-		#ifdef GON_USING_DYNAMIC_BUFFER
-		if (field_index >= gon->field_capacity - 1) {
-			gon->field_capacity *= 2;
-			GonField* fields_new = (GonField*)realloc(gon->fields, gon->field_capacity * sizeof(GonField));
-			if (!fields_new) {
-				puts("GON parse error: Unable to realloc gon fields buffer.");
-				return 1;
-			}
-			gon->fields = fields_new;
+		// check if object ends
+		if (*index == ']') {
+			if (!in_array) goto L_Error;
+			goto L_StepOutOfObject;
+		}
+		if (*index == '}'){
+			if (in_array) goto L_Error;
+			goto L_StepOutOfObject;
+		}
+		goto L_ReadName;
+
+	L_StepOutOfObject:;
+		if (parent_index == 0) {
+			printf("GON parse error: encountered unexpected token %c at field %i.\n", *index, field_index);
+			return 1;
+		}
+		gon->fields[parent_index].size = field_index - parent_index - 1;	// set parent size based on current index
+		parent_index = gon->fields[parent_index].parent;					// set parent back to parent's parent
+		in_array = (gon->fields[parent_index].type == GON_TYPE_ARRAY);		// in_array = true if new parent is array type
+		gon_place_null(null_pos);											// places null after previous field value
+		index++;															// step over } or ]
+		continue;
+
+	L_ReadName:;
+		gon_place_null(null_pos);								// places null after previous field name/value
+		#ifndef GON_USING_COMPACT_FIELDS
+		gon->fields[parent_index].count++;						// increment parent object's field count
+		#endif
+		gon_init_field(&gon->fields[field_index], parent_index, field_index);	// set the new field's parent index and clear its name
+
+		// get field / object name
+		if (!in_array) {
+			char* name = index;
+
+			bool in_quotes = *index == '"';
+			bool escaped = false;
+			if (in_quotes) {
+				name++;
+				index++;
+				index = gon_scan_quoted(scan, index, &escaped);
+				if (index >= last) {
+					puts("GON parse error: unexpected EOF.");
+					return 1;
+				}
+			}
+			else index = gon_scan_text(scan, index);
+			null_pos = index;
+			gon_set_name(gon, &gon->fields[field_index], name, index);
+			gon->fields[field_index].flags |= escaped ? GON_FLAG_NAME_ESCAPED : in_quotes ? 0 : GON_FLAG_NAME_PLAIN;
+			// check that objects have a name
+			if (index == name) {
+				printf("GON parse error: encountered unexpected token %c at field %i.\n", *index, field_index);
+				return 1;
+			}
+			index += in_quotes;
+		}
+
+		// skip whitespace and comments
+		index = gon_scan_whitespace(scan, index);
+
+		// check if we need to realloc more space for the fields
+		#ifdef GON_USING_DYNAMIC_BUFFER
+		if (field_index >= gon->field_capacity - 1) {
+			#ifdef GON_USING_COMPACT_FIELDS
+			if (gon->field_capacity >= GON_COMPACT_MAX_FIELDS) {
+				puts("GON parse error: File has too many fields for compact fields.");
+				return 1;
+			}
+			#endif
+			if (gon_resize_fields(gon, gon->field_capacity * 2)) {
+				puts("GON parse error: Unable to realloc gon fields buffer.");
+				return 1;
+			}
+		}
+		#else
+		if (field_index >= GON_FIELD_BUFFER_SIZE) {
+			printf("GON parse error: encountered unexpected token %c at field %i.\n", *index, field_index);
+			return 1;
+		}
+		#endif
+
+		// step into object or array
+		if (*index == '{') { in_array = false; goto L_StepIntoObject; }
+		if (*index == '[') { in_array = true;  goto L_StepIntoObject; }
+		goto L_ReadValue;
+
+	L_StepIntoObject:;
+		gon_init_object(&gon->fields[field_index], GON_TYPE_OBJECT + in_array);	// set field type and clear its count
+		gon_place_null(null_pos);		// can safely place null after name after reading in '{'
+		index++;						// step over { or [
+		parent_index = field_index;		// set new parent index
+		field_index++;					// increment field index
+		continue;
+
+	L_ReadValue:;
+		// read field value
+		if (!gon_lookup_non_text[(unsigned char)*index]) {
+			gon_place_null(null_pos);												// we can safely place null after field name now
+			gon->fields[field_index].type = GON_TYPE_FIELD;							// set the gon type to field
+			char* value = index;													// the field's value string starts at the current index
+
+			bool in_quotes = *index == '"';											// if the first character of a value string is " then the value string is enclosed in quotes
+			bool escaped = false;
+			if (in_quotes) {														// if the field's value is enclosed in quotes, we need to do some extra work so that we can allow characters which are typically not allowed in naked gon string values
+				value++;															// move start of field value forward by one character so that we don't include the initial quotation mark
+				index++;															// step over the initial quotation mark
+				index = gon_scan_quoted(scan, index, &escaped);						// scan through string until we hit another (non-escaped) quotation mark, noting any escapes
+				if (index >= last) {												// error if the string is never closed
+					puts("GON parse error: unexpected EOF.");
+					return 1;
+				}
+			}
+			else index = gon_scan_text(scan, index);								// for strings not in quotes, just scan forward until the next next non-text character
+			null_pos = index;														// defer placing null after field value until either new field name or '}' or ']' is read
+			gon_set_value(gon, &gon->fields[field_index], value, index);			// set the field's value and its length
+			gon->fields[field_index].flags |= escaped ? GON_FLAG_VALUE_ESCAPED : in_quotes ? 0 : GON_FLAG_VALUE_PLAIN;	// flag it to be unescaped when first read, or as not needing quotes
+			index += in_quotes;														// step over the end quotation mark if applicable
+			field_index++;															// increment the field index
+			continue;																// go back to top of loop to parse the next field
+		}
+
+		// if token was not the start of an object, array, or valid field value then error
+	L_Error:;
+		printf("GON parse error: encountered unexpected token %c at field %i.\n", *index, field_index);
+		return 1;
+	}
+
+	gon_place_null(null_pos);				// place final null 
+	#ifdef GON_NON_DESTRUCTIVE
+	(void)null_pos;							// only tracked for the nulls, which this mode leaves out
+	#endif
+	gon->fields[0].size = field_index;		// set root object size
+
+	#ifdef GON_USING_ATOMS
+	if (gon_intern_fields(gon->fields, field_index)) return 1;
+	#endif
+
+	#ifdef GON_REALLOC_ON_COMPLETE
+	// realloc fields down to used size
+	if (gon_flatten_fields(gon)) {
+		puts("GON parse error: Unable to realloc gon fields buffer.");
+		return 1;
+	}
+	#endif
+
+	return 0;
+}
+
+// Loads a text file into the GonFile struct
+#ifdef GON_USING_SIMD
+// Decides whether the masks will pay for themselves, from the average length of the names, values and brackets in the first GON_SIMD_SAMPLE_SIZE bytes
+// Building the masks costs about the same for every byte, but they only save time on long strings, so structure-dense input is faster with the lookup tables
+static bool gon_simd_worthwhile(const char* file, size_t length) {
+	size_t limit  = length < GON_SIMD_SAMPLE_SIZE ? length : GON_SIMD_SAMPLE_SIZE;
+	size_t tokens = 0;
+	for (size_t pos = gon_lex_space(file, 0, limit); pos < limit; pos = gon_lex_space(file, pos, limit)) {
+		size_t next = gon_lex_token(file, pos, limit);
+		pos = next > pos ? next : pos + 1;			// brackets and other single characters
+		tokens++;
+	}
+	return limit >= tokens * GON_SIMD_MIN_TOKEN_LENGTH;
+}
+#endif
+
+int gon_parse(GonFile* gon) {
+	if (!gon->file) return 1;
+	#ifdef GON_USING_COMPACT_FIELDS
+	if (gon->file_length >= GON_NO_NAME) {
+		puts("GON parse error: File is too large for compact fields.");
+		return 1;
+	}
+	#endif
+	GonScanner scan = { gon->file, &gon->file[gon->file_length] };
+
+	#ifdef GON_USING_SIMD
+	if (!gon_simd_worthwhile(gon->file, gon->file_length)) return gon_parse_scanned(gon, &scan);
+	scan.masks = gon_classify(gon->file, gon->file_length, gon_classify_dispatch(), gon->allocator);
+	if (!scan.masks) {
+		puts("GON parse error: Unable to alloc SIMD masks buffer.");
+		return 1;
+	}
+	int result = gon_parse_scanned(gon, &scan);
+	gon_release(gon->allocator, scan.masks, gon_classify_size(gon->file_length));
+	return result;
+	#else
+	return gon_parse_scanned(gon, &scan);
+	#endif
+}
+
+#ifdef GON_USING_THREADS
+#ifndef GON_USING_DYNAMIC_BUFFER
+#error "GON_USING_THREADS requires GON_USING_DYNAMIC_BUFFER"
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+/*
+	Runs proc once for each of the job_count jobs, which are laid out job_size bytes apart starting at jobs.
+	The first job is run on the calling thread, and each other job gets its own thread.
+	Returns once every job has completed.
+*/
+typedef void (*GonJobProc)(void* job);
+
+typedef struct GonJobThread {
+	GonJobProc proc;
+	void*      job;
+#ifdef _WIN32
+	HANDLE     handle;
+#else
+	pthread_t  handle;
+#endif
+} GonJobThread;
+
+#ifdef _WIN32
+static unsigned __stdcall gon_job_thread_main(void* arg) {
+	GonJobThread* thread = (GonJobThread*)arg;
+	thread->proc(thread->job);
+	return 0;
+}
+#else
+static void* gon_job_thread_main(void* arg) {
+	GonJobThread* thread = (GonJobThread*)arg;
+	thread->proc(thread->job);
+	return NULL;
+}
+#endif
+
+void gon_run_jobs(GonJobProc proc, void* jobs, size_t job_size, int job_count) {
+	GonJobThread* threads = (GonJobThread*)malloc(job_count * sizeof(GonJobThread));
+	if (!threads) {
+		for (int i = 0; i < job_count; i++) proc((char*)jobs + i * job_size);	// no room to track threads, so run every job ourselves
+		return;
+	}
+	for (int i = 1; i < job_count; i++) {
+		threads[i].proc = proc;
+		threads[i].job  = (char*)jobs + i * job_size;
+		#ifdef _WIN32
+		threads[i].handle = (HANDLE)_beginthreadex(NULL, 0, gon_job_thread_main, &threads[i], 0, NULL);
+		if (!threads[i].handle) proc(threads[i].job);					// fall back to running the job ourselves
+		#else
+		if (pthread_create(&threads[i].handle, NULL, gon_job_thread_main, &threads[i]) != 0) {
+			threads[i].proc = NULL;
+			proc(threads[i].job);
+		}
+		#endif
+	}
+	proc(jobs);
+	for (int i = 1; i < job_count; i++) {
+		#ifdef _WIN32
+		if (threads[i].handle) WaitForSingleObject(threads[i].handle, INFINITE), CloseHandle(threads[i].handle);
+		#else
+		if (threads[i].proc) pthread_join(threads[i].handle, NULL);
+		#endif
+	}
+	free(threads);
+}
+
+/*
+	A span is an object or array which is opened in one chunk and closed in a later one (or never closed, in the case of the root).
+	Since no single thread sees all of its children, its size and count are filled in when the chunks are stitched back together.
+*/
+typedef struct GonSpan {
+	int type;
+	int owner;			// chunk in which the span was opened (-1 for the root)
+	int owner_index;	// which of the owner's unmatched open tokens opened the span
+	int count;
+	int close_chunk;	// chunk in which the span was closed
+	int close_index;	// index within the close chunk's run at which the span was closed
+	int global;			// index of the span's field in the final fields array
+} GonSpan;
+
+/*
+	Each thread is given one chunk of the file.
+	The tokenize pass records only the brackets which are not matched within the chunk, and whether the chunk ends between a name and its value.
+	Linking the chunks together tells each chunk which spans it starts inside of (its slots), so that the build pass can create fields with the correct types and parents.
+	Fields which belong to a span are given a parent of -(2 + slot) until they are stitched into the final array.
+*/
+typedef struct GonChunk {
+	GonFile*    gon;
+	GonScanner* scan;
+	char* start;			// where tokenizing starts
+	char* limit;			// tokenizing stops at the first token at or after limit
+	char* begin;			// first token of the chunk
+	char* end;				// first token of the next chunk
+	char* error;			// position of the first error in the chunk, if any
+	bool  alloc_failed;		// set by the tokenize or build pass if one of the chunk's buffers could not be allocated
+
+	// tokenize pass
+	unsigned char* closes;	int close_count, close_capacity;	// types of unmatched close tokens, in order
+	unsigned char* opens;	int open_count,  open_capacity;		// types of unmatched open tokens, in order
+	bool  ev_reset;			// true if the chunk contains any open or close token
+	bool  ev_toggle;		// parity of the values read since the last open or close token
+
+	// link pass
+	int*  slots;			// spans which the chunk reads fields from, starting with the innermost span at the start of the chunk
+	int   slot_count;
+	bool  start_ev;			// true if the chunk starts between a name and its value
+
+	// build pass
+	GonField* run;			int run_length, run_capacity;
+	int*  slot_counts;		// number of fields added to each slot
+	int*  slot_closes;		// run index at which each slot was closed
+	int*  open_fields;		// run index of the field for each unmatched open token
+	int*  open_counts;		// number of fields added to each unmatched open token's object or array
+	char* carry_value;		// value for the pending name from the previous chunk
+	int   carry_value_length;
+	int   carry_flags;
+	int   carry_type;		// type of the pending name from the previous chunk
+	int   carry_count;		// number of fields added to the pending name's object or array
+	int   carry_close;		// run index at which the pending name's object or array was closed (or -1)
+	#ifdef GON_USING_ATOMS
+	bool  atoms_failed;		// set by the stitch pass if a name could not be added to the atom table
+	#endif
+
+	// stitch pass
+	int   offset;			// index of the chunk's first field in the final fields array
+	GonSpan* spans;
+} GonChunk;
+
+static inline int gon_chunk_push(unsigned char** list, int* count, int* capacity, unsigned char type) {
+	if (*count == *capacity) {
+		int new_capacity = *capacity ? *capacity * 2 : 64;
+		unsigned char* new_list = (unsigned char*)realloc(*list, new_capacity);
+		if (!new_list) return 1;
+		*list = new_list;
+		*capacity = new_capacity;
+	}
+	(*list)[(*count)++] = type;
+	return 0;
+}
+
+// Tokenize pass: scans the chunk without modifying the file, recording the open and close tokens which are not matched within the chunk
+void gon_chunk_tokenize(void* job) {
+	GonChunk*   chunk = (GonChunk*)job;
+	GonScanner* scan  = chunk->scan;
+
+	chunk->close_count = chunk->open_count = 0;
+	chunk->ev_reset = chunk->ev_toggle = false;
+	chunk->error = NULL;
+	chunk->alloc_failed = false;
+
+	char* index = gon_scan_whitespace(scan, chunk->start);
+	chunk->begin = index;
+	while (index < chunk->limit) {
+		switch (*index) {
+			case '{': case '[':
+				if (gon_chunk_push(&chunk->opens, &chunk->open_count, &chunk->open_capacity, *index == '{' ? GON_TYPE_OBJECT : GON_TYPE_ARRAY)) goto L_NoMemory;
+				chunk->ev_reset  = true;
+				chunk->ev_toggle = false;
+				index++;
+				break;
+			case '}': case ']': {
+				unsigned char type = *index == '}' ? GON_TYPE_OBJECT : GON_TYPE_ARRAY;
+				if (chunk->open_count) {
+					if (chunk->opens[--chunk->open_count] != type && !chunk->error) chunk->error = index;
+				}
+				else if (gon_chunk_push(&chunk->closes, &chunk->close_count, &chunk->close_capacity, type)) goto L_NoMemory;
+				chunk->ev_reset  = true;
+				chunk->ev_toggle = false;
+				index++;
+				break;
+			}
+			case 0:
+				if (!chunk->error) chunk->error = index;
+				index++;
+				break;
+			default:
+				if (*index == '"') {
+					bool escaped;
+					index = gon_scan_quoted(scan, index + 1, &escaped);
+					if (index >= scan->last) {
+						if (!chunk->error) chunk->error = index;
+						break;
+					}
+					index++;
+				}
+				else index = gon_scan_text(scan, index);
+				if (!chunk->open_count || chunk->opens[chunk->open_count - 1] == GON_TYPE_OBJECT)
+					chunk->ev_toggle = !chunk->ev_toggle;
+				break;
+		}
+		index = gon_scan_whitespace(scan, index);
+	}
+	chunk->end = index;
+	return;
+
+L_NoMemory:;
+	chunk->alloc_failed = true;
+	chunk->end = index;
+}
+
+// Adds a field to the chunk's run, returning its index in the run, or -1 if the run could not grow
+static inline int gon_chunk_add_field(GonChunk* chunk, int* stack, int depth, int slot) {
+	if (chunk->run_length == chunk->run_capacity) {
+		int capacity = chunk->run_capacity ? chunk->run_capacity * 2 : GON_FIELD_BUFFER_DEFAULT_SIZE;
+		GonField* run = (GonField*)realloc(chunk->run, capacity * sizeof(GonField));
+		if (!run) return -1;
+		chunk->run = run;
+		chunk->run_capacity = capacity;
+	}
+	int field_index = chunk->run_length++;
+	memset(&chunk->run[field_index], 0, sizeof(GonField));
+	if (depth) {
+		int parent = stack[depth - 1];
+		chunk->run[field_index].parent = parent;
+		if (parent >= 0) chunk->run[parent].count++;
+		else             chunk->carry_count++;
+	}
+	else {
+		chunk->run[field_index].parent = -(2 + slot);
+		chunk->slot_counts[slot]++;
+	}
+	return field_index;
+}
+
+// Build pass: creates the fields for the chunk and places nulls after each name and value
+// Mirrors the main loop in gon_parse_scanned(), except that it reads tokens from begin to end rather than from the start to end of file
+void gon_chunk_build(void* job) {
+	GonChunk*   chunk = (GonChunk*)job;
+	GonScanner* scan  = chunk->scan;
+
+	// local stack of objects and arrays opened within this chunk, holding their index in the run (-1 is the pending name from the previous chunk)
+	// (the tokenize pass grew open_capacity to fit the deepest nesting in the chunk)
+	int* stack       = (int*)malloc((chunk->open_capacity + 1) * sizeof(int));
+	int* stack_types = (int*)malloc((chunk->open_capacity + 1) * sizeof(int));
+	int  depth = 0;
+	int  slot  = 0;
+	bool ev    = chunk->start_ev;
+	char* null_pos = NULL;
+
+	chunk->run_length  = 0;
+	chunk->carry_value = NULL;
+	chunk->carry_flags = 0;
+	chunk->carry_type  = 0;
+	chunk->carry_count = 0;
+	chunk->carry_close = -1;
+	chunk->slot_counts = (int*)calloc(chunk->slot_count, sizeof(int));
+	chunk->slot_closes = (int*)calloc(chunk->slot_count, sizeof(int));
+	char* index = chunk->begin;
+	if (!stack || !stack_types || !chunk->slot_counts || !chunk->slot_closes) goto L_NoMemory;
+
+	while (index < chunk->end) {
+		int  parent_type = depth ? stack_types[depth - 1] : chunk->spans[chunk->slots[slot]].type;
+		bool in_array    = parent_type == GON_TYPE_ARRAY;
+
+		if (*index == '}' || *index == ']') {
+			if (ev || (*index == ']') != in_array) goto L_Error;
+			if (depth) {
+				int field = stack[--depth];
+				if (field >= 0) chunk->run[field].size = chunk->run_length - field - 1;
+				else            chunk->carry_close = chunk->run_length;
+			}
+			else {
+				if (slot + 1 >= chunk->slot_count) goto L_Error;
+				chunk->slot_closes[slot++] = chunk->run_length;
+			}
+			if (null_pos) gon_place_null(null_pos);
+			index++;
+		}
+		else if (*index == '{' || *index == '[') {
+			int type = *index == '{' ? GON_TYPE_OBJECT : GON_TYPE_ARRAY;
+			int field;
+			if (in_array) {
+				if ((field = gon_chunk_add_field(chunk, stack, depth, slot)) < 0) goto L_NoMemory;
+			}
+			else if (ev)  field = chunk->run_length - 1;			// -1 if the name was read by the previous chunk
+			else goto L_Error;
+			if (field >= 0) chunk->run[field].type = type;
+			else            chunk->carry_type = type;
+			stack[depth] = field;
+			stack_types[depth++] = type;
+			ev = false;
+			if (null_pos) gon_place_null(null_pos);
+			index++;
+		}
+		else if (*index == 0) goto L_Error;
+		else {
+			bool  in_quotes = *index == '"';
+			bool  escaped = false;
+			char* start = index + in_quotes;
+			index = in_quotes ? gon_scan_quoted(scan, start, &escaped) : gon_scan_text(scan, index);
+			if (index >= scan->last && in_quotes) goto L_Error;
+			if (null_pos) gon_place_null(null_pos);
+
+			if (!in_array && !ev) {
+				if (index == start) goto L_Error;					// same check as in gon_parse_scanned()
+				int field = gon_chunk_add_field(chunk, stack, depth, slot);
+				if (field < 0) goto L_NoMemory;
+				chunk->run[field].name = start;
+				chunk->run[field].name_length = (int)(index - start);
+				chunk->run[field].flags |= escaped ? GON_FLAG_NAME_ESCAPED : in_quotes ? 0 : GON_FLAG_NAME_PLAIN;
+				ev = true;
+			}
+			else {
+				int field = in_array ? gon_chunk_add_field(chunk, stack, depth, slot) : chunk->run_length - 1;
+				if (field < 0 && in_array) goto L_NoMemory;
+				if (field >= 0) {
+					chunk->run[field].type  = GON_TYPE_FIELD;
+					chunk->run[field].value = start;
+					chunk->run[field].value_length = (int)(index - start);
+					chunk->run[field].flags |= escaped ? GON_FLAG_VALUE_ESCAPED : in_quotes ? 0 : GON_FLAG_VALUE_PLAIN;
+				}
+				else {
+					chunk->carry_type  = GON_TYPE_FIELD;
+					chunk->carry_value = start;
+					chunk->carry_value_length = (int)(index - start);
+					chunk->carry_flags = escaped ? GON_FLAG_VALUE_ESCAPED : in_quotes ? 0 : GON_FLAG_VALUE_PLAIN;
+				}
+				ev = false;
+			}
+			null_pos = index;
+			index += in_quotes;
+		}
+		index = gon_scan_whitespace(scan, index);
+	}
+	if (null_pos) gon_place_null(null_pos);
+
+	// record the objects and arrays which are still open at the end of the chunk
+	chunk->open_fields = (int*)malloc((depth + 1) * sizeof(int));
+	chunk->open_counts = (int*)malloc((depth + 1) * sizeof(int));
+	if (!chunk->open_fields || !chunk->open_counts) goto L_NoMemory;
+	for (int i = 0; i < depth; i++) {
+		chunk->open_fields[i] = stack[i];
+		chunk->open_counts[i] = stack[i] >= 0 ? chunk->run[stack[i]].count : chunk->carry_count;
+	}
+	free(stack);
+	free(stack_types);
+	return;
+
+L_NoMemory:;
+	chunk->alloc_failed = true;
+	free(stack);
+	free(stack_types);
+	return;
+
+L_Error:;
+	chunk->error = index;
+	free(stack);
+	free(stack_types);
+}
+
+// Stitch pass: copies the chunk's run into the final fields array, resolving the parent of each field
+void gon_chunk_stitch(void* job) {
+	GonChunk* chunk  = (GonChunk*)job;
+	GonField* fields = &chunk->gon->fields[chunk->offset];
+	for (int i = 0; i < chunk->run_length; i++) {
+		fields[i] = chunk->run[i];
+		int parent = fields[i].parent;
+		fields[i].parent = parent >= -1 ? chunk->offset + parent : chunk->spans[chunk->slots[-(parent + 2)]].global;
+	}
+	#ifdef GON_USING_ATOMS
+	chunk->atoms_failed = gon_intern_fields(fields, chunk->run_length) != 0;	// the names are all in the run, so each thread can intern its own
+	#endif
+}
+
+#ifdef GON_USING_SIMD
+typedef struct GonClassifyJob {
+	const char* file;
+	size_t      first_block, block_count;
+	uint64_t*   masks;
+	GonClassifyProc classify;
+} GonClassifyJob;
+
+void gon_classify_job(void* job) {
+	GonClassifyJob* cj = (GonClassifyJob*)job;
+	cj->classify((const unsigned char*)cj->file + (cj->first_block << 6), cj->block_count, &cj->masks[cj->first_block * GON_MASK_COUNT]);
+}
+#endif
+
+// Loads a text file into the GonFile struct using up to thread_count threads
+int gon_parse_threaded(GonFile* gon, int thread_count) {
+	if (!gon->file) return 1;
+
+	size_t max_threads = gon->file_length / GON_THREAD_MIN_CHUNK_SIZE;
+	if ((size_t)thread_count > max_threads) thread_count = (int)max_threads;
+	if (thread_count <= 1) return gon_parse(gon);
+
+	// free the hash tables from the previous parse, if any
+	#ifdef GON_USING_INDEX
+	gon_free_index(gon);
+	#endif
+
+	char* last = &gon->file[gon->file_length];
+	GonScanner scan = { gon->file, last };
+	#ifndef GON_NON_DESTRUCTIVE
+	*last = 0;
+	#endif
+
+	#ifdef GON_USING_SIMD
+	{
+		size_t full_blocks = gon->file_length >> 6;
+		GonClassifyProc classify = gon_classify_dispatch();
+		scan.masks = (uint64_t*)malloc((full_blocks + 2) * GON_MASK_COUNT * sizeof(uint64_t));
+		if (!scan.masks) {
+			puts("GON parse error: Unable to alloc SIMD masks buffer.");
+			return 1;
+		}
+		GonClassifyJob* cjobs = (GonClassifyJob*)malloc(thread_count * sizeof(GonClassifyJob));
+		if (!cjobs) {
+			puts("GON parse error: Unable to alloc SIMD classify jobs.");
+			free(scan.masks);
+			return 1;
+		}
+		for (int i = 0; i < thread_count; i++) {
+			cjobs[i].file        = gon->file;
+			cjobs[i].first_block = full_blocks *  i      / thread_count;
+			cjobs[i].block_count = full_blocks * (i + 1) / thread_count - cjobs[i].first_block;
+			cjobs[i].masks       = scan.masks;
+			cjobs[i].classify    = classify;
+		}
+		gon_run_jobs(gon_classify_job, cjobs, sizeof(GonClassifyJob), thread_count);
+		gon_classify_tail(gon->file, gon->file_length, classify, scan.masks);
+		free(cjobs);
+	}
+	#endif
+
+	int result = 1;
+	int span_count = 1, span_capacity = 64;
+	GonSpan*   spans  = (GonSpan*)malloc(span_capacity * sizeof(GonSpan));
+	int*       stack  = NULL;
+	int        depth  = 1, stack_capacity = 64;
+	bool       ev     = false;
+	GonChunk*  chunks = (GonChunk*)calloc(thread_count, sizeof(GonChunk));
+	char*      error  = NULL;
+	if (!spans || !chunks) goto L_NoMemory;
+
+	// divide the file into chunks, each of which starts at the beginning of a line
+	for (int i = 0; i < thread_count; i++) {
+		chunks[i].gon  = gon;
+		chunks[i].scan = &scan;
+		if (i == 0) chunks[i].start = gon->file;
+		else {
+			char* start = gon->file + gon->file_length / thread_count * i;
+			if (start < chunks[i - 1].start) start = chunks[i - 1].start;
+			char* newline = (char*)memchr(start, '\n', last - start);
+			chunks[i].start = newline ? newline + 1 : last;
+			chunks[i - 1].limit = chunks[i].start;
+		}
+	}
+	chunks[thread_count - 1].limit = last;
+
+	gon_run_jobs(gon_chunk_tokenize, chunks, sizeof(GonChunk), thread_count);
+	for (int i = 0; i < thread_count; i++) if (chunks[i].alloc_failed) goto L_NoMemory;
+
+	/*
+		Link the chunks together.
+		Each chunk guessed that it started outside of any quoted string. If the chunk before it actually ended somewhere else, the guess was wrong and the chunk is tokenized again from the right place.
+		Then we walk the unmatched open and close tokens of each chunk in order to find which spans each chunk starts inside of.
+	*/
+	spans[0].type   = GON_TYPE_OBJECT;
+	spans[0].owner  = -1;
+	spans[0].count  = 0;
+	spans[0].global = 0;
+	stack = (int*)malloc(stack_capacity * sizeof(int));
+	if (!stack) goto L_NoMemory;
+	stack[0] = 0;
+	for (int i = 0; i < thread_count; i++) {
+		GonChunk* chunk = &chunks[i];
+		if (i > 0 && chunk->begin != chunks[i - 1].end) {
+			chunk->start = chunks[i - 1].end;
+			if (chunk->limit < chunk->start) chunk->limit = chunk->start;
+			gon_chunk_tokenize(chunk);
+			if (chunk->alloc_failed) goto L_NoMemory;
+		}
+		if (chunk->error) { error = chunk->error; goto L_Done; }
+
+		chunk->start_ev   = ev;
+		chunk->slot_count = chunk->close_count + 1;
+		chunk->slots      = (int*)malloc(chunk->slot_count * sizeof(int));
+		if (!chunk->slots) goto L_NoMemory;
+		for (int j = 0; j < chunk->slot_count; j++) {
+			if (depth - j <= 0) { error = chunk->begin; goto L_Done; }
+			chunk->slots[j] = stack[depth - 1 - j];
+		}
+		for (int j = 0; j < chunk->close_count; j++) {
+			int span = stack[--depth];
+			if (depth == 0 || spans[span].type != chunk->closes[j]) { error = chunk->begin; goto L_Done; }
+			spans[span].close_chunk = i;
+		}
+		for (int j = 0; j < chunk->open_count; j++) {
+			if (span_count == span_capacity) {
+				GonSpan* new_spans = (GonSpan*)realloc(spans, span_capacity * 2 * sizeof(GonSpan));
+				if (!new_spans) goto L_NoMemory;
+				spans = new_spans;
+				span_capacity *= 2;
+			}
+			if (depth == stack_capacity) {
+				int* new_stack = (int*)realloc(stack, stack_capacity * 2 * sizeof(int));
+				if (!new_stack) goto L_NoMemory;
+				stack = new_stack;
+				stack_capacity *= 2;
+			}
+			spans[span_count].type        = chunk->opens[j];
+			spans[span_count].owner       = i;
+			spans[span_count].owner_index = j;
+			spans[span_count].close_chunk = -1;
+			stack[depth++] = span_count++;
+		}
+
+		int top_type = spans[stack[depth - 1]].type;
+		if (chunk->open_count) ev = top_type == GON_TYPE_OBJECT && chunk->ev_toggle;
+		else                   ev = top_type == GON_TYPE_OBJECT && ((chunk->ev_reset ? false : ev) != chunk->ev_toggle);
+	}
+	if (depth != 1) {
+		puts("GON parse error: unexpected EOF.");
+		goto L_Done;
+	}
+	if (ev) { error = last; goto L_Done; }
+
+	for (int i = 0; i < thread_count; i++) chunks[i].spans = spans;
+	gon_run_jobs(gon_chunk_build, chunks, sizeof(GonChunk), thread_count);
+
+	// work out where each chunk's run goes in the final array, and where each span's field ended up
+	{
+		int field_count = 1;
+		for (int i = 0; i < thread_count; i++) {
+			if (chunks[i].alloc_failed) goto L_NoMemory;
+			if (chunks[i].error) { error = chunks[i].error; goto L_Done; }
+			chunks[i].offset = field_count;
+			field_count += chunks[i].run_length;
+		}
+
+		if (gon->field_capacity < (size_t)field_count + 1 || !gon->fields) {
+			if (gon_resize_fields(gon, field_count + 1)) {
+				puts("GON parse error: Unable to realloc gon fields buffer.");
+				goto L_Done;
+			}
+		}
+
+		for (int s = 1; s < span_count; s++) {
+			GonChunk* owner = &chunks[spans[s].owner];
+			int field = owner->open_fields[spans[s].owner_index];
+			spans[s].count  = owner->open_counts[spans[s].owner_index];
+			spans[s].global = owner->offset + field;
+		}
+		for (int i = 0; i < thread_count; i++) {
+			for (int j = 0; j < chunks[i].slot_count; j++) {
+				GonSpan* span = &spans[chunks[i].slots[j]];
+				span->count += chunks[i].slot_counts[j];
+				if (j < chunks[i].close_count) span->close_index = chunks[i].offset + chunks[i].slot_closes[j];
+			}
+		}
+
+		gon_run_jobs(gon_chunk_stitch, chunks, sizeof(GonChunk), thread_count);
+
+		// fill in the fields which were only partially known to the threads
+		for (int i = 0; i < thread_count; i++) {
+			GonChunk* chunk = &chunks[i];
+			if (!chunk->carry_type) continue;
+			GonField* field = &gon->fields[chunk->offset - 1];
+			field->type = chunk->carry_type;
+			if (chunk->carry_type == GON_TYPE_FIELD) {
+				field->value = chunk->carry_value;
+				field->flags |= chunk->carry_flags;
+				field->value_length = chunk->carry_value_length;
+			}
+			else if (chunk->carry_close >= 0) {
+				field->size  = chunk->carry_close;
+				field->count = chunk->carry_count;
+			}
+		}
+		for (int s = 1; s < span_count; s++) {
+			GonField* field = &gon->fields[spans[s].global];
+			field->size  = spans[s].close_index - spans[s].global - 1;
+			field->count = spans[s].count;
+		}
+
+		gon->fields[0].type   = GON_TYPE_OBJECT;
+		gon->fields[0].flags  = 0;
+		gon->fields[0].parent = 0;
+		gon->fields[0].name   = (char*)"root";
+		gon->fields[0].count  = spans[0].count;
+		gon->fields[0].name_length = 4;
+		gon->fields[0].size   = field_count;
+		#ifdef GON_USING_INDEX
+		gon->fields[0].index  = NULL;
+		#endif
+		#ifdef GON_USING_ATOMS
+		gon->fields[0].key    = gon_atom("root", 4);
+		for (int i = 0; i < thread_count; i++) if (chunks[i].atoms_failed || !gon->fields[0].key) goto L_Done;
+		#endif
+		result = 0;
+	}
+	goto L_Done;
+
+L_NoMemory:;
+	puts("GON parse error: Unable to alloc threaded parse buffers.");
+L_Done:;
+	if (error) printf("GON parse error: encountered unexpected token %c at offset %zu.\n", *error, (size_t)(error - gon->file));
+	for (int i = 0; chunks && i < thread_count; i++) {
+		free(chunks[i].closes);
+		free(chunks[i].opens);
+		free(chunks[i].slots);
+		free(chunks[i].run);
+		free(chunks[i].slot_counts);
+		free(chunks[i].slot_closes);
+		free(chunks[i].open_fields);
+		free(chunks[i].open_counts);
+	}
+	free(chunks);
+	free(spans);
+	free(stack);
+	#ifdef GON_USING_SIMD
+	free(scan.masks);
+	#endif
+	return result;
+}
+#endif
+
+/*
+	Streaming
+
+	A GonParser parses a file that arrives a piece at a time, such as from a pipe or a socket, without ever needing the whole of it in memory.
+	Each chunk is passed to gon_parser_feed() as soon as it is received, and the parser picks up wherever the previous chunk left off, even in the middle of a name, a quoted string or a comment.
+	Once the input has ended, gon_parser_finish() checks that nothing was left open and completes the GonFile in parser.gon, which can then be used like any other and released with gon_free().
+
+	Since the chunks belong to the caller, the parser copies each name and value (with a null after it) into its own buffer, which becomes the GonFile's file.
+	Whitespace, comments and brackets are never stored, so the memory used is the fields plus the text of the names and values, rather than the whole input.
+	The resulting fields are the same as gon_parse() would produce for the same input, except that names and values point into that buffer.
+	The chunks are scanned with the lookup tables, since building the SIMD masks for a small chunk would cost more than it saves.
+*/
+#include <stdint.h>
+
+#ifndef GON_PARSER_BUFFER_DEFAULT_SIZE
+#define GON_PARSER_BUFFER_DEFAULT_SIZE 4096
+#endif
+
+// What the parser was in the middle of when the last chunk ran out
+typedef enum GonParserState {
+	GON_PARSER_BETWEEN = 0,		// between tokens
+	GON_PARSER_COMMENT,			// inside a comment
+	GON_PARSER_NAKED,			// inside a naked name or value
+	GON_PARSER_QUOTED,			// inside a quoted name or value
+	GON_PARSER_ESCAPED			// inside a quoted name or value, right after a backslash
+} GonParserState;
+
+typedef struct GonParser {
+	GonFile gon;				// the file being built, whose file buffer holds the names and values read so far
+	size_t  file_capacity;
+	int     field_index;		// 0 until the first chunk is fed
+	int     parent_index;
+	int     state;
+	size_t  token_start;		// offset of the name or value being read in the file buffer
+	bool    reading_name;		// whether the token being read is a name or a value
+	bool    after_name;			// whether a name has been read, and its value (or object or array) has not started yet
+	bool    in_array;
+	bool    error;
+} GonParser;
+
+GonParser gon_parser_create(void) {
+	GonParser parser;
+	memset(&parser, 0, sizeof(GonParser));
+	return parser;
+}
+
+// Sets up the buffers and the root field before the first chunk
+static int gon_parser_start(GonParser* p) {
+	GonFile* gon = &p->gon;
+	#ifdef GON_USING_DYNAMIC_BUFFER
+	if (!gon->field_capacity && gon_resize_fields(gon, GON_FIELD_BUFFER_DEFAULT_SIZE)) {
+		puts("GON parse error: Unable to alloc gon fields buffer.");
+		return 1;
+	}
+	#endif
+	gon->file = (char*)malloc(GON_PARSER_BUFFER_DEFAULT_SIZE);
+	if (!gon->file) {
+		puts("GON parse error: Unable to alloc parser buffer.");
+		return 1;
+	}
+	gon->file_length = 0;
+	p->file_capacity = GON_PARSER_BUFFER_DEFAULT_SIZE;
+
+	gon_init_field(&gon->fields[0], 0, 0);
+	gon_init_object(&gon->fields[0], GON_TYPE_OBJECT);
+	#ifndef GON_USING_COMPACT_FIELDS
+	gon->fields[0].name = (char*)"root";
+	gon->fields[0].name_length = 4;
+	#endif
+	p->field_index = 1;
+	return 0;
+}
+
+// Makes sure the parser's buffer has room for length more bytes
+// Each byte of input adds at most one byte to the buffer (a closing quote or the character after a naked string becomes the null), so feeding a chunk reserves its length up front and the appends never need to check
+static int gon_parser_reserve(GonParser* p, size_t length) {
+	GonFile* gon = &p->gon;
+	if (gon->file_length + length > p->file_capacity) {
+		size_t capacity = p->file_capacity * 2;
+		while (gon->file_length + length > capacity) capacity *= 2;
+		#ifdef GON_USING_COMPACT_FIELDS
+		if (gon->file_length + length >= GON_NO_NAME) {
+			puts("GON parse error: File is too large for compact fields.");
+			return 1;
+		}
+		#endif
+		char* file_new = (char*)realloc(gon->file, capacity);
+		if (!file_new) {
+			puts("GON parse error: Unable to realloc parser buffer.");
+			return 1;
+		}
+		gon->file = file_new;
+		p->file_capacity = capacity;
+	}
+	return 0;
+}
+
+// Appends part of a token to the parser's buffer, which must already have room for it
+static inline void gon_parser_append(GonParser* p, const char* data, size_t length) {
+	memcpy(p->gon.file + p->gon.file_length, data, length);
+	p->gon.file_length += length;
+}
+
+// Starts reading a name or value, whose first character has already been checked
+static inline int gon_parser_begin_token(GonParser* p, char c, bool is_name) {
+	p->reading_name = is_name;
+	p->token_start  = p->gon.file_length;
+	p->state = c == '"' ? GON_PARSER_QUOTED : GON_PARSER_NAKED;
+	return 0;
+}
+
+// Finishes the name or value being read, and points the current field at it
+// The buffer can still move as it grows, so in the default layout the offset is stored in place of the pointer until gon_parser_finish()
+static inline int gon_parser_end_token(GonParser* p) {
+	size_t start = p->token_start;
+	size_t end   = p->gon.file_length;
+	p->gon.file[p->gon.file_length++] = 0;
+
+	GonField* field = &p->gon.fields[p->field_index];
+	#ifdef GON_USING_COMPACT_FIELDS
+	unsigned int offset = (unsigned int)start;
+	#else
+	char* offset = (char*)(uintptr_t)start;
+	#endif
+	bool plain = p->state == GON_PARSER_NAKED;
+	p->state = GON_PARSER_BETWEEN;
+
+	if (p->reading_name) {
+		if (end == start) {
+			printf("GON parse error: encountered unexpected token \" at field %i.\n", p->field_index);
+			return 1;
+		}
+		field->name = offset;
+		#ifndef GON_USING_COMPACT_FIELDS
+		field->name_length = (int)(end - start);
+		#endif
+		if (plain) field->flags |= GON_FLAG_NAME_PLAIN;
+		p->after_name = true;
+		return 0;
+	}
+	field->type  = GON_TYPE_FIELD;
+	field->value = offset;
+	#ifndef GON_USING_COMPACT_FIELDS
+	field->value_length = (int)(end - start);
+	#endif
+	if (plain) field->flags |= GON_FLAG_VALUE_PLAIN;
+	p->field_index++;
+	p->after_name = false;
+	return 0;
+}
+
+// Handles the first character of a token, which is the same set of decisions as the main loop of gon_parse_scanned() makes
+static inline int gon_parser_step(GonParser* p, char c) {
+	GonFile* gon = &p->gon;
+	unsigned char u = (unsigned char)c;
+
+	if (!p->after_name) {
+		// check if object ends
+		if (c == ']' || c == '}') {
+			if (p->parent_index == 0 || (c == ']') != p->in_array) goto L_Error;
+			gon->fields[p->parent_index].size = p->field_index - p->parent_index - 1;
+			p->parent_index = gon->fields[p->parent_index].parent;
+			p->in_array = gon->fields[p->parent_index].type == GON_TYPE_ARRAY;
+			return 0;
+		}
+
+		// start a new field
+		#ifdef GON_USING_DYNAMIC_BUFFER
+		#ifdef GON_USING_COMPACT_FIELDS
+		if ((size_t)p->field_index >= gon->field_capacity - 1 && gon->field_capacity >= GON_COMPACT_MAX_FIELDS) {
+			puts("GON parse error: File has too many fields for compact fields.");
+			return 1;
+		}
+		#endif
+		if ((size_t)p->field_index >= gon->field_capacity - 1 && gon_resize_fields(gon, gon->field_capacity * 2)) {
+			puts("GON parse error: Unable to realloc gon fields buffer.");
+			return 1;
+		}
+		#else
+		if (p->field_index >= GON_FIELD_BUFFER_SIZE) goto L_Error;
+		#endif
+		#ifndef GON_USING_COMPACT_FIELDS
+		gon->fields[p->parent_index].count++;
+		#endif
+		gon_init_field(&gon->fields[p->field_index], p->parent_index, p->field_index);
+
+		if (!p->in_array) {
+			if (gon_lookup_non_text[u]) goto L_Error;
+			return gon_parser_begin_token(p, c, true);
+		}
+	}
+
+	// step into object or array
+	if (c == '{' || c == '[') {
+		p->in_array = c == '[';
+		gon_init_object(&gon->fields[p->field_index], GON_TYPE_OBJECT + p->in_array);
+		p->parent_index = p->field_index;
+		p->field_index++;
+		p->after_name = false;
+		return 0;
+	}
+	if (!gon_lookup_non_text[u]) {
+		p->after_name = false;
+		return gon_parser_begin_token(p, c, false);
+	}
+
+L_Error:;
+	printf("GON parse error: encountered unexpected token %c at field %i.\n", c, p->field_index);
+	return 1;
+}
+
+// Parses the next length bytes of the input
+// Returns nonzero on a parse error, after which the parser should be released with gon_free(&parser.gon)
+int gon_parser_feed(GonParser* p, const char* chunk, size_t length) {
+	if (p->error) return 1;
+	if ((!p->field_index && gon_parser_start(p)) || gon_parser_reserve(p, length + 1)) {
+		p->error = true;
+		return 1;
+	}
+
+	const char* index = chunk;
+	const char* last  = chunk + length;
+	int result = 0;
+	while (index < last && !result) {
+		switch (p->state) {
+		case GON_PARSER_BETWEEN:
+			while (index < last && gon_lookup_whitespace[(unsigned char)*index]) index++;
+			if (index == last) break;
+			if (*index == '#') {
+				p->state = GON_PARSER_COMMENT;
+				index++;
+			}
+			else {
+				result = gon_parser_step(p, *index);
+				if (p->state != GON_PARSER_NAKED) index++;					// naked names and values are read from their first character
+			}
+			break;
+
+		case GON_PARSER_COMMENT: {
+			const char* newline = (const char*)memchr(index, '\n', last - index);
+			if (!newline) return 0;
+			p->state = GON_PARSER_BETWEEN;
+			index = newline + 1;
+			break;
+		}
+
+		case GON_PARSER_NAKED: {
+			const char* start = index;
+			while (index < last && !gon_lookup_non_text[(unsigned char)*index]) index++;
+			gon_parser_append(p, start, index - start);
+			if (index < last) result = gon_parser_end_token(p);	// the character that ended the token is handled on the next pass
+			break;
+		}
+
+		case GON_PARSER_ESCAPED:
+			gon_parser_append(p, index++, 1);
+			p->state = GON_PARSER_QUOTED;
+			break;
+
+		case GON_PARSER_QUOTED: {
+			// backslashes are dropped as the text is copied, so names and values come out already unescaped
+			const char* start = index;
+			while (index < last && *index != '"') {
+				if (*index == '\\') {
+					gon_parser_append(p, start, index - start);
+					start = ++index;										// the escaped character starts the next run
+					if (index == last) {
+						p->state = GON_PARSER_ESCAPED;						// the escaped character is in the next chunk
+						break;
+					}
+				}
+				index++;
+			}
+			gon_parser_append(p, start, index - start);
+			if (index < last) {
+				index++;													// step over the closing quote
+				result = gon_parser_end_token(p);
+			}
+			break;
+		}
+		}
+	}
+	if (result) p->error = true;
+	return result;
+}
+
+// Parses the end of the input, completing the GonFile in p->gon
+// Returns nonzero if the input was not a complete gon file
+int gon_parser_finish(GonParser* p) {
+	if (!p->error && ((!p->field_index && gon_parser_start(p)) || gon_parser_reserve(p, 1))) p->error = true;
+	if (p->error) return 1;
+
+	GonFile* gon = &p->gon;
+	if (p->state == GON_PARSER_NAKED && gon_parser_end_token(p)) {
+		p->error = true;
+		return 1;
+	}
+	if (p->state == GON_PARSER_QUOTED || p->state == GON_PARSER_ESCAPED || p->after_name || p->parent_index != 0) {
+		puts("GON parse error: unexpected EOF.");
+		p->error = true;
+		return 1;
+	}
+	gon->fields[0].size = p->field_index;
+
+	// the buffer has stopped moving, so the names and values can be pointed at it
+	#ifdef GON_USING_COMPACT_FIELDS
+	gon_fields_header(gon->fields)->file = gon->file;
+	#else
+	for (int i = 1; i < p->field_index; i++) {
+		GonField* field = &gon->fields[i];
+		if (gon->fields[field->parent].type == GON_TYPE_OBJECT) field->name = gon->file + (uintptr_t)field->name;
+		if (field->type == GON_TYPE_FIELD) field->value = gon->file + (uintptr_t)field->value;
+	}
+	#endif
+
+	#ifdef GON_USING_ATOMS
+	if (gon_intern_fields(gon->fields, p->field_index)) {
+		p->error = true;
+		return 1;
+	}
+	#endif
+
+	#ifdef GON_REALLOC_ON_COMPLETE
+	if (gon_flatten_fields(gon)) {
+		puts("GON parse error: Unable to realloc gon fields buffer.");
+		return 1;
+	}
+	#endif
+	return 0;
+}
+
+/*
+	Reading
+
+	A GonReader walks through a file one token at a time, without building the GonField array.
+	This suits loaders which read each field once straight into their own structs, since only a stack of the open objects and arrays is kept, and the file is scanned with the same functions gon_parse() uses.
+	Each call to gon_reader_next() returns the next event, with the reader's name and value set as follows:
+		GON_EVENT_FIELD         name (NULL in an array) and value
+		GON_EVENT_BEGIN_OBJECT  name (NULL in an array)
+		GON_EVENT_BEGIN_ARRAY   name (NULL in an array)
+		GON_EVENT_END           the innermost object or array has ended
+		GON_EVENT_EOF           the whole file has been read
+		GON_EVENT_ERROR         the file is not valid gon (the error has been printed)
+	As with gon_parse(), the name and value are null-terminated in place, unless GON_NON_DESTRUCTIVE is defined, in which case only the lengths mark their ends.
+	Escapes in quoted names and values are removed in place as they are read. With GON_NON_DESTRUCTIVE they are left alone, and name_escaped / value_escaped say whether there are any.
+	With GON_USING_SIMD, the masks are built for GON_SCAN_WINDOW_BLOCKS blocks of the file at a time, so the memory used does not grow with the size of the file.
+*/
+typedef enum GonEvent {
+	GON_EVENT_EOF = 0,
+	GON_EVENT_FIELD,
+	GON_EVENT_BEGIN_OBJECT,
+	GON_EVENT_BEGIN_ARRAY,
+	GON_EVENT_END,
+	GON_EVENT_ERROR
+} GonEvent;
+
+typedef struct GonReader {
+	GonScanner scan;
+	char*  index;
+	char*  name;
+	size_t name_length;
+	char*  value;
+	size_t value_length;
+	int    depth;			// number of objects and arrays currently open
+	int    field_index;		// number of fields read so far, for error messages
+	bool*  in_array;		// for each open object or array, whether it is an array
+	int    stack_capacity;
+	char   pending;			// a bracket which was overwritten by the null after the last value, and has yet to be read
+	bool   error;
+	#ifdef GON_NON_DESTRUCTIVE
+	bool   name_escaped;	// the name still contains backslash escapes (see gon_unescape())
+	bool   value_escaped;	// likewise for the value
+	#endif
+} GonReader;
+
+// Sets up the reader to walk through gon->file, which must be followed by a null as for gon_parse()
+int gon_reader_init(GonReader* r, GonFile* gon) {
+	memset(r, 0, sizeof(GonReader));
+	if (!gon->file) return 1;
+	r->scan.file = gon->file;
+	r->scan.last = &gon->file[gon->file_length];
+	r->index     = gon->file;
+
+	#ifdef GON_USING_SIMD
+	r->scan.classify = gon_classify_dispatch();
+	r->scan.masks    = (uint64_t*)malloc((GON_SCAN_WINDOW_BLOCKS + 2) * GON_MASK_COUNT * sizeof(uint64_t));
+	if (!r->scan.masks) {
+		puts("GON read error: Unable to alloc SIMD masks buffer.");
+		return 1;
+	}
+	gon_scan_slide(&r->scan, 0);
+	#endif
+	return 0;
+}
+
+void gon_reader_free(GonReader* r) {
+	#ifdef GON_USING_SIMD
+	free(r->scan.masks);
+	r->scan.masks = NULL;
+	#endif
+	free(r->in_array);
+	r->in_array = NULL;
+	r->stack_capacity = 0;
+}
+
+// Reports a parse error, after which every call to gon_reader_next() returns GON_EVENT_ERROR
+static GonEvent gon_reader_error(GonReader* r, char token) {
+	if (token) printf("GON parse error: encountered unexpected token %c at field %i.\n", token, r->field_index);
+	else       puts("GON parse error: unexpected EOF.");
+	r->error = true;
+	return GON_EVENT_ERROR;
+}
+
+// Reads the next event from the file
+GonEvent gon_reader_next(GonReader* r) {
+	GonScanner* scan = &r->scan;
+	char* index = r->index;
+	char  c;
+
+	r->name  = r->value = NULL;
+	r->name_length = r->value_length = 0;
+	if (r->error) return GON_EVENT_ERROR;
+
+	if (r->pending) {
+		c = r->pending;
+		r->pending = 0;
+	}
+	else {
+		// skip whitespace and comments
+		index = gon_scan_whitespace(scan, index);
+		if (index >= scan->last) {
+			if (r->depth != 0) return gon_reader_error(r, 0);
+			r->index = index;
+			return GON_EVENT_EOF;
+		}
+		c = *index;
+	}
+	bool in_array = r->depth && r->in_array[r->depth - 1];
+
+	// check if object ends
+	if (c == ']' || c == '}') {
+		if (r->depth == 0 || (c == ']') != in_array) return gon_reader_error(r, c);
+		r->depth--;
+		r->index = index + 1;
+		return GON_EVENT_END;
+	}
+
+	// get field / object name
+	if (!in_array) {
+		char* name = index;
+		bool in_quotes = c == '"';
+		bool escaped = false;
+		if (in_quotes) {
+			name++;
+			index = gon_scan_quoted(scan, name, &escaped);
+			if (index >= scan->last) return gon_reader_error(r, 0);
+		}
+		else index = gon_scan_text(scan, index);
+		if (index == name) return gon_reader_error(r, c);
+
+		r->name        = name;
+		r->name_length = index - name;
+		#ifdef GON_NON_DESTRUCTIVE
+		r->name_escaped = escaped;
+		#else
+		if (escaped) name[r->name_length = gon_unescape(name, name, r->name_length)] = 0;
+		#endif
+		#ifndef GON_NON_DESTRUCTIVE
+		char* name_end = index;
+		#endif
+		index = gon_scan_whitespace(scan, index + in_quotes);
+		c = *index;
+		gon_place_null(name_end);					// only once the character after the name has been read, since the name may end right at a bracket
+	}
+
+	// step into object or array
+	if (c == '{' || c == '[') {
+		if (r->depth == r->stack_capacity) {
+			int capacity = r->stack_capacity ? r->stack_capacity * 2 : 16;
+			bool* stack_new = (bool*)realloc(r->in_array, capacity * sizeof(bool));
+			if (!stack_new) {
+				puts("GON read error: Unable to realloc depth stack.");
+				r->error = true;
+				return GON_EVENT_ERROR;
+			}
+			r->in_array = stack_new;
+			r->stack_capacity = capacity;
+		}
+		r->in_array[r->depth++] = c == '[';
+		r->index = index + 1;
+		r->field_index++;
+		return c == '[' ? GON_EVENT_BEGIN_ARRAY : GON_EVENT_BEGIN_OBJECT;
+	}
+
+	// read field value
+	if (!gon_lookup_non_text[(unsigned char)c]) {
+		char* value = index;
+		bool in_quotes = c == '"';
+		bool escaped = false;
+		if (in_quotes) {
+			value++;
+			index = gon_scan_quoted(scan, value, &escaped);
+			if (index >= scan->last) return gon_reader_error(r, 0);
+		}
+		else index = gon_scan_text(scan, index);
+
+		r->value        = value;
+		r->value_length = index - value;
+		#ifdef GON_NON_DESTRUCTIVE
+		r->value_escaped = escaped;
+		#else
+		if (escaped) value[r->value_length = gon_unescape(value, value, r->value_length)] = 0;
+		#endif
+		#ifndef GON_NON_DESTRUCTIVE
+		if (!in_quotes && *index && !gon_lookup_whitespace[(unsigned char)*index]) {
+			r->pending = *index;					// the value ends right at a bracket, which is read on the next call instead
+			r->index   = index;
+		}
+		else r->index = index + (index < scan->last);
+		#else
+		r->index = index + in_quotes;
+		#endif
+		gon_place_null(index);
+		r->field_index++;
+		return GON_EVENT_FIELD;
+	}
+
+	return gon_reader_error(r, c);
+}
+
+// Skips over the rest of the object or array which was just begun, up to and including its end
+GonEvent gon_reader_skip(GonReader* r) {
+	int depth = r->depth;
+	while (r->depth >= depth) {
+		GonEvent event = gon_reader_next(r);
+		if (event == GON_EVENT_ERROR || event == GON_EVENT_EOF) return event;
+	}
+	return GON_EVENT_END;
+}
+
+// How the writer treats a name or value
+#define GON_TEXT_CHECKED 0	// quoted and escaped if it needs to be
+#define GON_TEXT_PLAIN   1	// known not to need quotes (it was read without them), so copied as it is
+#define GON_TEXT_RAW     2	// still holds its escapes (which only happens with GON_NON_DESTRUCTIVE), so written in quotes exactly as it is
+
+// Picks how to write a field's name or value from its flags
+static inline int gon_text_form(const GonField* field, int escaped_flag, int plain_flag) {
+	if (field->flags & plain_flag) return GON_TEXT_PLAIN;
+	#ifdef GON_NON_DESTRUCTIVE
+	if (field->flags & escaped_flag) return GON_TEXT_RAW;
+	#else
+	(void)escaped_flag;
+	#endif
+	return GON_TEXT_CHECKED;
+}
+
+/*
+	Writing
+
+	gon_serialize(), gon_serialize_file() and the GonFilePrinter all write through a GonWriter, which keeps a destination pointer and the room left there.
+	When writing to a file, the destination is a staging buffer which is handed to fwrite() each time it fills up, rather than making a call per character. When writing to memory, it is the caller's buffer.
+	Each name and value is checked for characters that need quotes in one pass (16 bytes at a time with GON_USING_SIMD on x86), and copied with memcpy, in runs between any characters that need escaping.
+	Passing GON_MINIFIED as the tab width leaves out the indentation and newlines, putting single spaces only where the parser needs something between two tokens.
+*/
+#define GON_MINIFIED (-1)
+
+typedef struct GonWriter {
+	char*  dst;			// where the next byte goes
+	size_t room;		// bytes left at dst
+	char*  buffer;		// start of the staging buffer, when writing to a file
+	size_t buffer_size;
+	FILE*  fp;			// file the staging buffer is flushed to, or NULL when writing to memory
+	size_t dropped;		// bytes which did not fit when writing to memory
+	int    tab_width;	// GON_MINIFIED for no indentation
+	int    indent;
+	bool   space;		// (minified) the next name or value needs a space before it
+} GonWriter;
+
+static inline GonWriter gon_writer_memory(char* dst, size_t room, int tab_width) {
+	GonWriter w;
+	memset(&w, 0, sizeof(w));
+	w.dst       = dst;
+	w.room      = room;
+	w.tab_width = tab_width;
+	return w;
+}
+
+static inline GonWriter gon_writer_file(FILE* fp, char* buffer, size_t buffer_size, int tab_width) {
+	GonWriter w = gon_writer_memory(buffer, buffer_size, tab_width);
+	w.buffer      = buffer;
+	w.buffer_size = buffer_size;
+	w.fp          = fp;
+	return w;
+}
+
+// Hands everything in the staging buffer to fwrite
+static inline void gon_writer_flush(GonWriter* w) {
+	if (!w->fp) return;
+	if (w->dst != w->buffer) fwrite(w->buffer, 1, w->dst - w->buffer, w->fp);
+	w->dst  = w->buffer;
+	w->room = w->buffer_size;
+}
+
+// Slow path of gon_writer_put(), for when the data does not fit in the room left
+static void gon_writer_spill(GonWriter* w, const char* data, size_t length) {
+	if (w->fp) {
+		gon_writer_flush(w);
+		if (length >= w->buffer_size) {
+			fwrite(data, 1, length, w->fp);	// too big to be worth staging
+			return;
+		}
+		memcpy(w->dst, data, length);
+		w->dst  += length;
+		w->room -= length;
+		return;
+	}
+	size_t fit = w->room;
+	if (fit) {
+		memcpy(w->dst, data, fit);
+		w->dst += fit;
+		w->room = 0;
+	}
+	w->dropped += length - fit;
+}
+
+static inline void gon_writer_put(GonWriter* w, const char* data, size_t length) {
+	if (length <= w->room) {
+		memcpy(w->dst, data, length);
+		w->dst  += length;
+		w->room -= length;
+	}
+	else if (!w->room && !w->fp) w->dropped += length;	// out of room (or only measuring)
+	else gon_writer_spill(w, data, length);
+}
+
+static inline void gon_writer_putc(GonWriter* w, char c) {
+	if (w->room) {
+		*w->dst++ = c;
+		w->room--;
+	}
+	else if (!w->fp) w->dropped++;
+	else gon_writer_spill(w, &c, 1);
+}
+
+static inline void gon_writer_indent(GonWriter* w) {
+	static const char spaces[] = "                                                                ";
+	int indent = w->indent;
+	while (indent > 0) {
+		int n = indent < (int)sizeof(spaces) - 1 ? indent : (int)sizeof(spaces) - 1;
+		gon_writer_put(w, spaces, n);
+		indent -= n;
+	}
+}
+
+// Returns the offset of the first byte which cannot be written in a naked string (see gon_lookup_non_text, plus " and \), or length if there is none
+static inline size_t gon_find_unsafe(const char* text, size_t length) {
+	size_t i = 0;
+	#ifdef GON_SIMD_X86
+	#define gon_sse_eq(v, c) _mm_cmpeq_epi8(v, _mm_set1_epi8(c))
+	for (; i + 16 <= length; i += 16) {
+		__m128i v  = _mm_loadu_si128((const __m128i*)(text + i));
+		__m128i ws = _mm_or_si128(_mm_or_si128(gon_sse_eq(v, ' '), gon_sse_eq(v, '\t')), _mm_or_si128(_mm_or_si128(gon_sse_eq(v, '\n'), gon_sse_eq(v, '\r')), gon_sse_eq(v, ',')));
+		__m128i br = _mm_or_si128(_mm_or_si128(gon_sse_eq(v, '{'), gon_sse_eq(v, '}')), _mm_or_si128(_mm_or_si128(gon_sse_eq(v, '['), gon_sse_eq(v, ']')), gon_sse_eq(v, 0)));
+		__m128i qe = _mm_or_si128(gon_sse_eq(v, '"'), gon_sse_eq(v, '\\'));
+		unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(ws, br), qe));
+		if (mask) return i + gon_ctz64(mask);
+	}
+	#undef gon_sse_eq
+	#endif
+	for (; i < length; i++) {
+		unsigned char c = (unsigned char)text[i];
+		if (gon_lookup_non_text[c] || c == '"' || c == '\\') return i;
+	}
+	return length;
+}
+
+// Returns the offset of the first " or \ in text, or length if there is none
+static inline size_t gon_find_escape(const char* text, size_t length) {
+	size_t i = 0;
+	#ifdef GON_SIMD_X86
+	for (; i + 16 <= length; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(text + i));
+		unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))));
+		if (mask) return i + gon_ctz64(mask);
+	}
+	#endif
+	for (; i < length; i++) if (text[i] == '"' || text[i] == '\\') return i;
+	return length;
+}
+
+// Gets the length of a name or value as gon_writer_text() would write it
+static inline size_t gon_text_size(const char* text, size_t length, int form) {
+	if (form == GON_TEXT_PLAIN) return length;
+	size_t unsafe = (form == GON_TEXT_RAW || length == 0 || text[0] == '#') ? 0 : gon_find_unsafe(text, length);
+	if (unsafe == length && length) return length;
+	size_t size = length + 2;
+	if (form == GON_TEXT_RAW) return size;
+	for (size_t run = unsafe + gon_find_escape(text + unsafe, length - unsafe); run < length; run += 1 + gon_find_escape(text + run + 1, length - run - 1)) size++;
+	return size;
+}
+
+// Writes a name or value, in quotes and with \ and " escaped if it needs them (see GON_TEXT_*)
+static void gon_writer_text(GonWriter* w, const char* text, size_t length, int form) {
+	if (!w->room && !w->fp) {
+		w->dropped += gon_text_size(text, length, form);	// out of room (or only measuring), so there is nothing to copy
+		return;
+	}
+	if (form == GON_TEXT_PLAIN) {
+		gon_writer_put(w, text, length);
+		return;
+	}
+	size_t unsafe = (form == GON_TEXT_RAW || length == 0 || text[0] == '#') ? 0 : gon_find_unsafe(text, length);
+	if (unsafe == length && length) {
+		gon_writer_put(w, text, length);
+		return;
+	}
+
+	gon_writer_putc(w, '"');
+	if (form == GON_TEXT_RAW) gon_writer_put(w, text, length);
+	else {
+		// nothing before the first unsafe byte needs escaping, so the search for escapes can start there
+		size_t run = unsafe + gon_find_escape(text + unsafe, length - unsafe);
+		while (run < length) {
+			char escaped[2] = { '\\', text[run] };
+			gon_writer_put(w, text, run);
+			gon_writer_put(w, escaped, 2);
+			text   += run + 1;
+			length -= run + 1;
+			run     = gon_find_escape(text, length);
+		}
+		gon_writer_put(w, text, length);
+	}
+	gon_writer_putc(w, '"');
+}
+
+static inline void gon_writer_name(GonWriter* w, const char* name, size_t length, int form) {
+	if (w->tab_width == GON_MINIFIED) {
+		if (w->space) gon_writer_putc(w, ' ');
+		gon_writer_text(w, name, length, form);
+		w->space = true;
+		return;
+	}
+	gon_writer_indent(w);
+	gon_writer_text(w, name, length, form);
+	gon_writer_putc(w, ' ');
+}
+
+static inline void gon_writer_value(GonWriter* w, const char* value, size_t length, int form, bool in_array) {
+	if (w->tab_width == GON_MINIFIED) {
+		if (w->space) gon_writer_putc(w, ' ');
+		gon_writer_text(w, value, length, form);
+		w->space = true;
+		return;
+	}
+	gon_writer_text(w, value, length, form);
+	gon_writer_putc(w, in_array ? ' ' : '\n');
+}
+
+// Writes the start of an object or array
+static inline void gon_writer_open(GonWriter* w, bool array) {
+	if (w->tab_width == GON_MINIFIED) {
+		if (w->space) gon_writer_putc(w, ' ');	// the parser needs a naked value ended before an opening bracket
+		gon_writer_putc(w, array ? '[' : '{');
+		w->space = false;
+		return;
+	}
+	gon_writer_put(w, array ? "[ " : "{\n", 2);
+	w->indent += w->tab_width;
+}
+
+// Writes the end of an object or array, followed by the separator its parent uses
+static inline void gon_writer_close(GonWriter* w, bool array, bool parent_is_array) {
+	if (w->tab_width == GON_MINIFIED) {
+		gon_writer_putc(w, array ? ']' : '}');
+		w->space = false;
+		return;
+	}
+	w->indent -= w->tab_width;
+	if (!array) gon_writer_indent(w);
+	gon_writer_putc(w, array ? ']' : '}');
+	gon_writer_putc(w, parent_is_array ? ' ' : '\n');
+}
+
+// Writes every field of the GonFile, walking the flat field array in order
+static void gon_write_fields(GonWriter* w, GonFile* gon) {
+	int parent_index = 0;
+	int field_index  = 1;
+	bool in_array	 = 0;
+
+	while (1) {
+		if (field_index >= gon->fields[0].size && parent_index == 0) break;
+
+		// check if object ends
+		if (field_index - parent_index > gon->fields[parent_index].size) {
+			parent_index = gon->fields[parent_index].parent;				// set parent index to grandparent
+			bool parent_is_array = (gon->fields[parent_index].type == GON_TYPE_ARRAY);
+			gon_writer_close(w, in_array, parent_is_array);
+			in_array = parent_is_array;
+			continue;
+		}
+
+		GonField* field = &gon->fields[field_index];
+
+		// write field name, quoting and escaping as necessary
+		if (!in_array) gon_writer_name(w, gon_name(field), gon_name_length(field), gon_text_form(field, GON_FLAG_NAME_ESCAPED, GON_FLAG_NAME_PLAIN));
+
+		// write field value
+		if (field->type == GON_TYPE_FIELD) {
+			gon_writer_value(w, gon_value(field), gon_value_length(field), gon_text_form(field, GON_FLAG_VALUE_ESCAPED, GON_FLAG_VALUE_PLAIN), in_array);
+			field_index++;
+			continue;
+		}
+
+		// step into object
+		in_array = (field->type == GON_TYPE_ARRAY);
+		gon_writer_open(w, in_array);
+		parent_index = field_index;
+		field_index++;
+	}
+}
+
+// Writes the contents of the GonFile to the buffer at dest
+// Buffer must be pre-allocated by caller, with room for gon_serialized_size() bytes plus the null
+void gon_serialize(GonFile* gon, char* dst, int tab_width) {
+	GonWriter w = gon_writer_memory(dst, (size_t)-1, tab_width);
+	gon_write_fields(&w, gon);
+	*w.dst = '\0'; // write null to end of file
+}
+
+// Same as gon_serialize(), but writes at most capacity bytes (including the null) to dst, like snprintf
+// Returns the length of the whole output, not counting the null, so a result >= capacity means the output was cut short
+size_t gon_serialize_n(GonFile* gon, char* dst, size_t capacity, int tab_width) {
+	GonWriter w = gon_writer_memory(dst, capacity, tab_width);
+	gon_write_fields(&w, gon);
+	size_t length = capacity - w.room + w.dropped;
+	if (w.room) *w.dst = '\0';
+	else if (capacity) dst[capacity - 1] = '\0';
+	return length;
+}
+
+// Gets the exact length gon_serialize() will write with this tab width, not counting the null
+// This runs the same writer with nowhere to put the output, so it costs the quote and escape checks but none of the copying
+size_t gon_serialized_size(GonFile* gon, int tab_width) {
+	return gon_serialize_n(gon, NULL, 0, tab_width);
+}
+
+void gon_serialize_file(GonFile* gon, FILE* fp, int tab_width) {
+	char buffer[GON_WRITE_BUFFER_SIZE];
+	GonWriter w = gon_writer_file(fp, buffer, sizeof(buffer), tab_width);
+	gon_write_fields(&w, gon);
+	gon_writer_putc(&w, '\n');	// end the file with a newline (probably not necessary, but its not hurting anything either)
+	gon_writer_flush(&w);
+}
+
+#ifdef GON_USING_INDEX
+
+// Gets a pointer to an object's hash table pointer
+// With compact fields, the table pointers live in an array hanging off of the GonFieldsHeader, which is only created if create is true (otherwise this returns NULL until it exists)
+static inline GonIndex** gon_index_slot(GonField* object, bool create) {
+	#ifdef GON_USING_COMPACT_FIELDS
+	GonFieldsHeader* header = gon_fields_header(object);
+	if (!header->indices) {
+		if (!create) return NULL;
+		GonField* root = (GonField*)header + 1;
+		header->indices = (GonIndex**)calloc(root->size, sizeof(GonIndex*));
+		if (!header->indices) return NULL;
+	}
+	return &header->indices[object->self];
+	#else
+	(void)create;
+	return &object->index;
+	#endif
+}
+
+// Builds the hash table for a single object
+// Only the first child with a given name is added, so that lookups return the same field as a linear search would
+int gon_index_object(GonField* object) {
+	GonIndex** table = gon_index_slot(object, true);
+	if (!table) return 1;
+
+	int count = gon_count(object);
+	int slot_count = 1;
+	while (slot_count < count * 2) slot_count *= 2;
+
+	int lookups = *table ? (*table)->lookups : 0;
+	GonIndex* index = (GonIndex*)realloc(*table, sizeof(GonIndex) + slot_count * sizeof(GonIndexSlot));
+	if (!index) return 1;
+	GonIndexSlot* slots = (GonIndexSlot*)(index + 1);
+	memset(slots, 0, slot_count * sizeof(GonIndexSlot));
+	index->lookups = lookups;
+	index->mask    = slot_count - 1;
+	*table = index;
+
+	GonField* field = object + 1;
+	for (int i = 0; i < count; i++) {
+		char*  name   = gon_name(field);
+		size_t length = gon_name_length(field);
+		unsigned int hash = gon_hash_name(name, length);
+		int s = hash & index->mask;
+		while (slots[s].child) {
+			if (slots[s].hash == hash && gon_name_equals(&object[slots[s].child], name, length)) break;
+			s = (s + 1) & index->mask;
+		}
+		if (!slots[s].child) {
+			slots[s].hash  = hash;
+			slots[s].child = (int)(field - object);
+		}
+		if (field->type != GON_TYPE_FIELD) field += field->size;
+		field++;
+	}
+	return 0;
+}
+
+// Builds hash tables for every object in the file which has at least GON_INDEX_MIN_COUNT children
+int gon_build_index(GonFile* gon) {
+	for (int i = 0; i < gon->fields[0].size; i++) {
+		GonField* field = &gon->fields[i];
+		if (field->type != GON_TYPE_OBJECT) continue;
+		GonIndex** table = gon_index_slot(field, false);
+		if (table && *table && (*table)->mask) continue;
+		if (gon_count(field) >= GON_INDEX_MIN_COUNT && gon_index_object(field)) return 1;
+	}
+	return 0;
+}
+
+// Frees all of the hash tables in the file
+void gon_free_index(GonFile* gon) {
+	if (!gon->fields) return;
+	#ifdef GON_USING_COMPACT_FIELDS
+	GonFieldsHeader* header = gon_fields_header(gon->fields);
+	if (!header->indices) return;
+	for (int i = 0; i < gon->fields[0].size; i++) free(header->indices[i]);
+	free(header->indices);
+	header->indices = NULL;
+	#else
+	for (int i = 0; i < gon->fields[0].size; i++) {
+		GonField* field = &gon->fields[i];
+		if (field->type != GON_TYPE_FIELD && field->index) {
+			free(field->index);
+			field->index = NULL;
+		}
+	}
+	#endif
+}
+#endif
+
+// Gets the first child of an object with the given name, or NULL
+// hash is gon_hash_name() of the name if the caller already has it, or 0 to have it worked out only if the object has a hash table
+static GonField* gon_find_child(GonField* parent, const char* name, size_t length, unsigned int hash) {
+	#ifdef GON_USING_INDEX
+	// compact fields do not store a child count, so the number of fields inside the object stands in for it
+	#ifdef GON_USING_COMPACT_FIELDS
+	if (parent->size >= GON_INDEX_MIN_COUNT) {
+	#else
+	if (parent->count >= GON_INDEX_MIN_COUNT) {
+	#endif
+		GonIndex** table = gon_index_slot(parent, GON_INDEX_ADAPTIVE_LOOKUPS > 0);
+		GonIndex*  index = table ? *table : NULL;
+		#if GON_INDEX_ADAPTIVE_LOOKUPS > 0
+		if (table && !index) {
+			index = *table = (GonIndex*)calloc(1, sizeof(GonIndex));
+		}
+		if (index && !index->mask && ++index->lookups > GON_INDEX_ADAPTIVE_LOOKUPS) {
+			gon_index_object(parent);
+			index = *table;
+		}
+		#endif
+		if (index && index->mask) {
+			GonIndexSlot* slots = (GonIndexSlot*)(index + 1);
+			if (!hash) hash = gon_hash_name(name, length);
+			for (int s = hash & index->mask; slots[s].child; s = (s + 1) & index->mask) {
+				if (slots[s].hash == hash && gon_name_equals(&parent[slots[s].child], name, length))
+					return &parent[slots[s].child];
+			}
+			return NULL;
+		}
+	}
+	#else
+	(void)hash;
+	#endif
+
+	// with atoms, the name is looked up once and then compared with each child's key (a name which is not in the table is on no field at all)
+	#ifdef GON_USING_ATOMS
+	unsigned int key = gon_atom_find(name, length, hash);
+	if (!key) return NULL;
+	#endif
+
+	GonField* field = parent + 1;
+	#ifdef GON_USING_COMPACT_FIELDS
+	GonField* end = parent + parent->size + (parent->self != 0);	// the root's size is the total field count, rather than the number of fields inside it
+	while (field < end) {
+	#else
+	for (int i = 0; i < parent->count; i++) {
+	#endif
+		#ifdef GON_USING_ATOMS
+		if (field->key == key)
+		#else
+		if (gon_name_equals(field, name, length))
+		#endif
+			return field;
+		if (field->type != GON_TYPE_FIELD) // step over sub-fields of object and array types
+			field += field->size;
+		field++;
+	}
+	return NULL;
+}
+
+// Gets the first child field with the given name if it exists, otherwise returns NULL
+// Assumes that parent is not NULL
+GonField* gon_get_field(GonField* parent, const char* name) {
+	if (!parent) {
+		printf("Tried to get field \"%s\" from null gon.", name);
+		return NULL;
+	} else if (parent->type != GON_TYPE_OBJECT) {
+		char* parent_name = gon_name(parent) ? gon_name(parent) : (char*)"NULL";
+		printf("Tried to get field \"%s\" from non-object gon \"%s\".", name, parent_name);
+		return NULL;
+	}
+	return gon_find_child(parent, name, strlen(name), 0);
+}
+
+#ifdef GON_USING_ATOMS
+// Gets the first child of an object whose name has the given key (from gon_atom() or gon_key()), or NULL
+// Every comparison is between two keys, and an object with a hash table is searched through it
+GonField* gon_get_field_key(GonField* parent, unsigned int key) {
+	if (!parent || parent->type != GON_TYPE_OBJECT || !key) return NULL;
+	#ifdef GON_USING_INDEX
+	if (parent->index && parent->index->mask) {
+		GonAtom* atom = gon_atom_get(key);
+		if (!atom) return NULL;
+		GonIndexSlot* slots = (GonIndexSlot*)(parent->index + 1);
+		unsigned int  hash  = atom->hash;
+		for (int s = hash & parent->index->mask; slots[s].child; s = (s + 1) & parent->index->mask) {
+			if (slots[s].hash == hash && parent[slots[s].child].key == key) return &parent[slots[s].child];
+		}
+		return NULL;
+	}
+	#endif
+	GonField* field = parent + 1;
+	for (int i = 0; i < parent->count; i++) {
+		if (field->key == key) return field;
+		if (field->type != GON_TYPE_FIELD) field += field->size;
+		field++;
+	}
+	return NULL;
+}
+#endif
+
+/*
+	Typed Values
+
+	gon_read_int64(), gon_read_double() and gon_read_bool() convert a value of the given length, and never depend on the locale.
+	They accept the whole value or nothing: an optional sign and digits for integers, the usual decimal and exponent forms for doubles, and true or false for bools.
+	Anything else is GON_VALUE_INVALID, and a number that does not fit is GON_VALUE_RANGE. The output is only written on success.
+	Doubles with up to 15 significant digits and a small exponent (which covers nearly every hand-written number) are converted exactly with a single multiply or divide.
+	Other doubles fall back to strtod on a copy with the locale's decimal point swapped in, so they are still correctly rounded.
+	gon_field_int64() and friends do the same for a GonField, and return GON_VALUE_MISSING if it is NULL or not a value.
+*/
+#include <float.h>
+#include <limits.h>
+#include <locale.h>
+
+typedef enum GonValueError {
+	GON_VALUE_OK      = 0,
+	GON_VALUE_MISSING = 1,	// no field, or the field is an object or array
+	GON_VALUE_INVALID = 2,	// the value is not of the requested type
+	GON_VALUE_RANGE   = 3	// the value is a number too large for the requested type
+} GonValueError;
+
+GonValueError gon_read_int64(const char* text, size_t length, int64_t* out) {
+	const char* index = text;
+	const char* end   = text + length;
+	bool negative = index < end && *index == '-';
+	if (index < end && (*index == '-' || *index == '+')) index++;
+	if (index == end) return GON_VALUE_INVALID;
+
+	uint64_t value = 0;
+	for (; index < end; index++) {
+		unsigned int digit = (unsigned char)*index - '0';
+		if (digit > 9) return GON_VALUE_INVALID;
+		if (value > (UINT64_MAX - digit) / 10) return GON_VALUE_RANGE;
+		value = value * 10 + digit;
+	}
+	if (value > (uint64_t)INT64_MAX + negative) return GON_VALUE_RANGE;
+	*out = negative ? (int64_t)(0 - value) : (int64_t)value;
+	return GON_VALUE_OK;
+}
+
+// Powers of ten which are exactly representable as doubles
+static const double gon_powers_of_ten[23] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Converts with strtod, after swapping the locale's decimal point in for '.'
+static GonValueError gon_read_double_slow(const char* text, size_t length, double* out) {
+	const char* point = localeconv()->decimal_point;
+	size_t point_length = strlen(point);
+	char  stack_buffer[128];
+	char* buffer = length * point_length < sizeof(stack_buffer) ? stack_buffer : (char*)malloc(length * point_length + 1);
+	if (!buffer) return GON_VALUE_RANGE;
+
+	char* dst = buffer;
+	for (size_t i = 0; i < length; i++) {
+		if (text[i] == '.') memcpy(dst, point, point_length), dst += point_length;
+		else *dst++ = text[i];
+	}
+	*dst = 0;
+	double value = strtod(buffer, NULL);
+	if (buffer != stack_buffer) free(buffer);
+
+	if (value > DBL_MAX || value < -DBL_MAX) return GON_VALUE_RANGE;
+	*out = value;
+	return GON_VALUE_OK;
+}
+
+GonValueError gon_read_double(const char* text, size_t length, double* out) {
+	const char* index = text;
+	const char* end   = text + length;
+	bool negative = index < end && *index == '-';
+	if (index < end && (*index == '-' || *index == '+')) index++;
+
+	// read up to 19 significant digits into mantissa, noting whether any non-zero digits past those were dropped
+	uint64_t mantissa = 0;
+	int  significant = 0, exponent = 0;
+	bool any_digits = false, truncated = false;
+	for (; index < end && (unsigned int)((unsigned char)*index - '0') <= 9; index++) {
+		any_digits = true;
+		if (significant < 19) {
+			mantissa = mantissa * 10 + (*index - '0');
+			significant += mantissa != 0;
+		}
+		else {
+			exponent++;
+			truncated |= *index != '0';
+		}
+	}
+	if (index < end && *index == '.') {
+		for (index++; index < end && (unsigned int)((unsigned char)*index - '0') <= 9; index++) {
+			any_digits = true;
+			if (significant < 19) {
+				mantissa = mantissa * 10 + (*index - '0');
+				significant += mantissa != 0;
+				exponent--;
+			}
+			else truncated |= *index != '0';
+		}
+	}
+	if (!any_digits) return GON_VALUE_INVALID;
+
+	if (index < end && (*index == 'e' || *index == 'E')) {
+		index++;
+		bool exponent_negative = index < end && *index == '-';
+		if (index < end && (*index == '-' || *index == '+')) index++;
+		if (index == end) return GON_VALUE_INVALID;
+		int written = 0;
+		for (; index < end && (unsigned int)((unsigned char)*index - '0') <= 9; index++) {
+			if (written < 100000) written = written * 10 + (*index - '0');
+		}
+		exponent += exponent_negative ? -written : written;
+	}
+	if (index != end) return GON_VALUE_INVALID;
+
+	// both the mantissa and the power of ten are exact here, so one operation rounds correctly
+	if (!truncated && mantissa <= (1ull << 53)) {
+		double value = (double)mantissa;
+		if (mantissa == 0) {
+			*out = negative ? -0.0 : 0.0;
+			return GON_VALUE_OK;
+		}
+		if (exponent >= -22 && exponent <= 22) {
+			value = exponent < 0 ? value / gon_powers_of_ten[-exponent] : value * gon_powers_of_ten[exponent];
+			*out = negative ? -value : value;
+			return GON_VALUE_OK;
+		}
+		// a mantissa with room to spare can take some of a larger exponent and stay exact
+		if (exponent > 22 && exponent <= 22 + 15) {
+			uint64_t scaled = mantissa;
+			for (int i = 22; i < exponent && scaled <= (1ull << 53); i++) scaled *= 10;
+			if (scaled <= (1ull << 53)) {
+				value = (double)scaled * 1e22;
+				*out = negative ? -value : value;
+				return GON_VALUE_OK;
+			}
+		}
+	}
+	return gon_read_double_slow(text, length, out);
+}
+
+GonValueError gon_read_bool(const char* text, size_t length, bool* out) {
+	if (length == 4 && memcmp(text, "true",  4) == 0) { *out = true;  return GON_VALUE_OK; }
+	if (length == 5 && memcmp(text, "false", 5) == 0) { *out = false; return GON_VALUE_OK; }
+	return GON_VALUE_INVALID;
+}
+
+GonValueError gon_field_int64(const GonField* field, int64_t* out) {
+	if (!gon_type_check(field, GON_TYPE_FIELD)) return GON_VALUE_MISSING;
+	return gon_read_int64(gon_value(field), gon_value_length(field), out);
+}
+
+GonValueError gon_field_double(const GonField* field, double* out) {
+	if (!gon_type_check(field, GON_TYPE_FIELD)) return GON_VALUE_MISSING;
+	return gon_read_double(gon_value(field), gon_value_length(field), out);
+}
+
+GonValueError gon_field_bool(const GonField* field, bool* out) {
+	if (!gon_type_check(field, GON_TYPE_FIELD)) return GON_VALUE_MISSING;
+	return gon_read_bool(gon_value(field), gon_value_length(field), out);
+}
+
+// Tries to get a string value from the named field
+// If no field is found with matching name or field is wrong type, returns default value
+// With GON_NON_DESTRUCTIVE the value is not null-terminated, so use gon_get_field() and value_length instead if you need the length
+char* gon_get_value(GonField* parent, const char* name, char* default_value) {
+	GonField* field = gon_get_field(parent, name);
+	if (gon_type_check(field, GON_TYPE_FIELD))
+		return gon_value(field);
+	return default_value;
+}
+
+// Tries to get an integer value from the named field
+// If no field is found with matching name, the field is the wrong type, or its value is not an integer that fits in an int, returns default value
+int gon_get_int(GonField* parent, const char* name, int default_value) {
+	int64_t value;
+	if (gon_field_int64(gon_get_field(parent, name), &value) || value < INT_MIN || value > INT_MAX)
+		return default_value;
+	return (int)value;
+}
+
+// Tries to get a float value from the named field
+// If no field is found with matching name, the field is the wrong type, or its value is not a number, returns default value
+double gon_get_float(GonField* parent, const char* name, double default_value) {
+	double value;
+	if (gon_field_double(gon_get_field(parent, name), &value))
+		return default_value;
+	return value;
+}
+
+// Tries to get a boolean value from the named field
+// If no field is found with matching name, the field is the wrong type, or its value is not true or false, returns default value
+bool gon_get_bool(GonField* parent, const char* name, bool default_value) {
+	bool value;
+	if (gon_field_bool(gon_get_field(parent, name), &value))
+		return default_value;
+	return value;
+}
+
+/*
+	Value Cache
+
+	A GonValueCache remembers the result of converting each field, so that reading the same field again costs one array lookup.
+	It holds one entry per field in its GonFile, allocated (from the GonFile's allocator) the first time it is used, and keyed by the field's position in the fields array.
+	Each entry holds the last type it was converted to, so asking for a field as an int64 and then as a double converts it twice, and the second replaces the first.
+	The cache does not notice when its GonFile is parsed again, so call gon_value_cache_clear() after each parse. The same call frees the entries once the cache is no longer needed.
+*/
+typedef enum GonValueKind {
+	GON_VALUE_KIND_NONE = 0,
+	GON_VALUE_KIND_INT64,
+	GON_VALUE_KIND_DOUBLE,
+	GON_VALUE_KIND_BOOL
+} GonValueKind;
+
+typedef struct GonCachedValue {
+	union {
+		int64_t as_int64;
+		double  as_double;
+		bool    as_bool;
+	};
+	unsigned char kind;		// GonValueKind of the last conversion, or GON_VALUE_KIND_NONE if there hasn't been one
+	unsigned char error;	// GonValueError from that conversion
+} GonCachedValue;
+
+typedef struct GonValueCache {
+	GonFile*        gon;
+	GonCachedValue* values;
+	size_t          count;
+} GonValueCache;
+
+GonValueCache gon_value_cache_create(GonFile* gon) {
+	GonValueCache cache = { gon, NULL, 0 };
+	return cache;
+}
+
+void gon_value_cache_clear(GonValueCache* cache) {
+	gon_release(cache->gon->allocator, cache->values, cache->count * sizeof(GonCachedValue));
+	cache->values = NULL;
+	cache->count  = 0;
+}
+
+// Finds the entry for a field, or NULL if the field is not in the cache's GonFile (or the entries could not be allocated)
+static inline GonCachedValue* gon_value_cache_slot(GonValueCache* cache, const GonField* field) {
+	if (!cache->values) {
+		size_t count = cache->gon->fields[0].size;
+		cache->values = (GonCachedValue*)gon_alloc(cache->gon->allocator, count * sizeof(GonCachedValue));
+		if (!cache->values) return NULL;
+		memset(cache->values, 0, count * sizeof(GonCachedValue));
+		cache->count = count;
+	}
+	size_t index = (size_t)(field - cache->gon->fields);
+	return index < cache->count ? &cache->values[index] : NULL;
+}
+
+GonValueError gon_cached_int64(GonValueCache* cache, const GonField* field, int64_t* out) {
+	GonCachedValue* slot = field ? gon_value_cache_slot(cache, field) : NULL;
+	if (!slot) return gon_field_int64(field, out);
+	if (slot->kind != GON_VALUE_KIND_INT64) {
+		slot->kind  = GON_VALUE_KIND_INT64;
+		slot->error = gon_field_int64(field, &slot->as_int64);
+	}
+	if (slot->error == GON_VALUE_OK) *out = slot->as_int64;
+	return (GonValueError)slot->error;
+}
+
+GonValueError gon_cached_double(GonValueCache* cache, const GonField* field, double* out) {
+	GonCachedValue* slot = field ? gon_value_cache_slot(cache, field) : NULL;
+	if (!slot) return gon_field_double(field, out);
+	if (slot->kind != GON_VALUE_KIND_DOUBLE) {
+		slot->kind  = GON_VALUE_KIND_DOUBLE;
+		slot->error = gon_field_double(field, &slot->as_double);
+	}
+	if (slot->error == GON_VALUE_OK) *out = slot->as_double;
+	return (GonValueError)slot->error;
+}
+
+GonValueError gon_cached_bool(GonValueCache* cache, const GonField* field, bool* out) {
+	GonCachedValue* slot = field ? gon_value_cache_slot(cache, field) : NULL;
+	if (!slot) return gon_field_bool(field, out);
+	if (slot->kind != GON_VALUE_KIND_BOOL) {
+		slot->kind  = GON_VALUE_KIND_BOOL;
+		slot->error = gon_field_bool(field, &slot->as_bool);
+	}
+	if (slot->error == GON_VALUE_OK) *out = slot->as_bool;
+	return (GonValueError)slot->error;
+}
+
+#define gon_iterate_array(gon_array, gon_it) \
+GonField* gon_it##_last = gon_array + gon_array->size; \
+for (GonField* gon_it = gon_array + 1; gon_it <= gon_it##_last; gon_it += (gon_it->type == GON_TYPE_FIELD ? 1 : gon_it->size + 1))
+
+/*
+	Path Queries
+
+	gon_path_compile() turns a path such as "object/object/name" or "items[3]/id" into a GonPath, so that looking it up again does no parsing, no strlen and no hashing.
+	Steps are separated by '/'. Each step is a child name, optionally followed by one or more [n] to take the nth child of the object or array found so far ("[0]/id" starts with an index).
+	A backslash takes the next character of a name literally, for names containing '/', '[' or '\'. An empty path gives back the field it is evaluated from.
+	gon_path_get() evaluates a path from any field (usually gon->fields), and returns NULL if a step is missing or lands on the wrong type. Names find the first child with that name, just like gon_get_field().
+
+	A GonPathSet compiles many paths together into a tree that shares their common prefixes, and gon_path_set_get() resolves all of them in one pass over the fields.
+	Each object on the way is scanned once for every path that goes through it, stopping as soon as all of them have been found, rather than once per path.
+	Objects with GON_PATH_TABLE_MIN or more different names looked up in them get a hash table over those names in the set, so each child costs one probe however many paths are waiting on it.
+	Objects that already have a hash table from GON_USING_INDEX are searched through that instead.
+	Both are read-only once compiled, so a GonPath or GonPathSet may be evaluated from several threads at once.
+*/
+#ifndef GON_PATH_TABLE_MIN
+#define GON_PATH_TABLE_MIN 8
+#endif
+
+typedef struct GonPathStep {
+	const char*  name;		// null-terminated, or NULL if this step is an index
+	int          length;
+	int          index;		// child to take if name is NULL
+	unsigned int hash;		// gon_hash_name() of the name
+} GonPathStep;
+
+typedef struct GonPath {
+	GonPathStep* steps;		// the steps are followed in the same block by their names
+	int          step_count;
+} GonPath;
+
+// Parses a path into steps, writing the unescaped names (each null-terminated) into names
+// With steps and names NULL, this only counts the steps and the bytes of names they need
+static int gon_path_parse(const char* text, GonPathStep* steps, char* names, int* step_count, size_t* names_size) {
+	const char* index = text;
+	int    count = 0;
+	size_t size  = 0;
+	if (*index == '/') index++;
+	while (*index) {
+		if (*index != '[') {
+			char* name = names ? names + size : NULL;
+			int length = 0;
+			while (*index && *index != '/' && *index != '[') {
+				if (*index == '\\' && index[1]) index++;
+				if (name) name[length] = *index;
+				length++, index++;
+			}
+			if (name) {
+				name[length] = '\0';
+				steps[count].name   = name;
+				steps[count].length = length;
+				steps[count].index  = 0;
+				steps[count].hash   = gon_hash_name(name, length);
+			}
+			count++;
+			size += length + 1;
+		}
+		while (*index == '[') {
+			const char* digits = ++index;
+			long long n = 0;
+			while (*index >= '0' && *index <= '9' && n <= INT_MAX) n = n * 10 + (*index++ - '0');
+			if (index == digits || *index != ']' || n > INT_MAX) {
+				printf("GON path error: bad index at offset %d in \"%s\"\n", (int)(digits - text), text);
+				return 1;
+			}
+			index++;
+			if (steps) {
+				steps[count].name   = NULL;
+				steps[count].length = 0;
+				steps[count].index  = (int)n;
+				steps[count].hash   = 0;
+			}
+			count++;
+		}
+		if (*index == '/') {
+			index++;
+			if (!*index || *index == '/') {
+				printf("GON path error: empty step at offset %d in \"%s\"\n", (int)(index - text), text);
+				return 1;
+			}
+		} else if (*index) {
+			printf("GON path error: unexpected '%c' at offset %d in \"%s\"\n", *index, (int)(index - text), text);
+			return 1;
+		}
+	}
+	*step_count = count;
+	if (names_size) *names_size = size;
+	return 0;
+}
+
+int gon_path_compile(GonPath* path, const char* text) {
+	int    step_count;
+	size_t names_size;
+	path->steps      = NULL;
+	path->step_count = 0;
+	if (gon_path_parse(text, NULL, NULL, &step_count, &names_size)) return 1;
+
+	GonPathStep* steps = (GonPathStep*)malloc(step_count * sizeof(GonPathStep) + names_size + 1);
+	if (!steps) {
+		puts("GON path error: failed to allocate path");
+		return 1;
+	}
+	gon_path_parse(text, steps, (char*)(steps + step_count), &step_count, NULL);
+	path->steps      = steps;
+	path->step_count = step_count;
+	return 0;
+}
+
+void gon_path_free(GonPath* path) {
+	free(path->steps);
+	path->steps      = NULL;
+	path->step_count = 0;
+}
+
+// Gets the nth child of an object or array, or NULL if it has fewer children
+static inline GonField* gon_child_at(GonField* parent, int n) {
+	GonField* field = parent + 1;
+	#ifdef GON_USING_COMPACT_FIELDS
+	GonField* end = parent + parent->size + (parent->self != 0);
+	for (; field < end; field += field->type == GON_TYPE_FIELD ? 1 : field->size + 1) {
+		if (!n--) return field;
+	}
+	return NULL;
+	#else
+	if (n >= parent->count) return NULL;
+	for (; n; n--) field += field->type == GON_TYPE_FIELD ? 1 : field->size + 1;
+	return field;
+	#endif
+}
+
+// Follows one step from a field, or returns NULL
+static inline GonField* gon_path_step(GonField* field, const GonPathStep* step) {
+	if (step->name) {
+		if (field->type != GON_TYPE_OBJECT) return NULL;
+		return gon_find_child(field, step->name, step->length, step->hash);
+	}
+	if (field->type == GON_TYPE_FIELD) return NULL;
+	return gon_child_at(field, step->index);
+}
+
+GonField* gon_path_get(GonField* from, const GonPath* path) {
+	GonField* field = from;
+	for (int i = 0; field && i < path->step_count; i++)
+		field = gon_path_step(field, &path->steps[i]);
+	return field;
+}
+
+// One step in a GonPathSet's tree
+// The children of a node are next to each other in the nodes array, with the name steps first
+typedef struct GonPathNode {
+	GonPathStep step;			// the step from the parent node to this one
+	int         first_child;
+	int         child_count;
+	int         name_count;		// how many of the children are name steps
+	int         table;			// offset of this node's hash table in the set's slots, or -1 if its children are compared one by one
+	int         table_mask;
+	int         first_end;		// first path ending at this node, with the rest linked through next_end, or -1
+} GonPathNode;
+
+typedef struct GonPathSet {
+	GonPathNode* nodes;			// nodes[0] is the field the paths are evaluated from
+	int          node_count;
+	int          path_count;
+	int*         next_end;		// for each path, the next path ending at the same node, or -1
+	int*         slots;			// node index of each hash table entry, or 0 if the entry is empty
+	char*        names;
+} GonPathSet;
+
+void gon_path_set_free(GonPathSet* set) {
+	free(set->nodes);
+	free(set->next_end);
+	free(set->slots);
+	free(set->names);
+	memset(set, 0, sizeof(*set));
+}
+
+static inline bool gon_path_steps_equal(const GonPathStep* a, const GonPathStep* b) {
+	if (!a->name || !b->name) return !a->name && !b->name && a->index == b->index;
+	return a->hash == b->hash && a->length == b->length && memcmp(a->name, b->name, a->length) == 0;
+}
+
+int gon_path_set_compile(GonPathSet* set, const char* const* paths, int path_count) {
+	memset(set, 0, sizeof(*set));
+
+	// compile each path, and count the most nodes and name bytes the tree could need
+	GonPath* compiled = (GonPath*)calloc(path_count ? path_count : 1, sizeof(GonPath));
+	if (!compiled) {
+		puts("GON path error: failed to allocate path set");
+		return 1;
+	}
+	int    max_nodes  = 1;
+	size_t names_size = 0;
+	for (int i = 0; i < path_count; i++) {
+		if (gon_path_compile(&compiled[i], paths[i])) {
+			for (int j = 0; j < i; j++) gon_path_free(&compiled[j]);
+			free(compiled);
+			return 1;
+		}
+		max_nodes += compiled[i].step_count;
+		for (int k = 0; k < compiled[i].step_count; k++) names_size += compiled[i].steps[k].length + 1;
+	}
+
+	// build the tree, with each node's children linked as a list
+	typedef struct { GonPathStep step; int first, next, last, first_end; } Building;
+	Building* building = (Building*)malloc(max_nodes * sizeof(Building));
+	int*      order    = (int*)malloc(max_nodes * sizeof(int));
+	set->nodes    = (GonPathNode*)malloc(max_nodes * sizeof(GonPathNode));
+	set->next_end = (int*)malloc((path_count ? path_count : 1) * sizeof(int));
+	set->names    = (char*)malloc(names_size + 1);
+	int error = !building || !order || !set->nodes || !set->next_end || !set->names;
+
+	int    node_count = 1;
+	size_t names_used = 0;
+	if (!error) {
+		memset(&building[0], 0, sizeof(Building));
+		building[0].first = building[0].last = building[0].first_end = -1;
+		for (int i = 0; i < path_count; i++) {
+			int node = 0;
+			for (int k = 0; k < compiled[i].step_count; k++) {
+				const GonPathStep* step = &compiled[i].steps[k];
+				int child = building[node].first;
+				while (child >= 0 && !gon_path_steps_equal(&building[child].step, step)) child = building[child].next;
+				if (child < 0) {
+					child = node_count++;
+					building[child].step = *step;
+					if (step->name) {
+						memcpy(set->names + names_used, step->name, step->length + 1);
+						building[child].step.name = set->names + names_used;
+						names_used += step->length + 1;
+					}
+					building[child].first = building[child].last = building[child].next = building[child].first_end = -1;
+					if (building[node].last >= 0) building[building[node].last].next = child;
+					else building[node].first = child;
+					building[node].last = child;
+				}
+				node = child;
+			}
+			set->next_end[i] = building[node].first_end;
+			building[node].first_end = i;
+		}
+
+		// lay the tree out breadth first, so that each node's children are next to each other (names, then indices)
+		// order[] maps the final position of each node to where it was built
+		int placed = 1;
+		order[0] = 0;
+		for (int n = 0; n < placed; n++) {
+			const Building* from = &building[order[n]];
+			GonPathNode* node = &set->nodes[n];
+			node->step        = from->step;
+			node->first_end   = from->first_end;
+			node->first_child = placed;
+			node->table       = -1;
+			node->table_mask  = 0;
+			for (int c = from->first; c >= 0; c = building[c].next) if (building[c].step.name)  order[placed++] = c;
+			node->name_count  = placed - node->first_child;
+			for (int c = from->first; c >= 0; c = building[c].next) if (!building[c].step.name) order[placed++] = c;
+			node->child_count = placed - node->first_child;
+		}
+
+		// hash tables for nodes with many names
+		int slot_count = 0;
+		for (int n = 0; n < node_count; n++) {
+			GonPathNode* node = &set->nodes[n];
+			if (node->name_count < GON_PATH_TABLE_MIN) continue;
+			int size = 1;
+			while (size < node->name_count * 2) size *= 2;
+			node->table      = slot_count;
+			node->table_mask = size - 1;
+			slot_count += size;
+		}
+		if (slot_count) {
+			set->slots = (int*)calloc(slot_count, sizeof(int));
+			if (!set->slots) error = 1;
+		}
+		for (int n = 0; !error && n < node_count; n++) {
+			GonPathNode* node = &set->nodes[n];
+			if (node->table < 0) continue;
+			int* slots = set->slots + node->table;
+			for (int c = node->first_child; c < node->first_child + node->name_count; c++) {
+				int s = set->nodes[c].step.hash & node->table_mask;
+				while (slots[s]) s = (s + 1) & node->table_mask;
+				slots[s] = c;
+			}
+		}
+	}
+
+	for (int i = 0; i < path_count; i++) gon_path_free(&compiled[i]);
+	free(compiled);
+	free(building);
+	free(order);
+	if (error) {
+		puts("GON path error: failed to allocate path set");
+		gon_path_set_free(set);
+		return 1;
+	}
+	set->node_count = node_count;
+	set->path_count = path_count;
+	return 0;
+}
+
+// Resolves everything below one node of a GonPathSet, given the field the node matched
+// seen marks the nodes which have already been matched, since only the first child with a name counts
+static void gon_path_set_visit(const GonPathSet* set, int n, GonField* field, unsigned char* seen, GonField** out) {
+	const GonPathNode* node = &set->nodes[n];
+	for (int p = node->first_end; p >= 0; p = set->next_end[p]) out[p] = field;
+	if (!node->child_count || field->type == GON_TYPE_FIELD) return;
+
+	// children of arrays have no names, so only the index steps can match there
+	bool object = field->type == GON_TYPE_OBJECT;
+	int  first  = node->first_child + (object ? 0 : node->name_count);
+	int  end    = node->first_child + node->child_count;
+	int  remaining = end - first;
+	if (!remaining) return;
+
+	#ifdef GON_USING_INDEX
+	// an object with its own hash table is quicker to search once per name
+	if (object && node->name_count == node->child_count) {
+		GonIndex** table = gon_index_slot(field, false);
+		if (table && *table && (*table)->mask) {
+			for (int c = first; c < end; c++) {
+				const GonPathStep* step = &set->nodes[c].step;
+				GonField* child = gon_find_child(field, step->name, step->length, step->hash);
+				if (child) gon_path_set_visit(set, c, child, seen, out);
+			}
+			return;
+		}
+	}
+	#endif
+
+	// with a table, the names are found through it, and only the index steps are compared one by one
+	bool use_table = object && node->table >= 0;
+	const int* slots = use_table ? set->slots + node->table : NULL;
+	if (use_table) first += node->name_count;
+
+	GonField* child = field + 1;
+	#ifdef GON_USING_COMPACT_FIELDS
+	GonField* last = field + field->size + (field->self != 0);
+	for (int k = 0; child < last; k++) {
+	#else
+	for (int k = 0; k < field->count; k++) {
+	#endif
+		if (use_table) {
+			const char* name   = gon_name(child);
+			size_t      length = gon_name_length(child);
+			unsigned int hash  = gon_hash_name(name, length);
+			for (int s = hash & node->table_mask; slots[s]; s = (s + 1) & node->table_mask) {
+				int c = slots[s];
+				const GonPathStep* step = &set->nodes[c].step;
+				if (step->hash == hash && (size_t)step->length == length && memcmp(step->name, name, length) == 0) {
+					if (!seen[c]) {
+						seen[c] = 1;
+						gon_path_set_visit(set, c, child, seen, out);
+						if (!--remaining) return;
+					}
+					break;
+				}
+			}
+		}
+		for (int c = first; c < end; c++) {
+			if (seen[c]) continue;
+			const GonPathStep* step = &set->nodes[c].step;
+			if (step->name ? gon_name_equals(child, step->name, step->length) : step->index == k) {
+				seen[c] = 1;
+				gon_path_set_visit(set, c, child, seen, out);
+				if (!--remaining) return;
+			}
+		}
+		child += child->type == GON_TYPE_FIELD ? 1 : child->size + 1;
+	}
+}
+
+// Resolves every path in the set from the given field, writing the field each one leads to (or NULL) into out[path]
+// Returns the number of paths found
+int gon_path_set_get(const GonPathSet* set, GonField* from, GonField** out) {
+	for (int i = 0; i < set->path_count; i++) out[i] = NULL;
+	if (!from || !set->node_count) return 0;
+
+	unsigned char  local[1024];
+	unsigned char* seen = set->node_count <= (int)sizeof(local) ? local : (unsigned char*)malloc(set->node_count);
+	if (!seen) {
+		puts("GON path error: failed to allocate path set marks");
+		return 0;
+	}
+	memset(seen, 0, set->node_count);
+	gon_path_set_visit(set, 0, from, seen, out);
+	if (seen != local) free(seen);
+
+	int found = 0;
+	for (int i = 0; i < set->path_count; i++) found += out[i] != NULL;
+	return found;
+}
+
+/*
+	Struct Binding
+
+	A GonBinding describes one member of a C struct: the name of the field it comes from, how to convert it, where it goes (offsetof), and a default.
+	gon_binder_compile() turns an array of them into a GonBinder, which gon_bind() uses to fill a struct from an object in one walk over its children.
+	Each child's name is hashed once and looked up in a table built from the bindings, so the cost depends on the number of children rather than children times members.
+	As with gon_get_field(), only the first child with a given name is used.
+
+	Numbers and bools are converted with gon_read_int64(), gon_read_double() and gon_read_bool(). Defaults are written as text (e.g. "10", "1.5", "true") and converted the same way.
+	A member whose field is missing gets its default, or is left alone if it has none. A field that does not convert prints an error and gets the default too, and gon_bind() then returns 1.
+	GON_BIND_STRING stores a pointer to the value in the GonFile (or to the default), so it is only valid until the file is freed, and with GON_NON_DESTRUCTIVE it is not null-terminated. GON_BIND_CHARS copies into a char array instead.
+	GON_BIND_OBJECT fills a nested struct from its own bindings, and applies their defaults if the object is missing.
+	GON_BIND_ARRAY fills a fixed-size C array from a GON array, one element binding for every element, and stores the number of elements in an int member.
+
+	The GON_BINDING* macros fill in the offsets and sizes:
+		typedef struct Weapon { char name[32]; int damage; float range; int tags[4]; int tag_count; } Weapon;
+		static const GonBinding tag_element = GON_ELEMENT(GON_BIND_INT);
+		static const GonBinding weapon_bindings[] = {
+			GON_BINDING("name",   GON_BIND_CHARS, Weapon, name,   "unnamed"),
+			GON_BINDING("damage", GON_BIND_INT,   Weapon, damage, "1"),
+			GON_BINDING("range",  GON_BIND_FLOAT, Weapon, range,  "1.5"),
+			GON_BINDING_ARRAY("tags", Weapon, tags, tag_count, tag_element),
+		};
+		GonBinder binder;
+		gon_binder_compile(&binder, weapon_bindings, GON_BINDING_COUNT(weapon_bindings));
+		gon_bind(&binder, gon_get_field(gon.fields, "sword"), &sword);
+*/
+#include <stddef.h>
+
+typedef enum GonBindType {
+	GON_BIND_INT = 1,	// int
+	GON_BIND_INT64,		// int64_t
+	GON_BIND_FLOAT,		// float
+	GON_BIND_DOUBLE,	// double
+	GON_BIND_BOOL,		// bool
+	GON_BIND_STRING,	// const char*, pointing into the GonFile
+	GON_BIND_CHARS,		// char[size], copied and null-terminated (and cut short if it does not fit)
+	GON_BIND_FIELD,		// GonField*, for anything the other types do not cover (NULL if missing)
+	GON_BIND_OBJECT,	// a nested struct, described by sub
+	GON_BIND_ARRAY		// a C array of capacity elements, each described by sub[0]
+} GonBindType;
+
+typedef struct GonBinding {
+	const char*              name;			// name of the field (NULL for an array element)
+	int                      type;			// GonBindType
+	size_t                   offset;		// offsetof() the member
+	const char*              default_value;	// used when the field is missing or does not convert (NULL to leave the member alone)
+	const struct GonBinding* sub;			// bindings of a nested struct, or the binding for each element of an array
+	int                      sub_count;
+	size_t                   size;			// size of the member (of one element, for arrays)
+	int                      capacity;		// number of elements in an array member
+	size_t                   count_offset;	// offsetof() the int which receives the number of elements in an array
+} GonBinding;
+
+#define GON_BINDING_COUNT(bindings) ((int)(sizeof(bindings) / sizeof((bindings)[0])))
+#define GON_MEMBER_SIZE(struct_type, member) sizeof(((struct_type*)0)->member)
+
+#define GON_BINDING(name, type, struct_type, member, default_value) \
+	{ name, type, offsetof(struct_type, member), default_value, NULL, 0, GON_MEMBER_SIZE(struct_type, member), 0, 0 }
+#define GON_BINDING_OBJECT(name, struct_type, member, bindings) \
+	{ name, GON_BIND_OBJECT, offsetof(struct_type, member), NULL, bindings, GON_BINDING_COUNT(bindings), GON_MEMBER_SIZE(struct_type, member), 0, 0 }
+#define GON_BINDING_ARRAY(name, struct_type, member, count_member, element) \
+	{ name, GON_BIND_ARRAY, offsetof(struct_type, member), NULL, &(element), 1, GON_MEMBER_SIZE(struct_type, member[0]), \
+	  (int)(GON_MEMBER_SIZE(struct_type, member) / GON_MEMBER_SIZE(struct_type, member[0])), offsetof(struct_type, count_member) }
+// Element bindings for GON_BINDING_ARRAY (a GON_BIND_CHARS element takes its size from the array)
+#define GON_ELEMENT(type) { NULL, type, 0, NULL, NULL, 0, 0, 0, 0 }
+#define GON_ELEMENT_OBJECT(bindings) { NULL, GON_BIND_OBJECT, 0, NULL, bindings, GON_BINDING_COUNT(bindings), 0, 0, 0 }
+
+// The lookup table for one array of bindings
+typedef struct GonBinderTable {
+	const GonBinding* bindings;
+	int               count;
+	int               mask;			// number of slots - 1
+	int               first_slot;	// offset of this table's slots in the binder's slots, each holding a binding index + 1 (or 0 if empty)
+	int               first_member;	// offset of this table's bindings in the binder's hashes and subs
+} GonBinderTable;
+
+typedef struct GonBinder {
+	GonBinderTable* tables;			// tables[0] is for the bindings given to gon_binder_compile()
+	int             table_count;
+	int*            slots;
+	unsigned int*   hashes;			// gon_hash_name() of each binding's name
+	int*            lengths;		// length of each binding's name
+	int*            subs;			// table for each binding's sub bindings, or -1
+} GonBinder;
+
+void gon_binder_free(GonBinder* binder) {
+	free(binder->tables);
+	free(binder->slots);
+	free(binder->hashes);
+	free(binder->lengths);
+	free(binder->subs);
+	memset(binder, 0, sizeof(*binder));
+}
+
+// Counts the tables, slots and bindings needed for an array of bindings and everything below it
+static void gon_binder_measure(const GonBinding* bindings, int count, int* tables, int* slots, int* members) {
+	int size = 1;
+	while (size < count * 2) size *= 2;
+	*tables  += 1;
+	*slots   += size;
+	*members += count;
+	for (int b = 0; b < count; b++)
+		if (bindings[b].sub) gon_binder_measure(bindings[b].sub, bindings[b].sub_count, tables, slots, members);
+}
+
+// Adds the table for an array of bindings (and the tables below it), returning its index
+static int gon_binder_add(GonBinder* binder, const GonBinding* bindings, int count, int* slots_used, int* members_used) {
+	int t = binder->table_count++;
+	int size = 1;
+	while (size < count * 2) size *= 2;
+	GonBinderTable* table = &binder->tables[t];
+	table->bindings     = bindings;
+	table->count        = count;
+	table->mask         = size - 1;
+	table->first_slot   = *slots_used;
+	table->first_member = *members_used;
+	*slots_used   += size;
+	*members_used += count;
+
+	int* slots = binder->slots + table->first_slot;
+	for (int b = 0; b < count; b++) {
+		const GonBinding* binding = &bindings[b];
+		int length = binding->name ? (int)strlen(binding->name) : 0;
+		unsigned int hash = gon_hash_name(binding->name, length);
+		binder->hashes[table->first_member + b]  = hash;
+		binder->lengths[table->first_member + b] = length;
+		if (binding->name) {
+			int s = hash & table->mask;
+			while (slots[s]) s = (s + 1) & table->mask;
+			slots[s] = b + 1;
+		}
+		binder->subs[table->first_member + b] = -1;
+	}
+	// the sub tables come after this one, so table (a pointer into tables) stays valid above, but not below
+	for (int b = 0; b < count; b++) {
+		if (!bindings[b].sub) continue;
+		int sub = gon_binder_add(binder, bindings[b].sub, bindings[b].sub_count, slots_used, members_used);
+		binder->subs[binder->tables[t].first_member + b] = sub;
+	}
+	return t;
+}
+
+int gon_binder_compile(GonBinder* binder, const GonBinding* bindings, int count) {
+	memset(binder, 0, sizeof(*binder));
+	int table_count = 0, slot_count = 0, member_count = 0;
+	gon_binder_measure(bindings, count, &table_count, &slot_count, &member_count);
+
+	binder->tables  = (GonBinderTable*)malloc(table_count * sizeof(GonBinderTable));
+	binder->slots   = (int*)calloc(slot_count, sizeof(int));
+	binder->hashes  = (unsigned int*)malloc((member_count ? member_count : 1) * sizeof(unsigned int));
+	binder->lengths = (int*)malloc((member_count ? member_count : 1) * sizeof(int));
+	binder->subs    = (int*)malloc((member_count ? member_count : 1) * sizeof(int));
+	if (!binder->tables || !binder->slots || !binder->hashes || !binder->lengths || !binder->subs) {
+		puts("GON bind error: failed to allocate binder");
+		gon_binder_free(binder);
+		return 1;
+	}
+	int slots_used = 0, members_used = 0;
+	gon_binder_add(binder, bindings, count, &slots_used, &members_used);
+	return 0;
+}
+
+static int gon_bind_table(const GonBinder* binder, int t, GonField* object, char* out);
+
+// Prints the problem followed by the name of the binding's type, and returns 1
+static int gon_bind_error(const GonBinding* binding, const char* problem) {
+	static const char* type_names[] = { "", "int", "int64", "float", "double", "bool", "string", "string", "field", "object", "array" };
+	if (binding->name) printf("GON bind error: field \"%s\" %s %s\n", binding->name, problem, type_names[binding->type]);
+	else               printf("GON bind error: array element %s %s\n", problem, type_names[binding->type]);
+	return 1;
+}
+
+// Converts text into a scalar member
+static GonValueError gon_bind_text(const GonBinding* binding, const char* text, size_t length, char* dst, size_t size) {
+	GonValueError error = GON_VALUE_OK;
+	int64_t integer;
+	double  number;
+	switch (binding->type) {
+	case GON_BIND_INT:
+		error = gon_read_int64(text, length, &integer);
+		if (!error && (integer < INT_MIN || integer > INT_MAX)) error = GON_VALUE_RANGE;
+		if (!error) *(int*)dst = (int)integer;
+		break;
+	case GON_BIND_INT64:
+		error = gon_read_int64(text, length, (int64_t*)dst);
+		break;
+	case GON_BIND_FLOAT:
+		error = gon_read_double(text, length, &number);
+		if (!error) *(float*)dst = (float)number;
+		break;
+	case GON_BIND_DOUBLE:
+		error = gon_read_double(text, length, (double*)dst);
+		break;
+	case GON_BIND_BOOL:
+		error = gon_read_bool(text, length, (bool*)dst);
+		break;
+	case GON_BIND_STRING:
+		*(const char**)dst = text;
+		break;
+	case GON_BIND_CHARS:
+		if (!size) break;
+		if (length >= size) length = size - 1;
+		memcpy(dst, text, length);
+		dst[length] = '\0';
+		break;
+	}
+	return error;
+}
+
+// Fills one member (at base + offset) from its field, which may be NULL if it is missing
+// size is the size of an array element, for element bindings which do not give their own
+static int gon_bind_member(const GonBinder* binder, int t, int b, GonField* field, char* base, size_t size) {
+	const GonBinderTable* table   = &binder->tables[t];
+	const GonBinding*     binding = &table->bindings[b];
+	int   sub = binder->subs[table->first_member + b];
+	char* dst = base + binding->offset;
+	if (binding->size) size = binding->size;
+
+	switch (binding->type) {
+	case GON_BIND_FIELD:
+		*(GonField**)dst = field;
+		return 0;
+
+	case GON_BIND_OBJECT: {
+		int error = 0;
+		if (field && field->type != GON_TYPE_OBJECT) {
+			error = gon_bind_error(binding, "is not an");
+			field = NULL;
+		}
+		return gon_bind_table(binder, sub, field, dst) | error;
+	}
+
+	case GON_BIND_ARRAY: {
+		if (!field) return 0;
+		if (field->type != GON_TYPE_ARRAY) return gon_bind_error(binding, "is not an");
+		int error = 0;
+		int count = 0;
+		GonField* element = field + 1;
+		GonField* end = field + field->size + 1;
+		for (; element < end; element += element->type == GON_TYPE_FIELD ? 1 : element->size + 1) {
+			if (count == binding->capacity) {
+				error = gon_bind_error(binding, "has more elements than fit in the");
+				break;
+			}
+			error |= gon_bind_member(binder, sub, 0, element, dst + count * size, size);
+			count++;
+		}
+		*(int*)(base + binding->count_offset) = count;
+		return error;
+	}
+	}
+
+	if (field && field->type == GON_TYPE_FIELD) {
+		if (gon_bind_text(binding, gon_value(field), gon_value_length(field), dst, size) == GON_VALUE_OK) return 0;
+	} else if (!field) {
+		if (binding->default_value) gon_bind_text(binding, binding->default_value, strlen(binding->default_value), dst, size);
+		return 0;
+	}
+	gon_bind_error(binding, "is not a valid");
+	if (binding->default_value) gon_bind_text(binding, binding->default_value, strlen(binding->default_value), dst, size);
+	return 1;
+}
+
+// Fills a struct from the children of an object (or only from the defaults, if object is NULL)
+static int gon_bind_table(const GonBinder* binder, int t, GonField* object, char* out) {
+	const GonBinderTable* table = &binder->tables[t];
+	const int* slots = binder->slots + table->first_slot;
+
+	unsigned char  local[256];
+	unsigned char* seen = table->count <= (int)sizeof(local) ? local : (unsigned char*)malloc(table->count);
+	if (!seen) {
+		puts("GON bind error: failed to allocate binding marks");
+		return 1;
+	}
+	memset(seen, 0, table->count);
+
+	int error = 0;
+	if (object) {
+		int remaining = table->count;
+		GonField* child = object + 1;
+		#ifdef GON_USING_COMPACT_FIELDS
+		GonField* end = object + object->size + (object->self != 0);
+		while (remaining && child < end) {
+		#else
+		for (int i = 0; remaining && i < object->count; i++) {
+		#endif
+			const char*  name   = gon_name(child);
+			size_t       length = gon_name_length(child);
+			unsigned int hash   = gon_hash_name(name, length);
+			for (int s = hash & table->mask; slots[s]; s = (s + 1) & table->mask) {
+				int b = slots[s] - 1;
+				if (binder->hashes[table->first_member + b] == hash && (size_t)binder->lengths[table->first_member + b] == length && memcmp(table->bindings[b].name, name, length) == 0) {
+					if (!seen[b]) {
+						seen[b] = 1;
+						remaining--;
+						error |= gon_bind_member(binder, t, b, child, out, 0);
+					}
+					break;
+				}
+			}
+			child += child->type == GON_TYPE_FIELD ? 1 : child->size + 1;
+		}
+	}
+	for (int b = 0; b < table->count; b++) {
+		if (!seen[b]) error |= gon_bind_member(binder, t, b, NULL, out, 0);
+	}
+
+	if (seen != local) free(seen);
+	return error;
+}
+
+// Fills out (a struct described by the bindings the binder was compiled from) from an object
+// If object is NULL, every member gets its default. Returns 1 if any field had the wrong type or did not convert
+int gon_bind(const GonBinder* binder, GonField* object, void* out) {
+	if (object && object->type != GON_TYPE_OBJECT) {
+		char* name = gon_name(object);
+		printf("GON bind error: \"%.*s\" is not an object\n", name ? (int)gon_name_length(object) : 4, name ? name : "NULL");
+		gon_bind_table(binder, 0, NULL, (char*)out);
+		return 1;
+	}
+	return gon_bind_table(binder, 0, object, (char*)out);
+}
+
+/*
+	Schemas
+
+	A GonSchema is a minimal perfect hash over a fixed set of names, such as the keys of an entity, tileset or level file.
+	It is generated ahead of time by tools/gon_mphf (from a sample file or a list of keys) as a header of static const tables, so there is nothing to build or free at runtime, and no probing.
+	gon_schema_key() maps a name to its key number (0 to key_count - 1) with one hash, one table read, and one length-checked compare against that key, which is what rejects names outside the set.
+	gon_schema_index() walks an object's children once and stores the first child with each key in children[key], so that the members can then be read by key number.
+	gon_schema_get_field() then stands in for gon_get_field() on the indexed object: it looks the name up in children[] by its key number, so a lookup costs one hash rather than a walk over the object, and names outside the set return NULL.
+
+	The hash is FNV-1a (64-bit) of the name, started from the schema's seed and then mixed. Its high bits choose a bucket, and each bucket has a displacement, picked by the generator, which is mixed into the hash to choose the key.
+*/
+typedef struct GonSchema {
+	const char* const*  keys;			// text of each key, by key number
+	const int*          lengths;		// length of each key
+	int                 key_count;
+	const unsigned int* displacements;	// one per bucket
+	int                 bucket_count;
+	uint64_t            seed;
+} GonSchema;
+
+static inline uint64_t gon_mph_mix(uint64_t x) {
+	x ^= x >> 33;
+	x *= 0xFF51AFD7ED558CCDull;
+	x ^= x >> 33;
+	return x;
+}
+
+// The last characters of a name barely reach the top bits of FNV-1a, so the result is mixed before its top bits are used for the bucket
+static inline uint64_t gon_mph_hash(const char* name, size_t length, uint64_t seed) {
+	uint64_t hash = 14695981039346656037ull ^ seed;
+	for (size_t i = 0; i < length; i++) hash = (hash ^ (unsigned char)name[i]) * 1099511628211ull;
+	return gon_mph_mix(hash);
+}
+
+static inline unsigned int gon_mph_bucket(uint64_t hash, unsigned int bucket_count) {
+	return (unsigned int)(((hash >> 32) * bucket_count) >> 32);
+}
+
+// Mixes a bucket's displacement into the hash, and reduces the result to a key number
+static inline unsigned int gon_mph_key(uint64_t hash, unsigned int displacement, unsigned int key_count) {
+	uint64_t x = gon_mph_mix(hash ^ (displacement * 0x9E3779B97F4A7C15ull));
+	return (unsigned int)(((x & 0xFFFFFFFFu) * key_count) >> 32);
+}
+
+// Gets the key number of a name, or -1 if the name is not in the schema
+static inline int gon_schema_key(const GonSchema* schema, const char* name, size_t length) {
+	uint64_t     hash = gon_mph_hash(name, length, schema->seed);
+	unsigned int key  = gon_mph_key(hash, schema->displacements[gon_mph_bucket(hash, schema->bucket_count)], schema->key_count);
+	if ((size_t)schema->lengths[key] != length || memcmp(schema->keys[key], name, length) != 0) return -1;
+	return (int)key;
+}
+
+// Fills children[key] (which must have room for key_count fields) with the first child of the object for each key, or NULL
+// Returns the number of keys found
+int gon_schema_index(const GonSchema* schema, GonField* object, GonField** children) {
+	memset(children, 0, schema->key_count * sizeof(GonField*));
+	if (!gon_type_check(object, GON_TYPE_OBJECT)) return 0;
+
+	int found = 0;
+	GonField* child = object + 1;
+	#ifdef GON_USING_COMPACT_FIELDS
+	GonField* end = object + object->size + (object->self != 0);
+	while (found < schema->key_count && child < end) {
+	#else
+	for (int i = 0; found < schema->key_count && i < object->count; i++) {
+	#endif
+		int key = gon_schema_key(schema, gon_name(child), gon_name_length(child));
+		if (key >= 0 && !children[key]) {
+			children[key] = child;
+			found++;
+		}
+		child += child->type == GON_TYPE_FIELD ? 1 : child->size + 1;
+	}
+	return found;
+}
+
+// Gets a child by name from a table filled by gon_schema_index(), with one hash and no walk over the object
+// Returns NULL for names outside the schema and for keys the object does not have
+GonField* gon_schema_get_field(const GonSchema* schema, GonField* const* children, const char* name) {
+	int key = gon_schema_key(schema, name, strlen(name));
+	return key < 0 ? NULL : children[key];
+}
+
+/*
+	File Loading
+
+	When mapping, the whole file is first reserved as anonymous zeroed memory, rounded up to a page past the end of the file, and the file is then mapped over the start of it.
+	This way the byte at file_length is a writable null even when the file is an exact multiple of the page size.
+	On Windows, a view cannot be placed over a reservation, so files with no room after them in their last page are read into memory instead.
+	Where the headers offer no anonymous mappings (glibc hides MAP_ANONYMOUS under a strict -std=c99), every file is read instead.
+*/
+#ifdef GON_USING_MMAP
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(MAP_ANONYMOUS)
+#define GON_MAP_ANONYMOUS MAP_ANONYMOUS
+#elif defined(MAP_ANON)
+#define GON_MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+#endif
+
+// Releases the file buffer, however it was allocated
+void gon_free_file(GonFile* gon) {
+	#ifdef GON_USING_DYNAMIC_BUFFER
+	if (gon->fields_in_file) {
+		#ifdef GON_USING_INDEX
+		gon_free_index(gon);
+		#endif
+		gon->fields = NULL;
+		gon->field_capacity = 0;
+		gon->fields_in_file = false;
+	}
+	#endif
+	#ifdef GON_USING_MMAP
+	if (gon->file_mapping) {
+		#ifdef _WIN32
+		UnmapViewOfFile(gon->file);
+		#else
+		munmap(gon->file, gon->file_mapping);
+		#endif
+		gon->file = NULL;
+		gon->file_mapping = 0;
+		return;
+	}
+	#endif
+	free(gon->file);
+	gon->file = NULL;
+}
+
+// Reads the whole file into a malloc'd buffer with a null after it
+int gon_read_file(GonFile* gon, FILE* fp, size_t length) {
+	gon->file = (char*)malloc(length + 1);
+	if (!gon->file) {
+		puts("GON load error: Unable to alloc file buffer.");
+		return 1;
+	}
+	if (length && fread(gon->file, 1, length, fp) != length) {
+		puts("GON load error: Unable to read file.");
+		free(gon->file);
+		gon->file = NULL;
+		return 1;
+	}
+	gon->file[length] = 0;
+	gon->file_length  = length;
+	return 0;
+}
+
+#if defined(GON_USING_MMAP) && defined(GON_MAP_ANONYMOUS)
+// Same as gon_read_file(), but reads from a descriptor, for files too small to be worth mapping
+static int gon_read_fd(GonFile* gon, int fd, size_t length) {
+	gon->file = (char*)malloc(length + 1);
+	if (!gon->file) {
+		puts("GON load error: Unable to alloc file buffer.");
+		return 1;
+	}
+	for (size_t done = 0; done < length; ) {
+		ssize_t n = read(fd, gon->file + done, length - done);
+		if (n <= 0) {
+			puts("GON load error: Unable to read file.");
+			free(gon->file);
+			gon->file = NULL;
+			return 1;
+		}
+		done += (size_t)n;
+	}
+	gon->file[length] = 0;
+	gon->file_length  = length;
+	return 0;
+}
+#endif
+
+// Loads the file at path into the GonFile, replacing any file it already holds
+// The fields are left alone, so that they can be reused by the next gon_parse()
+int gon_load_file(GonFile* gon, const char* path) {
+	gon_free_file(gon);
+	gon->file_length = 0;
+
+	#if defined(GON_USING_MMAP) && defined(GON_MAP_ANONYMOUS)
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		printf("GON load error: Unable to open file %s.\n", path);
+		return 1;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		printf("GON load error: Unable to stat file %s.\n", path);
+		close(fd);
+		return 1;
+	}
+
+	size_t length  = (size_t)st.st_size;
+	if (length < GON_MMAP_MIN_SIZE) {
+		int result = gon_read_fd(gon, fd, length);
+		close(fd);
+		return result;
+	}
+
+	#ifdef GON_NON_DESTRUCTIVE
+	int prot = PROT_READ;						// the parser never writes to the file, so every page can stay shared with the page cache
+	#else
+	int prot = PROT_READ | PROT_WRITE;
+	#endif
+	size_t page    = (size_t)sysconf(_SC_PAGESIZE);
+	size_t mapping = (length + page) & ~(page - 1);		// always at least one byte past the end of the file
+
+	char* file = (char*)mmap(NULL, mapping, prot, MAP_PRIVATE | GON_MAP_ANONYMOUS, -1, 0);
+	if (file == (char*)MAP_FAILED) {
+		puts("GON load error: Unable to map file.");
+		close(fd);
+		return 1;
+	}
+	if (length && mmap(file, length, prot, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		puts("GON load error: Unable to map file.");
+		munmap(file, mapping);
+		close(fd);
+		return 1;
+	}
+	close(fd);
+
+	// the parser reads the file front to back exactly once, so ask for aggressive readahead and to start it now
+	#ifdef MADV_SEQUENTIAL
+	madvise(file, length, MADV_SEQUENTIAL);
+	#endif
+	#ifdef MADV_WILLNEED
+	madvise(file, length, MADV_WILLNEED);
+	#endif
+
+	gon->file         = file;
+	gon->file_length  = length;
+	gon->file_mapping = mapping;
+	return 0;
+
+	#else
+	FILE* fp = fopen(path, "rb");
+	if (!fp) {
+		printf("GON load error: Unable to open file %s.\n", path);
+		return 1;
+	}
+	fseek(fp, 0L, SEEK_END);
+	size_t length = (size_t)ftell(fp);
+	rewind(fp);
+
+	#if defined(GON_USING_MMAP) && defined(_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	if (length >= GON_MMAP_MIN_SIZE && length % info.dwPageSize != 0) {
+		HANDLE handle  = (HANDLE)_get_osfhandle(_fileno(fp));
+		#ifdef GON_NON_DESTRUCTIVE
+		HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+		char*  file    = mapping ? (char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+		#else
+		HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		char*  file    = mapping ? (char*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0) : NULL;
+		#endif
+		if (mapping) CloseHandle(mapping);
+		if (file) {
+			fclose(fp);
+			gon->file         = file;	// the rest of the last page is zeroed, so file[length] is already null
+			gon->file_length  = length;
+			gon->file_mapping = length + 1;
+			return 0;
+		}
+	}
+	#endif
+
+	int result = gon_read_file(gon, fp, length);
+	fclose(fp);
+	return result;
+	#endif
+}
+
+static inline GonFile gon_create(void) {
+	GonFile gon = { 0 };
+	return gon;
+}
+
+// Gets the GonFile ready for another file, keeping the fields buffer (and its capacity) for the next parse
+// The file is released the same way as by gon_free()
+void gon_reset(GonFile* gon) {
+	#ifdef GON_USING_INDEX
+	gon_free_index(gon);
+	#endif
+	gon_free_file(gon);
+	gon->file_length = 0;
+}
+
+void gon_free(GonFile* gon) {
+	#ifdef GON_USING_INDEX
+	gon_free_index(gon);
+	#endif
+	gon_free_file(gon);
+	#ifdef GON_USING_DYNAMIC_BUFFER
+	gon_free_fields(gon);
+	#endif
+}
+
+/*
+	Batch Loading
+
+	gon_load_many() loads and parses a list of files into an array of GonFiles, spread over a pool of threads. This is the way to load a directory of small data files at startup.
+	With more than one thread, the files are sized up front and dealt out largest first, round robin, so that each thread starts on one of the biggest files and the small ones fill in the gaps at the end.
+	Each thread works through its own queue from the largest file down. Once that is empty it steals from the small end of the other threads' queues, so no thread sits idle while another still has a backlog.
+	Each thread parses into one fields buffer of its own, which grows to fit the largest file it sees, and then copies the finished fields into a buffer of exactly the right size for the GonFile. So no file pays for the buffer growing one step at a time.
+	Pass a GonLoadStats to get the totals and where the time went.
+	Requires GON_USING_THREADS.
+*/
+#ifdef GON_USING_THREADS
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <time.h>
+#include <unistd.h>
+#endif
+
+typedef struct GonLoadStats {
+	int    files;			// number of files loaded and parsed
+	int    failed;			// number of files which could not be loaded or parsed
+	int    threads;			// number of threads used
+	int    steals;			// number of files taken from another thread's queue
+	size_t bytes;			// total size of the files which were loaded
+	size_t fields;			// total number of fields in the files which were parsed
+	double seconds;			// wall-clock time for the whole call
+	double size_seconds;	// wall-clock time spent sizing the files before any were loaded
+	double load_seconds;	// time spent reading the files, added up over every thread
+	double parse_seconds;	// time spent parsing and copying out the fields, added up over every thread
+} GonLoadStats;
+
+typedef struct GonLoadJob {
+	size_t size;
+	int    index;			// position in the paths and out arrays
+} GonLoadJob;
+
+typedef struct GonLoadWorker {
+	const char* const* paths;
+	GonFile*           out;
+	GonLoadJob*        jobs;		// every job, sorted largest first
+	struct GonLoadWorker* workers;
+	int       worker_count;
+	int       self;
+	int       path_count;
+	int*      queue;				// this worker's share of jobs, largest first
+	uint64_t  bounds;				// head of the queue in the low 32 bits and tail in the high 32, so that both ends move with one compare and swap
+	GonLoadStats stats;
+} GonLoadWorker;
+
+// Largest first, and in path order for files of the same size
+static int gon_load_job_compare(const void* a, const void* b) {
+	const GonLoadJob* x = (const GonLoadJob*)a;
+	const GonLoadJob* y = (const GonLoadJob*)b;
+	if (x->size != y->size) return x->size < y->size ? 1 : -1;
+	return x->index - y->index;
+}
+
+static inline double gon_seconds(void) {
+	#ifdef _WIN32
+	LARGE_INTEGER count, frequency;
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&frequency);
+	return (double)count.QuadPart / (double)frequency.QuadPart;
+	#elif defined(CLOCK_MONOTONIC)
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + now.tv_nsec * 1e-9;
+	#else
+	return (double)clock() / CLOCKS_PER_SEC;		// a strict -std=c99 hides clock_gettime(), and only the stats use these times
+	#endif
+}
+
+static inline bool gon_compare_swap64(uint64_t* value, uint64_t expected, uint64_t desired) {
+	#if defined(_MSC_VER) && !defined(__clang__)
+	return (uint64_t)InterlockedCompareExchange64((volatile LONG64*)value, (LONG64)desired, (LONG64)expected) == expected;
+	#else
+	return __atomic_compare_exchange_n(value, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+	#endif
+}
+
+// Takes the job at the head of a queue (steal is false) or at its tail (steal is true), or returns -1 if it is empty
+static int gon_load_take(GonLoadWorker* worker, bool steal) {
+	while (true) {
+		#if defined(_MSC_VER) && !defined(__clang__)
+		uint64_t bounds = *(volatile uint64_t*)&worker->bounds;
+		#else
+		uint64_t bounds = __atomic_load_n(&worker->bounds, __ATOMIC_ACQUIRE);
+		#endif
+		uint32_t head = (uint32_t)bounds, tail = (uint32_t)(bounds >> 32);
+		if (head >= tail) return -1;
+		uint64_t taken = steal ? ((uint64_t)(tail - 1) << 32 | head) : ((uint64_t)tail << 32 | (head + 1));
+		if (gon_compare_swap64(&worker->bounds, bounds, taken)) return worker->queue[steal ? tail - 1 : head];
+	}
+}
+
+// Sizing pass: each worker stats every worker_count'th file
+void gon_load_size_job(void* job) {
+	GonLoadWorker* worker = (GonLoadWorker*)job;
+	for (int i = worker->self; i < worker->path_count; i += worker->worker_count) {
+		#ifdef _WIN32
+		struct _stat64 st;
+		worker->jobs[i].size = _stat64(worker->paths[i], &st) == 0 ? (size_t)st.st_size : 0;
+		#else
+		struct stat st;
+		worker->jobs[i].size = stat(worker->paths[i], &st) == 0 ? (size_t)st.st_size : 0;
+		#endif
+		worker->jobs[i].index = i;
+	}
+}
+
+// Loading pass: works through the worker's own queue, then steals from the others until every queue is empty
+void gon_load_worker_job(void* job) {
+	GonLoadWorker* worker = (GonLoadWorker*)job;
+	GonFile scratch = gon_create();
+
+	while (true) {
+		int i = gon_load_take(worker, false);
+		for (int v = 1; i < 0 && v < worker->worker_count; v++) {
+			i = gon_load_take(&worker->workers[(worker->self + v) % worker->worker_count], true);
+			if (i >= 0) worker->stats.steals++;
+		}
+		if (i < 0) break;
+
+		GonFile* gon = &worker->out[i];
+		*gon = gon_create();
+		double start = gon_seconds();
+		if (gon_load_file(gon, worker->paths[i])) {
+			worker->stats.failed++;
+			continue;
+		}
+		double loaded = gon_seconds();
+		worker->stats.load_seconds += loaded - start;
+
+		// parse into the scratch buffer, then give the file a copy of exactly the size it needs
+		scratch.file        = gon->file;
+		scratch.file_length = gon->file_length;
+		bool ok = !gon_parse(&scratch);
+		if (ok) {
+			size_t count = scratch.fields[0].size;
+			GonField* block = (GonField*)malloc((count + GON_FIELDS_HEADER_SLOTS) * sizeof(GonField));
+			if (block) {
+				memcpy(block, scratch.fields - GON_FIELDS_HEADER_SLOTS, (count + GON_FIELDS_HEADER_SLOTS) * sizeof(GonField));
+				gon->fields         = block + GON_FIELDS_HEADER_SLOTS;
+				gon->field_capacity = count;
+				worker->stats.fields += count;
+			}
+			else {
+				puts("GON load error: Unable to alloc gon fields buffer.");
+				ok = false;
+			}
+		}
+		scratch.file = NULL;
+		if (ok) {
+			worker->stats.files++;
+			worker->stats.bytes += gon->file_length;
+		}
+		else {
+			gon_free(gon);
+			worker->stats.failed++;
+		}
+		worker->stats.parse_seconds += gon_seconds() - loaded;
+	}
+	gon_free_fields(&scratch);
+}
+
+// Gets the number of threads the machine can run at once
+static inline int gon_thread_count(void) {
+	#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+	#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int)count : 1;
+	#endif
+}
+
+// Loads and parses count files into out[0, count), using up to thread_count threads (or one per core if thread_count is 0)
+// Files which cannot be loaded or parsed are left empty in out. Free each GonFile with gon_free() as usual.
+// stats may be NULL. Returns the number of files which failed (so 0 if every file was loaded)
+int gon_load_many(const char* const* paths, int count, GonFile* out, int thread_count, GonLoadStats* stats) {
+	double start = gon_seconds();
+	if (thread_count <= 0) thread_count = gon_thread_count();
+	if (thread_count > count) thread_count = count;
+	if (thread_count < 1)     thread_count = 1;
+
+	GonLoadJob*    jobs    = (GonLoadJob*)malloc((count ? count : 1) * sizeof(GonLoadJob));
+	int*           queues  = (int*)malloc((count ? count : 1) * sizeof(int));
+	GonLoadWorker* workers = (GonLoadWorker*)calloc(thread_count, sizeof(GonLoadWorker));
+	if (!jobs || !queues || !workers) {
+		puts("GON load error: Unable to alloc batch loading buffers.");
+		free(jobs);
+		free(queues);
+		free(workers);
+		for (int i = 0; i < count; i++) out[i] = gon_create();
+		if (stats) {
+			memset(stats, 0, sizeof(GonLoadStats));
+			stats->failed = count;
+		}
+		return count;
+	}
+	for (int w = 0; w < thread_count; w++) {
+		workers[w].paths        = paths;
+		workers[w].out          = out;
+		workers[w].jobs         = jobs;
+		workers[w].workers      = workers;
+		workers[w].worker_count = thread_count;
+		workers[w].self         = w;
+		workers[w].path_count   = count;
+	}
+
+	// size every file, then deal them out largest first (a single thread just takes them in order)
+	if (thread_count > 1) {
+		gon_run_jobs(gon_load_size_job, workers, sizeof(GonLoadWorker), thread_count);
+		qsort(jobs, count, sizeof(GonLoadJob), gon_load_job_compare);
+	}
+	else for (int i = 0; i < count; i++) jobs[i].index = i;
+	double sized = gon_seconds();
+	int* queue = queues;
+	for (int w = 0; w < thread_count; w++) {
+		int length = 0;
+		for (int i = w; i < count; i += thread_count) queue[length++] = jobs[i].index;
+		workers[w].queue  = queue;
+		workers[w].bounds = (uint64_t)length << 32;
+		queue += length;
+	}
+
+	gon_run_jobs(gon_load_worker_job, workers, sizeof(GonLoadWorker), thread_count);
+
+	GonLoadStats total;
+	memset(&total, 0, sizeof(total));
+	for (int w = 0; w < thread_count; w++) {
+		total.files         += workers[w].stats.files;
+		total.failed        += workers[w].stats.failed;
+		total.steals        += workers[w].stats.steals;
+		total.bytes         += workers[w].stats.bytes;
+		total.fields        += workers[w].stats.fields;
+		total.load_seconds  += workers[w].stats.load_seconds;
+		total.parse_seconds += workers[w].stats.parse_seconds;
+	}
+	total.threads      = thread_count;
+	total.size_seconds = sized - start;
+	total.seconds      = gon_seconds() - start;
+	if (stats) *stats = total;
+
+	free(jobs);
+	free(queues);
+	free(workers);
+	return total.failed;
+}
+#endif
+
+/*
+	Hot Reloading
+
+	gon_reparse_range() brings a parsed GonFile up to date with an edited copy of its text, reparsing only the smallest named object around the edit.
+	The edit is given as the range [start, end) of the new text which differs from the old text (everything before start, and everything from end on, must be the same as before, shifted by the change in length).
+	The object is found from the fields on either side of the edit: it must open before start, and close in the unchanged text after end.
+	Its body is parsed on its own, and checked against the first field after the edit: that field must be reached at the same depth, either inside the object or after the braces and brackets which close around it, which means the rest of the file parses exactly as it did.
+	If it does not (say, the edit added or removed a brace), the next object out is tried, and the last resort is a full parse.
+	The new fields are spliced into the fields array in place of the old ones. The object's ancestors have their size adjusted, the fields after it are moved along, and every name and value is pointed into the new text.
+	This costs a parse of the object, plus a pass over the fields array and a copy of the text (to carry over the nulls which gon_parse() left in the old text), which are both far cheaper than parsing.
+	If the edit leaves the length of the text alone (and the old text is not mapped from the file), the object's body is copied into the old text instead, and the pass and the copy are skipped.
+	Hash tables from GON_USING_INDEX are kept for every object outside the reparsed one.
+
+	GonWatch keeps a GonFile in sync with a file on disk. gon_watch_poll() checks for a change (through inotify on Linux, and the modification time elsewhere), finds the edited range by comparing the new text with the last, and calls gon_reparse_range().
+
+	Requires GON_USING_DYNAMIC_BUFFER, and is not available with GON_USING_COMPACT_FIELDS.
+*/
+#if defined(GON_USING_DYNAMIC_BUFFER) && !defined(GON_USING_COMPACT_FIELDS)
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Finds the brace or bracket which closes the object or array opened just before pos, or returns limit if it is never closed
+static size_t gon_lex_close(const char* text, size_t pos, size_t limit) {
+	int depth = 0;
+	while ((pos = gon_lex_space(text, pos, limit)) < limit) {
+		char c = text[pos];
+		if (c == '{' || c == '[') depth++;
+		else if (c == '}' || c == ']') {
+			if (depth-- == 0) return pos;
+		}
+		else if (c != 0) {
+			pos = gon_lex_token(text, pos, limit);
+			continue;
+		}
+		pos++;
+	}
+	return limit;
+}
+
+// Offset of the start of a field's name (or value, in an array) in the text it was parsed from, or -1 for objects and arrays in an array
+static inline ptrdiff_t gon_token_offset(const GonFile* gon, const GonField* field) {
+	if (field->name)                  return field->name  - gon->file - !(field->flags & GON_FLAG_NAME_PLAIN);
+	if (field->type == GON_TYPE_FIELD) return field->value - gon->file - !(field->flags & GON_FLAG_VALUE_PLAIN);
+	return -1;
+}
+
+// Index of the first field at or after i which has a token offset, or count if there is none
+static inline int gon_next_token_field(const GonFile* gon, int i, int count) {
+	while (i < count && gon_token_offset(gon, &gon->fields[i]) < 0) i++;
+	return i;
+}
+
+// Parses a whole new text into a new set of fields, and swaps it in if it parses
+static int gon_reparse_all(GonFile* gon, GonFile* edited, GonField** changed) {
+	edited->allocator = gon->allocator;
+	if (gon_parse(edited)) return 1;
+	gon_free(gon);
+	*gon = *edited;
+	*edited = gon_create();
+	if (changed) *changed = gon->fields;
+	return 0;
+}
+
+// Checks that the text from the object at c's closing brace up to the field b (or the end of the text, if b is count) only closes the objects and arrays around c, as it did before
+// b must also be the next field after c's children (or count if there are none), so that no field after the object was touched by the edit
+static bool gon_reparse_follows(const GonFile* gon, int c, int b, int count, const char* text, size_t close, size_t target) {
+	const GonField* fields = gon->fields;
+	if (close >= target || b != c + fields[c].size + 1) return false;
+	int at = fields[c].parent;
+	size_t pos = close + 1;
+	while ((pos = gon_lex_space(text, pos, target)) < target) {
+		char closer = fields[at].type == GON_TYPE_OBJECT ? '}' : ']';
+		if (at == 0 || text[pos] != closer) return false;
+		at = fields[at].parent;
+		pos++;
+	}
+	return b < count ? fields[b].parent == at : at == 0;
+}
+
+// Parses the body of the object at c in the old fields from text[open + 1, close), and if the old field b is inside the object, checks that it is still reached at the same depth
+// The body is parsed from a copy, so that a failed attempt leaves text as it was. Returns 0 and fills sub in if it fits
+static int gon_reparse_object(GonFile* gon, int c, int b, const char* text, size_t open, size_t close, ptrdiff_t b_offset, GonFile* sub, char** copy) {
+	size_t length = close - open - 1;
+	*copy = (char*)malloc(length + 1);
+	if (!*copy) return 1;
+	memcpy(*copy, text + open + 1, length);
+	(*copy)[length] = 0;
+	*sub = gon_create();
+	sub->allocator   = gon->allocator;
+	sub->file        = *copy;
+	sub->file_length = length;
+	bool ok = !gon_parse(sub);
+
+	// find b in the new fields, by the offset its token now starts at, and compare the objects and arrays between it and the reparsed object
+	if (ok && b <= c + gon->fields[c].size) {
+		int count = sub->fields[0].size;
+		int n = 1;
+		while (n < count && gon_token_offset(sub, &sub->fields[n]) + (ptrdiff_t)open + 1 != b_offset) n++;
+		ok = n < count && (gon->fields[b].name != NULL) == (sub->fields[n].name != NULL);
+		int old_at = ok ? gon->fields[b].parent : c, new_at = ok ? sub->fields[n].parent : 0;
+		while (ok && old_at != c) {
+			ok = new_at != 0 && gon->fields[old_at].type == sub->fields[new_at].type;
+			old_at = gon->fields[old_at].parent;
+			new_at = sub->fields[new_at].parent;
+		}
+		ok = ok && new_at == 0;
+	}
+	sub->file = NULL;
+	if (ok) return 0;
+	gon_free_fields(sub);
+	free(*copy);
+	*copy = NULL;
+	return 1;
+}
+
+/*
+	Updates gon to the new text in edited (loaded with gon_load_file(), or malloc'd with a null after it), which differs from the text gon was parsed from only in [start, end)
+	On success gon takes over the new text, edited is left empty, changed (if not NULL) is set to the object which was reparsed (the root after a full parse), and 0 is returned
+	If the new text does not parse, 1 is returned and both are left as they were
+*/
+int gon_reparse_range(GonFile* gon, GonFile* edited, size_t start, size_t end, GonField** changed) {
+	const char* text = edited->file;
+	size_t    length = edited->file_length;
+	ptrdiff_t delta  = (ptrdiff_t)length - (ptrdiff_t)gon->file_length;
+	ptrdiff_t old_end = (ptrdiff_t)end - delta;
+	int count = gon->fields && !gon->fields_in_file ? gon->fields[0].size : 0;
+	if (!count || start > end || end > length || old_end < (ptrdiff_t)start) return gon_reparse_all(gon, edited, changed);
+	if (start == end && !delta) {
+		gon_free_file(edited);
+		edited->file_length = 0;
+		if (changed) *changed = NULL;
+		return 0;
+	}
+
+	// the last field starting before the edit, found by binary search since fields are in the order they appear in the text
+	int lo = 1, hi = count;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		int at  = gon_next_token_field(gon, mid, count);
+		if (at < count && gon_token_offset(gon, &gon->fields[at]) < (ptrdiff_t)start) lo = mid + 1;
+		else hi = mid;
+	}
+	int anchor = lo - 1;
+
+	// the first field starting after the edit (or count if there is none)
+	int b = gon_next_token_field(gon, anchor + 1, count);
+	while (b < count && gon_token_offset(gon, &gon->fields[b]) < old_end) b = gon_next_token_field(gon, b + 1, count);
+	if (!anchor) return gon_reparse_all(gon, edited, changed);
+	ptrdiff_t b_offset = b < count ? gon_token_offset(gon, &gon->fields[b]) + delta : (ptrdiff_t)length;
+
+	// try the objects around the edit from the inside out
+	GonFile sub;
+	char*   copy = NULL;
+	size_t  open = 0, close = 0;
+	int c = anchor;
+	for (; c; c = gon->fields[c].parent) {
+		GonField* object = &gon->fields[c];
+		if (object->type != GON_TYPE_OBJECT || !object->name) continue;
+		size_t name = (size_t)gon_token_offset(gon, object);
+		open = gon_lex_space(text, gon_lex_token(text, name, start), start);
+		if (open >= start || text[open] != '{') continue;
+		close = gon_lex_close(text, open + 1, length);
+		if (close >= length || close < end || text[close] != '}') continue;
+		if (b > c + object->size && !gon_reparse_follows(gon, c, b, count, text, close, (size_t)b_offset)) continue;
+		if (!gon_reparse_object(gon, c, b, text, open, close, b_offset, &sub, &copy)) break;
+	}
+	if (!c) return gon_reparse_all(gon, edited, changed);
+
+	// make room for the new fields, moving everything after the old ones along
+	GonField* object = &gon->fields[c];
+	int old_size = object->size;
+	int new_size = sub.fields[0].size - 1;
+	int diff     = new_size - old_size;
+	if ((size_t)(count + diff) > gon->field_capacity && gon_resize_fields(gon, count + diff)) {
+		puts("GON parse error: Unable to realloc gon fields buffer.");
+		gon_free_fields(&sub);
+		free(copy);
+		return 1;
+	}
+	GonField* fields = gon->fields;
+	#ifdef GON_USING_INDEX
+	for (int i = c; i <= c + old_size; i++) if (fields[i].type != GON_TYPE_FIELD) free(fields[i].index);
+	#endif
+	memmove(&fields[c + new_size + 1], &fields[c + old_size + 1], (count - (c + old_size + 1)) * sizeof(GonField));
+
+	// copy in the new fields, pointing them into the new text
+	// an edit which leaves the length alone is copied into the old text instead, so that the fields outside the object can stay where they point
+	// (unless the old text is a mapping of the file, which may be read-only, and may show writes to the file made since)
+	bool  keep = delta == 0 && !gon->file_mapping;
+	char* file = keep ? gon->file : edited->file;
+	for (int i = 1; i <= new_size; i++) {
+		GonField* field = &fields[c + i];
+		*field = sub.fields[i];
+		field->parent = field->parent ? field->parent + c : c;
+		if (field->name) field->name = file + open + 1 + (field->name - copy);
+		if (field->type == GON_TYPE_FIELD) field->value = file + open + 1 + (field->value - copy);
+	}
+	fields[c].size  = new_size;
+	fields[c].count = sub.fields[0].count;
+	#ifdef GON_USING_INDEX
+	fields[c].index = sub.fields[0].index;
+	#endif
+
+	// grow or shrink the ancestors, whose hash tables hold offsets to children after the object which have moved
+	for (int a = fields[c].parent;; a = fields[a].parent) {
+		fields[a].size += diff;
+		#ifdef GON_USING_INDEX
+		if (fields[a].index && fields[a].index->mask) {
+			GonIndexSlot* slots = (GonIndexSlot*)(fields[a].index + 1);
+			for (int s = 0; s <= fields[a].index->mask; s++) if (slots[s].child > c - a) slots[s].child += diff;
+		}
+		#endif
+		if (a == 0) break;
+	}
+
+	// move the parents of the fields after the object along, and point the fields before and after it into the new text
+	if (keep) {
+		if (diff) for (int i = c + new_size + 1; i < count + diff; i++) if (fields[i].parent > c) fields[i].parent += diff;
+	}
+	else {
+		for (int i = 1; i <= c; i++) {
+			if (fields[i].name) fields[i].name = file + (fields[i].name - gon->file);
+			if (fields[i].type == GON_TYPE_FIELD) fields[i].value = file + (fields[i].value - gon->file);
 		}
-		#else
-		if (field_index >= GON_FIELD_BUFFER_SIZE) {
-			printf("GON parse error: encountered unexpected token %c at field %i.\n", *index, field_index);
-			return 1;
+		for (int i = c + new_size + 1; i < count + diff; i++) {
+			if (fields[i].parent > c) fields[i].parent += diff;
+			if (fields[i].name) fields[i].name = file + (fields[i].name - gon->file) + delta;
+			if (fields[i].type == GON_TYPE_FIELD) fields[i].value = file + (fields[i].value - gon->file) + delta;
 		}
-		#endif
+	}
 
-		// step into object or array
-		if (*index == '{')					  goto L_StepIntoObject;
-		if (*index == '[') { in_array = true; goto L_StepIntoObject; }
-		goto L_ReadValue;
+	// carry the nulls and unescaped strings over from the old text, and bring in the ones from the new object's body
+	// (the copy the body was parsed from holds both the new text and the nulls written into it)
+	#ifndef GON_NON_DESTRUCTIVE
+	if (!keep) {
+		size_t old_close = close - delta;
+		memcpy(file, gon->file, open + 1);
+		memcpy(file + close + 1, gon->file + old_close + 1, gon->file_length - old_close - 1);
+	}
+	memcpy(file + open + 1, copy, close - open);
+	#else
+	if (keep) memcpy(file + open + 1, copy, close - open - 1);
+	#endif
 
-	L_StepIntoObject:;
-		gon->fields[field_index].type = GON_TYPE_OBJECT + in_array;	// set field type
-		*null_pos = 0;					// can safely place null after name after reading in '{'
-		index++;						// step over { or [
-		parent_index = field_index;		// set new parent index
-		field_index++;					// increment field index
-		continue;
+	gon_free_fields(&sub);
+	free(copy);
+	if (keep) gon_free_file(edited);
+	else {
+		gon_free_file(gon);
+		gon->file         = edited->file;
+		gon->file_length  = edited->file_length;
+		gon->file_mapping = edited->file_mapping;
+		edited->file         = NULL;
+		edited->file_mapping = 0;
+	}
+	edited->file_length = 0;
+	if (changed) *changed = &fields[c];
+	return 0;
+}
 
-	L_ReadValue:;
-		// read field value
-		if (!gon_lookup_non_text[*index]) {
-			*null_pos = 0;															// we can safely place null after field name now
-			gon->fields[field_index].type = GON_TYPE_FIELD;							// set the gon type to field
-			gon->fields[field_index].value = index;									// set the pointer to the start of the field's value string to the current index
+// Watches a file on disk for changes, keeping the GonFile parsed from it up to date
+typedef struct GonWatch {
+	char*   path;
+	char*   text;			// the text the GonFile was last parsed from, as it was before parsing
+	size_t  length;
+	#ifdef __linux__
+	int     fd;				// inotify descriptor, watching the file's directory (editors often save by renaming a new file over the old one)
+	#else
+	int64_t modified;		// modification time when the file was last loaded
+	#endif
+} GonWatch;
 
-			bool in_quotes = *index == '"';											// if the first character of a value string is " then the value string is enclosed in quotes
-			if (in_quotes) {														// if the field's value is enclosed in quotes, we need to do some extra work so that we can allow characters which are typically not allowed in naked gon string values
-				(gon->fields[field_index].value)++;									// move pointer for start of field value forward by one character so that we don't include the initial quotation mark
-				index++;															// step over the initial quotation mark
-				while (*index != '"')												// scan through string until we hit another (non-escaped) quotation mark
-					index += 1 + (*index == '\\');									// increment index by one, or increment by 2 if we hit a backslash (this character escapes the following character)
-			}
-			else while (!gon_lookup_non_text[*index]) index++;						// for strings not in quotes, just scan forward until the next next non-text character
-			null_pos = index;														// defer placing null after field value until either new field name or '}' or ']' is read
-			index += in_quotes;														// step over the end quotation mark if applicable
-			field_index++;															// increment the field index
-			continue;																// go back to top of loop to parse the next field
-		}
+void gon_watch_close(GonWatch* watch);
 
-		// if token was not the start of an object, array, or valid field value then error
-	L_Error:;
-		printf("GON parse error: encountered unexpected token %c at field %i.\n", *index, field_index);
+// Starts watching the file at path, and loads and parses it into gon
+int gon_watch_open(GonWatch* watch, GonFile* gon, const char* path) {
+	memset(watch, 0, sizeof(GonWatch));
+	#ifdef __linux__
+	watch->fd = -1;
+	#endif
+	size_t path_length = strlen(path);
+	watch->path = (char*)malloc(path_length + 1);
+	if (!watch->path) {
+		puts("GON watch error: Unable to alloc path.");
 		return 1;
 	}
+	memcpy(watch->path, path, path_length + 1);
 
-	*null_pos = 0;							// place final null 
-	gon->fields[0].size = field_index;		// set root object size
+	#ifdef __linux__
+	// watch the directory rather than the file, so that the watch outlives the file being replaced
+	const char* slash = strrchr(path, '/');
+	char* directory = (char*)malloc(path_length + 2);
+	if (!directory) {
+		puts("GON watch error: Unable to alloc path.");
+		gon_watch_close(watch);
+		return 1;
+	}
+	if (slash) {
+		memcpy(directory, path, slash - path + 1);
+		directory[slash - path + 1] = 0;
+	}
+	else strcpy(directory, ".");
+	watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	int watched = watch->fd >= 0 ? inotify_add_watch(watch->fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) : -1;
+	free(directory);
+	if (watched < 0) {
+		printf("GON watch error: Unable to watch file %s.\n", path);
+		gon_watch_close(watch);
+		return 1;
+	}
+	#else
+	struct stat st;
+	watch->modified = stat(path, &st) == 0 ? (int64_t)st.st_mtime : 0;
+	#endif
 
-	#ifdef GON_REALLOC_ON_COMPLETE
-	// realloc fields down to used size
-	GonField* fields_new = realloc(gon->fields, (gon->field_capacity = gon->fields[0].size + 1) * sizeof(GonField));
-	if (!fields_new) {
-		puts("GON parse error: Unable to realloc gon fields buffer.");
+	if (gon_load_file(gon, path)) {
+		gon_watch_close(watch);
+		return 1;
+	}
+	watch->text = (char*)malloc(gon->file_length + 1);
+	if (!watch->text) {
+		puts("GON watch error: Unable to alloc text buffer.");
+		gon_watch_close(watch);
+		return 1;
+	}
+	memcpy(watch->text, gon->file, gon->file_length + 1);
+	watch->length = gon->file_length;
+	if (gon_parse(gon)) {
+		gon_watch_close(watch);
 		return 1;
 	}
-	gon->fields = fields_new;
+	return 0;
+}
+
+// Checks whether the file has changed since it was last loaded
+static bool gon_watch_changed(GonWatch* watch) {
+	#ifdef __linux__
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	const char* slash = strrchr(watch->path, '/');
+	const char* file_name = slash ? slash + 1 : watch->path;
+	bool changed = false;
+	ssize_t length;
+	while ((length = read(watch->fd, buffer, sizeof(buffer))) > 0) {
+		for (char* at = buffer; at < buffer + length;) {
+			struct inotify_event* event = (struct inotify_event*)at;
+			if (event->len && strcmp(event->name, file_name) == 0) changed = true;
+			at += sizeof(struct inotify_event) + event->len;
+		}
+	}
+	return changed;
+	#else
+	struct stat st;
+	if (stat(watch->path, &st) != 0 || (int64_t)st.st_mtime == watch->modified) return false;
+	watch->modified = (int64_t)st.st_mtime;
+	return true;
 	#endif
+}
+
+// Brings gon up to date with the file if it has changed, reparsing only what the change touched
+// changed (if not NULL) is set to the object which was reparsed (see gon_reparse_range()), or NULL if the file has not changed
+// Returns 1 if the file could not be loaded or no longer parses, in which case gon is left as it was, and the next change is compared against the text gon still holds
+int gon_watch_poll(GonWatch* watch, GonFile* gon, GonField** changed) {
+	if (changed) *changed = NULL;
+	if (!gon_watch_changed(watch)) return 0;
+
+	GonFile edited = gon_create();
+	if (gon_load_file(&edited, watch->path)) return 1;
+	const char* text   = edited.file;
+	size_t      length = edited.file_length;
+	char* pristine = (char*)malloc(length + 1);
+	if (!pristine) {
+		puts("GON watch error: Unable to alloc text buffer.");
+		gon_free_file(&edited);
+		return 1;
+	}
+	memcpy(pristine, text, length + 1);
+
+	// the edited range is whatever lies between the longest common prefix and suffix of the old and new text
+	size_t shorter = length < watch->length ? length : watch->length;
+	size_t prefix = 0, suffix = 0;
+	while (prefix < shorter && text[prefix] == watch->text[prefix]) prefix++;
+	while (suffix < shorter - prefix && text[length - 1 - suffix] == watch->text[watch->length - 1 - suffix]) suffix++;
 
+	if (gon_reparse_range(gon, &edited, prefix, length - suffix, changed)) {
+		free(pristine);
+		gon_free(&edited);
+		return 1;
+	}
+	free(watch->text);
+	watch->text   = pristine;
+	watch->length = length;
 	return 0;
 }
 
-// Writes the contents of the GonFile to the buffer at dest
-// Buffer must be pre-allocated by caller
-void gon_serialize(GonFile* gon, char* dst, int tab_width) {
-	int parent_index = 0;
-	int field_index  = 1;
-	int indent		 = 0;
-	bool in_array	 = 0;
+// Stops watching the file. The GonFile is left alone, and freed with gon_free() as usual
+void gon_watch_close(GonWatch* watch) {
+	#ifdef __linux__
+	if (watch->fd >= 0) close(watch->fd);
+	watch->fd = -1;
+	#endif
+	free(watch->path);
+	free(watch->text);
+	watch->path = NULL;
+	watch->text = NULL;
+	watch->length = 0;
+}
+#endif
 
-	while (1) {
-		if (field_index >= gon->fields[0].size && parent_index == 0) break;
+/*
+	Baked Files
 
-		// Check if object ends
-		if (field_index - parent_index > gon->fields[parent_index].size) {
-			indent -= tab_width;
-			if (!in_array) memset(dst, ' ', indent), dst += indent; // add indentation
-			*dst = in_array ? ']' : '}', dst++;
+	gon_bake() writes a parsed GonFile out as a binary blob that gon_load_baked() can load without parsing anything.
+	The blob is a GonBakedHeader, one empty 16-byte slot, a record per field, and a pool of strings. Each string is stored once however many fields use it, and is unescaped, null-terminated and preceded by its 32-bit length.
+	Each record has the layout of a compact GonField: a name offset into the pool, then the parent, flags and type packed into one word, then the value offset (or size for objects and arrays), then the field's own index.
+	With GON_USING_COMPACT_FIELDS, gon_load_baked() maps the blob (see gon_load_file()) and points the fields at the records where they lie. The only write is to the empty slot, which becomes the GonFieldsHeader, so the load costs the same whatever the size of the blob, and pages are only read in as fields are used.
+	Otherwise, the records are expanded into a fields buffer in one pass, and names and values point into the mapped pool, so there is still no parsing or copying of strings.
+	Without compact fields, gon_load_baked() checks each record as it expands it (that the parent comes before it and is an object or array, that the type and size are in range, and that the strings lie in the pool), so a damaged blob is rejected rather than loaded.
+	With compact fields, only the header and root are checked, since the records are used as they lie. gon_load_baked_verified() also checks the checksum and every record before they become fields, in either mode, so use it when a blob may have been damaged on its way.
+	gon_verify_baked() checks the checksum of a blob that has already been loaded.
+	Baked fields live in the file, so they go away with it (in gon_free(), gon_reset() and gon_load_file()).
+	Blobs are tied to the byte order and version they were written with, but not to whether GON_USING_COMPACT_FIELDS is defined.
+*/
+#ifdef GON_USING_DYNAMIC_BUFFER
+#include <stdint.h>
 
-			parent_index = gon->fields[parent_index].parent;
-			in_array = (gon->fields[parent_index].type == GON_TYPE_ARRAY);
-			*dst = in_array ? ' ' : '\n'; dst++;
-			continue;
-		}
+#define GON_BAKED_VERSION 1
+#define GON_BAKED_ENDIAN  0x01020304u
+#define GON_BAKED_NO_NAME 0xFFFFFFFFu
 
-		// write field name
-		if (!in_array) {
-			if (!in_array) memset(dst, ' ', indent), dst += indent;	// add indentation
-
-			// check whether to enclose name and/or value in quotes
-			bool in_quotes = false;
-			char* c = gon->fields[field_index].name;
-			int len = 0;
-			while (*c) {
-				if (gon_lookup_non_text[*c]) in_quotes = true; 
-				len++, c++;
-			}
-
-			if (in_quotes) *dst = '"', dst++;
-			memcpy(dst, gon->fields[field_index].name, len);
-			dst += len;
-			if (in_quotes) *dst = '"', dst++;
-			*dst = ' ', dst++;
-		}
-
-		// Write field value
-		if (gon->fields[field_index].type == GON_TYPE_FIELD) {
-			bool in_quotes = false;
-			char* c = gon->fields[field_index].value;
-			int len = 0;
-			while (*c) {
-				if (gon_lookup_non_text[*c]) in_quotes = true;
-				len++, c++;
-			}
-			if (in_quotes) *dst = '"', dst++;
-			memcpy(dst, gon->fields[field_index].value, len);
-			dst += len;
-			if (in_quotes) *dst = '"', dst++;
-			*dst = in_array ? ' ' : '\n'; dst++;
-			field_index++;
-			continue;
-		}
+typedef struct GonBakedHeader {
+	char         magic[4];		// "GONB"
+	unsigned int version;		// GON_BAKED_VERSION
+	unsigned int endian;		// GON_BAKED_ENDIAN, as written by the machine that baked it
+	unsigned int field_count;	// number of fields, including the root
+	uint64_t     pool_offset;	// start of the string pool, from the start of the blob
+	uint64_t     pool_length;
+	uint64_t     checksum;		// gon_baked_checksum() of everything after the header and the empty slot
+	uint64_t     reserved;
+} GonBakedHeader;
 
-		// Step into object
-		if (gon->fields[field_index].type == GON_TYPE_ARRAY) {
-			in_array = 1;
-			*dst = '[', dst++;
-			*dst = ' ', dst++;
-		}
-		else {
-			*dst = '{',  dst++;
-			*dst = '\n', dst++;
+typedef struct GonBakedField {
+	unsigned int name;			// offset of the name in the pool, or GON_BAKED_NO_NAME for the root and values in arrays
+	unsigned int bits;			// parent | type << 30, matching the bitfields of a compact GonField (whose flags, in bits 28 and 29, are always 0, as the strings are stored unescaped)
+	unsigned int value;			// offset of the value in the pool, or size for objects and arrays
+	int          self;
+} GonBakedField;
+
+#define GON_BAKED_FIELDS_OFFSET (sizeof(GonBakedHeader) + sizeof(GonBakedField))
+
+// FNV-1a over 8 bytes at a time
+static inline uint64_t gon_baked_checksum(const char* data, size_t length, uint64_t hash) {
+	size_t i = 0;
+	for (; i + 8 <= length; i += 8) {
+		uint64_t word;
+		memcpy(&word, data + i, 8);
+		hash = (hash ^ word) * 1099511628211ull;
+	}
+	for (; i < length; i++) hash = (hash ^ (unsigned char)data[i]) * 1099511628211ull;
+	return hash;
+}
+
+// Pool of deduplicated strings being built by gon_bake()
+typedef struct GonBaker {
+	char*         pool;
+	size_t        pool_length;
+	size_t        pool_capacity;
+	unsigned int* table;			// offset + 1 of each string in the pool, by hash (0 if the slot is empty)
+	unsigned int  mask;
+} GonBaker;
+
+// Adds a string to the pool (removing its escapes if it still has them) and gets its offset
+// The string is always appended, and then taken back off if the pool already holds it
+static int gon_bake_string(GonBaker* b, const char* text, size_t length, bool escaped, unsigned int* offset) {
+	size_t needed = b->pool_length + 4 + length + 1;
+	if (needed >= GON_BAKED_NO_NAME) return 1;
+	if (needed > b->pool_capacity) {
+		size_t capacity = b->pool_capacity ? b->pool_capacity * 2 : 4096;
+		while (capacity < needed) capacity *= 2;
+		char* pool_new = (char*)realloc(b->pool, capacity);
+		if (!pool_new) return 1;
+		b->pool = pool_new;
+		b->pool_capacity = capacity;
+	}
+
+	char* dst = b->pool + b->pool_length + 4;
+	memcpy(dst, text, length);
+	if (escaped) length = gon_unescape(dst, dst, length);
+	dst[length] = 0;
+
+	unsigned int s = gon_hash_name(dst, length) & b->mask;
+	for (; b->table[s]; s = (s + 1) & b->mask) {
+		const char*  other = b->pool + b->table[s] - 1;
+		unsigned int other_length;
+		memcpy(&other_length, other - 4, 4);
+		if (other_length == length && memcmp(other, dst, length) == 0) {
+			*offset = b->table[s] - 1;
+			return 0;
 		}
-		indent += tab_width;
-		parent_index = field_index;
-		field_index++;
 	}
 
-	*dst = '\0'; // write null to end of file
+	unsigned int length32 = (unsigned int)length;
+	memcpy(dst - 4, &length32, 4);
+	*offset = (unsigned int)(dst - b->pool);
+	b->table[s] = *offset + 1;
+	b->pool_length += 4 + length + 1;
+	return 0;
 }
 
+// Adds a field's name or value to the pool
+static inline int gon_bake_text(GonBaker* b, const GonField* field, const char* text, size_t length, int escaped_flag, unsigned int* offset) {
+	#ifdef GON_NON_DESTRUCTIVE
+	return gon_bake_string(b, text, length, (field->flags & escaped_flag) != 0, offset);
+	#else
+	(void)field, (void)escaped_flag;	// gon_name() and gon_value() have already removed the escapes
+	return gon_bake_string(b, text, length, false, offset);
+	#endif
+}
 
-void gon_serialize_file(GonFile* gon, FILE* fp, int tab_width) {
-	int parent_index = 0;
-	int field_index  = 1;
-	int indent		 = 0;
-	bool in_array	 = 0;
+// Writes the parsed GonFile to path as a baked blob for gon_load_baked()
+int gon_bake(GonFile* gon, const char* path) {
+	size_t count = gon->fields[0].size;
+	size_t table_size = 64;
+	while (table_size < count * 2) table_size *= 2;
 
-	while (1) {
-		if (field_index >= gon->fields[0].size && parent_index == 0) break;
+	GonBaker b;
+	memset(&b, 0, sizeof(b));
+	b.table = (unsigned int*)calloc(table_size, sizeof(unsigned int));
+	b.mask  = (unsigned int)table_size - 1;
+	GonBakedField* records = (GonBakedField*)calloc(count, sizeof(GonBakedField));
+	int result = 1;
+	if (!b.table || !records) {
+		puts("GON bake error: Unable to alloc bake buffers.");
+		goto L_Done;
+	}
 
-		// check if object ends
-		if (field_index - parent_index > gon->fields[parent_index].size) {
-			indent -= tab_width;										// decrease indent
-			if (!in_array) for (int i = 0; i < indent; i++) fputc(' ', fp); // write indentation if not in array
-			fputc(in_array ? ']' : '}', fp);								// write object / array end token
-			parent_index = gon->fields[parent_index].parent;				// set parent index to grandparent
-			in_array = (gon->fields[parent_index].type == GON_TYPE_ARRAY);	// determine if parent is an array
-			fputc(in_array ? ' ' : '\n', fp);								// write newline on object/array end (or space if in array)
-			continue;
+	for (size_t i = 0; i < count; i++) {
+		GonField*      field  = &gon->fields[i];
+		GonBakedField* record = &records[i];
+		char* name = i ? gon_name(field) : NULL;		// the root's name is not stored
+		record->name = GON_BAKED_NO_NAME;
+		record->bits = (unsigned int)field->parent | (unsigned int)field->type << 30;
+		record->self = (int)i;
+		if (name && gon_bake_text(&b, field, name, gon_name_length(field), GON_FLAG_NAME_ESCAPED, &record->name)) goto L_TooLarge;
+		if (field->type == GON_TYPE_FIELD) {
+			if (gon_bake_text(&b, field, gon_value(field), gon_value_length(field), GON_FLAG_VALUE_ESCAPED, &record->value)) goto L_TooLarge;
 		}
+		else record->value = (unsigned int)field->size;
+	}
 
-		// write field name
-		if (!in_array) {
-			if (!in_array) for (int i = 0; i < indent; i++) fputc(' ', fp); // write indentation if not in array
-			bool in_quotes = false;
-			{
-				char* c = gon->fields[field_index].name;
-				int len = 0;
-				while (*c) {
-					if (gon_lookup_non_text[*c]) in_quotes = true;
-					len++, c++;
-				}
-			}
-			if (in_quotes) fputc('"', fp);									// start quotes
-			char* c = gon->fields[field_index].name;						// write name escaping characters as necessary
-			while (*c) {
-				if (*c == '\"' || *c == '\\') fputc('\\', fp);				// escape \ and "
-				fputc(*c, fp);												// write next character
-				c++;
-			}
-			if (in_quotes) fputc('"', fp);									// end quotes
-			fputc(' ', fp);													// add a space after name
-		}
-
-		// Write field value
-		if (gon->fields[field_index].type == GON_TYPE_FIELD) {
-			bool in_quotes = false;
-			{
-				char* c = gon->fields[field_index].value;
-				int len = 0;
-				while (*c) {
-					if (gon_lookup_non_text[*c]) in_quotes = true;
-					len++, c++;
-				}
-			}
-			if (in_quotes) fputc('"', fp);									// start quotes
-			char* c = gon->fields[field_index].value;						// copy value escaping characters as necessary
-			while (*c) {
-				if (*c == '\"' || *c == '\\') fputc('\\', fp);				// escape \ and "
-				fputc(*c, fp);												// write next character
-				c++;
-			}	
-			if (in_quotes) fputc('"', fp);									// end quotes
-			fputc(in_array ? ' ' : '\n', fp);								// write newline on field end (or space if in array)
-			field_index++;
-			continue;
-		}
+	{
+		GonBakedHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, "GONB", 4);
+		header.version     = GON_BAKED_VERSION;
+		header.endian      = GON_BAKED_ENDIAN;
+		header.field_count = (unsigned int)count;
+		header.pool_offset = GON_BAKED_FIELDS_OFFSET + count * sizeof(GonBakedField);
+		header.pool_length = b.pool_length;
+		header.checksum    = gon_baked_checksum(b.pool, b.pool_length, gon_baked_checksum((const char*)records, count * sizeof(GonBakedField), 14695981039346656037ull));
 
-		// Step into object
-		if (gon->fields[field_index].type == GON_TYPE_ARRAY) {
-			in_array = 1;
-			fputc('[', fp);
-			fputc(' ', fp);
+		FILE* fp = fopen(path, "wb");
+		if (!fp) {
+			printf("GON bake error: Unable to open file %s.\n", path);
+			goto L_Done;
 		}
-		else {
-			fputc('{', fp);
-			fputc('\n', fp);
+		GonBakedField slot;
+		memset(&slot, 0, sizeof(slot));
+		bool written = fwrite(&header, sizeof(header), 1, fp) == 1 && fwrite(&slot, sizeof(slot), 1, fp) == 1
+		            && fwrite(records, sizeof(GonBakedField), count, fp) == count
+		            && (!b.pool_length || fwrite(b.pool, 1, b.pool_length, fp) == b.pool_length);
+		if (fclose(fp) != 0 || !written) {
+			printf("GON bake error: Unable to write file %s.\n", path);
+			goto L_Done;
 		}
-		indent += tab_width;
-		parent_index = field_index;
-		field_index++;
 	}
+	result = 0;
+	goto L_Done;
 
-	fputc('\n', fp); // write null to end of file (probably not necessary, but its not hurting anything either)
+L_TooLarge:;
+	puts("GON bake error: Strings are too large for a baked file.");
+L_Done:;
+	free(b.pool);
+	free(b.table);
+	free(records);
+	return result;
 }
 
-// Gets the first child field with the given name if it exists, otherwise returns NULL
-// Assumes that parent is not NULL
-GonField* gon_get_field(GonField* parent, const char* name) {
-	if (!parent) {
-		printf("Tried to get field \"%s\" from null gon.", name);
-		return NULL;
-	} else if (parent->type != GON_TYPE_OBJECT) {
-		char* parent_name = (char*)(parent->name ? parent->name : "NULL");
-		printf("Tried to get field \"%s\" from non-object gon \"%s\".", name, parent_name);
-		return NULL;
-	}
-
-	int count = parent->count;
-	GonField* field = parent + 1;
-	for (int i = 0; i < count; i++) {
-		if (field->name && strcmp(field->name, name) == 0)
-			return field;
-		if (field->type != GON_TYPE_FIELD) // step over sub-fields of object and array types
-			field += field->size;
-		field++;
-	}
-	return NULL;
+// Gets the blob's header if it looks like a baked file that fits in file_length bytes, otherwise NULL
+static const GonBakedHeader* gon_baked_header(const GonFile* gon) {
+	const GonBakedHeader* header = (const GonBakedHeader*)gon->file;
+	if (!header || gon->file_length < GON_BAKED_FIELDS_OFFSET) return NULL;
+	if (memcmp(header->magic, "GONB", 4) != 0 || header->version != GON_BAKED_VERSION || header->endian != GON_BAKED_ENDIAN) return NULL;
+	if (header->field_count == 0 || header->field_count >= (1u << 28)) return NULL;
+	if (header->pool_offset != GON_BAKED_FIELDS_OFFSET + (uint64_t)header->field_count * sizeof(GonBakedField)) return NULL;
+	if (header->pool_length > gon->file_length - header->pool_offset || header->pool_offset > gon->file_length) return NULL;
+	return header;
 }
 
-// Tries to get a string value from the named field
-// If no field is found with matching name or field is wrong type, returns default value
-char* gon_get_value(GonField* parent, const char* name, char* default_value) {
-	GonField* field = gon_get_field(parent, name);
-	if (gon_type_check(field, GON_TYPE_FIELD))
-		return field->value;
-	return default_value;
+// Checks that a string offset points at a length-prefixed, null-terminated string inside the pool
+static inline bool gon_baked_string_fits(const char* pool, uint64_t pool_length, unsigned int offset) {
+	if (offset < 4 || offset >= pool_length) return false;
+	unsigned int length;
+	memcpy(&length, pool + offset - 4, 4);
+	return length < pool_length - offset && pool[offset + length] == 0;
 }
 
-// Tries to get an integer value from the named field
-// If no field is found with matching name or field is wrong type, returns default value
-int gon_get_int(GonField* parent, const char* name, int default_value) {
-	GonField* field = gon_get_field(parent, name);
-	if (gon_type_check(field, GON_TYPE_FIELD))
-		return atoi(field->value);
-	return default_value;
+// Checks record i against the records before it (which must already have been checked), returning true if it is damaged
+static bool gon_baked_record_damaged(const GonBakedField* records, size_t count, size_t i, const char* pool, uint64_t pool_length) {
+	const GonBakedField* record = &records[i];
+	unsigned int parent = record->bits & 0x0FFFFFFF;
+	unsigned int type   = record->bits >> 30;
+	if (record->self != (int)i || (record->bits & 0x30000000) || type == 0 || parent >= i) return true;
+	const GonBakedField* up = &records[parent];
+	if ((up->bits >> 30) == GON_TYPE_FIELD || i - parent > up->value) return true;						// outside of what its parent holds
+	if ((record->name != GON_BAKED_NO_NAME) != ((up->bits >> 30) == GON_TYPE_OBJECT)) return true;	// named exactly when its parent is an object
+	if (record->name != GON_BAKED_NO_NAME && !gon_baked_string_fits(pool, pool_length, record->name)) return true;
+	if (type == GON_TYPE_FIELD) return !gon_baked_string_fits(pool, pool_length, record->value);
+	return record->value > count - i - 1;
 }
 
-// Tries to get a float value from the named field
-// If no field is found with matching name or field is wrong type, returns default value
-double gon_get_float(GonField* parent, const char* name, double default_value) {
-	GonField* field = gon_get_field(parent, name);
-	if (gon_type_check(field, GON_TYPE_FIELD))
-		return atof(field->value);
-	return default_value;
+// Checks a GonFile loaded by gon_load_baked() against the checksum in its header, returning 1 if it does not match
+int gon_verify_baked(const GonFile* gon) {
+	const GonBakedHeader* header = gon_baked_header(gon);
+	if (!header) return 1;
+	size_t body = GON_BAKED_FIELDS_OFFSET;
+	return gon_baked_checksum(gon->file + body, (size_t)(header->pool_offset + header->pool_length) - body, 14695981039346656037ull) != header->checksum;
 }
 
-// Tries to get an boolean value from the named field (anything other than "true" returns false)
-// If no field is found with matching name or field is wrong type, returns default value
-bool gon_get_bool(GonField* parent, const char* name, bool default_value) {
-	GonField* field = gon_get_field(parent, name);
-	if (gon_type_check(field, GON_TYPE_FIELD))
-		return (strcmp(field->value, "true") == 0);
-	return default_value;
-}
+static int gon_load_baked_blob(GonFile* gon, const char* path, bool verify) {
+	#ifdef GON_USING_INDEX
+	gon_free_index(gon);
+	#endif
+	if (gon_load_file(gon, path)) return 1;
+	const GonBakedHeader* header = gon_baked_header(gon);
+	if (!header) {
+		printf("GON load error: %s is not a baked GON file of this version.\n", path);
+		gon_free_file(gon);
+		return 1;
+	}
+	size_t count = header->field_count;
+	GonBakedField* records = (GonBakedField*)(gon->file + GON_BAKED_FIELDS_OFFSET);
+	char* pool = gon->file + header->pool_offset;
+	if (records[0].self != 0 || records[0].bits != (unsigned int)GON_TYPE_OBJECT << 30 || records[0].value != count) {
+		printf("GON load error: %s has a damaged root field.\n", path);
+		gon_free_file(gon);
+		return 1;
+	}
+	if (verify) {
+		bool damaged = gon_verify_baked(gon) != 0;
+		for (size_t i = 1; i < count && !damaged; i++) damaged = gon_baked_record_damaged(records, count, i, pool, header->pool_length);
+		if (damaged) {
+			printf("GON load error: %s is damaged.\n", path);
+			gon_free_file(gon);
+			return 1;
+		}
+	}
 
-#define gon_iterate_array(gon_array, gon_it) \
-GonField* gon_it##_last = gon_array + gon_array->size; \
-for (GonField* gon_it = gon_array + 1; gon_it <= gon_it##_last; gon_it += (gon_it->type == GON_TYPE_FIELD ? 1 : gon_it->size + 1))
+	#ifdef GON_USING_COMPACT_FIELDS
+	// the records are only usable in place if this compiler packs the bitfields the same way
+	GonField probe;
+	memset(&probe, 0, sizeof(probe));
+	probe.parent = 1;
+	probe.type   = GON_TYPE_ARRAY;
+	unsigned int probe_bits;
+	memcpy(&probe_bits, (char*)&probe + sizeof(unsigned int), sizeof(unsigned int));
+	if (sizeof(GonField) != sizeof(GonBakedField) || probe_bits != (1u | (unsigned int)GON_TYPE_ARRAY << 30)) {
+		puts("GON load error: Compact fields do not match the baked layout with this compiler.");
+		gon_free_file(gon);
+		return 1;
+	}
 
-inline GonFile gon_create(void) {
-	GonFile gon = { 0 };
-	return gon;
+	gon_free_fields(gon);
+	gon->fields = (GonField*)records;
+	gon->field_capacity = count;
+	gon->fields_in_file = true;
+	GonFieldsHeader* fields_header = (GonFieldsHeader*)(gon->fields - 1);	// the empty slot
+	fields_header->file = pool;
+	#ifdef GON_USING_INDEX
+	fields_header->indices = NULL;
+	#endif
+	#else
+	if (gon->field_capacity < count && gon_resize_fields(gon, count)) {
+		puts("GON load error: Unable to alloc gon fields buffer.");
+		gon_free_file(gon);
+		return 1;
+	}
+	for (size_t i = 0; i < count; i++) {
+		const GonBakedField* record = &records[i];
+		if (i && !verify && gon_baked_record_damaged(records, count, i, pool, header->pool_length)) {
+			printf("GON load error: %s has a damaged field at %zu.\n", path, i);
+			gon->fields[0].size = (int)i;	// only the fields before this one were filled in
+			gon_free_file(gon);
+			return 1;
+		}
+		GonField* field = &gon->fields[i];
+		gon_init_field(field, (int)(record->bits & 0x0FFFFFFF), (int)i);
+		int type = (int)(record->bits >> 30);
+		if (record->name != GON_BAKED_NO_NAME) {
+			unsigned int length;
+			memcpy(&length, pool + record->name - 4, 4);
+			field->name = pool + record->name;
+			field->name_length = (int)length;
+		}
+		if (type == GON_TYPE_FIELD) {
+			unsigned int length;
+			memcpy(&length, pool + record->value - 4, 4);
+			field->type  = GON_TYPE_FIELD;
+			field->value = pool + record->value;
+			field->value_length = (int)length;
+		}
+		else {
+			gon_init_object(field, type);
+			field->size = (int)record->value;
+		}
+		if (i) gon->fields[field->parent].count++;
+	}
+	gon->fields[0].name = (char*)"root";
+	gon->fields[0].name_length = 4;
+	#ifdef GON_USING_ATOMS
+	if (gon_intern_fields(gon->fields, (int)count)) {
+		gon_free_file(gon);
+		return 1;
+	}
+	#endif
+	#endif
+	return 0;
 }
 
-void gon_free(GonFile* gon) {
-	free(gon->file);
-	#ifdef GON_USING_DYNAMIC_BUFFER
-	free(gon->fields);
-	#endif
+// Loads a blob written by gon_bake(), replacing the file and fields the GonFile already holds
+int gon_load_baked(GonFile* gon, const char* path) {
+	return gon_load_baked_blob(gon, path, false);
 }
 
+// Same as gon_load_baked(), but checks the whole blob against its checksum, and every record, before any of it is used
+int gon_load_baked_verified(GonFile* gon, const char* path) {
+	return gon_load_baked_blob(gon, path, true);
+}
+
+#endif
+
 /*
 
 typedef struct GonFileBuilder {
@@ -582,6 +5598,9 @@ For the time being, the GonFilePrinter is going to have a maximum object depth o
 I think this is quite reasonable, as there's no reason I can think of to nest things so deeply.
 Frankly, if this is a requirement of your program, you should just set the stack size to be deeper 
 but keep it as a constant value so that everything stays on the stack instead of going to heap.
+The printer stages its output in a buffer of GON_WRITE_BUFFER_SIZE bytes, which goes to the file whenever it fills up and whenever the printer is back at the root
+(after each top-level field, and when each top-level object or array is stepped out of), so nothing is left behind once the last field is written.
+A printer may be set up with gon_printer_init(), or filled in by hand as before (fp, tab_width, depth, indent and parent_type[0]); the rest is only read inside a top-level object or array, by which point the printer has set it.
 */
 #define GON_PRINTER_MAX_DEPTH 1024  
 
@@ -591,93 +5610,100 @@ typedef struct GonFilePrinter {
 	int depth;
 	int tab_width;
 	int indent;
+	bool   space;					// (minified) the next name or value needs a space before it
+	size_t used;					// bytes waiting in buffer, only ever nonzero below the root
+	char   buffer[GON_WRITE_BUFFER_SIZE];
 } GonFilePrinter;
 
-int gon_printer_append(GonFilePrinter* printer, int gon_type, const char* name, const char* value) {
-	bool in_array = (printer->parent_type[printer->depth] == GON_TYPE_ARRAY);
+// Sets up a printer which writes to fp, with the given tab width (or GON_MINIFIED)
+void gon_printer_init(GonFilePrinter* printer, FILE* fp, int tab_width) {
+	printer->fp             = fp;
+	printer->depth          = 0;
+	printer->tab_width      = tab_width;
+	printer->indent         = 0;
+	printer->parent_type[0] = GON_TYPE_OBJECT;
+	printer->space          = false;
+	printer->used           = 0;
+}
 
-	// write field name
-	if (!in_array) {
-		if (name == NULL) {
-			printf("GON Printer error: All fields which are not in an array must have a name.");
-			return 1;
-		}
-		if (!in_array) for (int i = 0; i < printer->indent; i++) fputc(' ', printer->fp); // write indentation if not in array
+// Picks up writing where the printer left off (at the root, the buffer is always empty)
+static inline GonWriter gon_printer_writer(GonFilePrinter* printer) {
+	if (printer->depth == 0) printer->used = 0;
+	GonWriter w = gon_writer_file(printer->fp, printer->buffer, sizeof(printer->buffer), printer->tab_width);
+	w.dst    += printer->used;
+	w.room   -= printer->used;
+	w.indent  = printer->indent;
+	w.space   = printer->tab_width == GON_MINIFIED && printer->space;
+	return w;
+}
 
-		char* c; // used in iterating over name
+// Keeps the writer's state for the next call, writing the buffer out once the printer is back at the root
+static inline void gon_printer_done(GonFilePrinter* printer, GonWriter* w) {
+	if (printer->depth == 0) gon_writer_flush(w);
+	printer->used   = w->dst - w->buffer;
+	printer->indent = w->indent;
+	printer->space  = w->space;
+}
 
-					// check whether to enclose name and/or value in quotes
-		bool in_quotes = false;
-		c = (char*)name;
-		while (*c) if (gon_lookup_non_text[*c++]) { in_quotes = true; break; } 
+// Writes out everything the printer has buffered, such as the part of a top-level object written so far
+void gon_printer_flush(GonFilePrinter* printer) {
+	GonWriter w = gon_printer_writer(printer);
+	gon_writer_flush(&w);
+	printer->used = 0;
+}
 
-		if (in_quotes) fputc('"', printer->fp);							// start quotes
-		c = (char*)name;
-		while (*c) {													// write name escaping characters as necessary
-			if (*c == '\"' || *c == '\\') fputc('\\', printer->fp);		// escape \ and "
-			fputc(*c, printer->fp);										// write next character
-			c++;
-		}
-		if (in_quotes) fputc('"', printer->fp);							// end quotes
-		fputc(' ', printer->fp);										// add a space after name
+// Same as gon_printer_append(), but takes the lengths of name and value rather than expecting them to be null-terminated
+int gon_printer_append_n(GonFilePrinter* printer, int gon_type, const char* name, size_t name_length, const char* value, size_t value_length) {
+	bool in_array = (printer->parent_type[printer->depth] == GON_TYPE_ARRAY);
+
+	// check everything before writing anything, so that an error leaves the output as it was
+	if (!in_array && name == NULL) {
+		printf("GON Printer error: All fields which are not in an array must have a name.");
+		return 1;
+	}
+	if (gon_type == GON_TYPE_FIELD && value == NULL) {
+		printf("GON Printer error: All field types must have a value.");
+		return 1;
 	}
+	if (gon_type != GON_TYPE_FIELD && printer->depth + 1 >= GON_PRINTER_MAX_DEPTH) {
+		puts("GON printer error: Exceeded maximum object depth.");
+		return 1;
+	}
+
+	// write field name
+	GonWriter w = gon_printer_writer(printer);
+	if (!in_array) gon_writer_name(&w, name, name_length, GON_TEXT_CHECKED);		// write name, quoting and escaping as necessary
 
 	// Write field value
 	if (gon_type == GON_TYPE_FIELD) {
-		if (value == NULL) {
-			printf("GON Printer error: All field types must have a value.");
-			return 1;
-		}
-
-		char* c; // used in iterating over value string
-
-		// check whether to enclose name and/or value in quotes
-		bool in_quotes = false;
-		c = (char*)value;
-		while (*c) if (gon_lookup_non_text[*c++]) { in_quotes = true; break; } 
-
-		if (in_quotes) fputc('"', printer->fp);								// start quotes
-		c = (char*)value;															// copy value escaping characters as necessary
-		while (*c) {
-			if (*c == '\"' || *c == '\\') fputc('\\', printer->fp);			// escape \ and "
-			fputc(*c, printer->fp);											// write next character
-			c++;
-		}	
-		if (in_quotes) fputc('"', printer->fp);								// end quotes
-
-		fputc(in_array ? ' ' : '\n', printer->fp);							// write newline on field end (or space if in array)
+		gon_writer_value(&w, value, value_length, GON_TEXT_CHECKED, in_array);		// write value, quoting and escaping as necessary
+		gon_printer_done(printer, &w);
 		return 0;
 	}
 
 	// Step into object
-	if (gon_type == GON_TYPE_ARRAY) {
-		in_array = 1;
-		fputc('[', printer->fp);
-		fputc(' ', printer->fp);
-	}
-	else {
-		fputc('{', printer->fp);
-		fputc('\n', printer->fp);
-	}
-	printer->indent += printer->tab_width;
-
-	if (++printer->depth >= 1024) {
-		puts("GON printer error: Exceeded maximum object depth.");
-		return 1;
-	}
-	printer->parent_type[printer->depth] = gon_type;
+	gon_writer_open(&w, gon_type == GON_TYPE_ARRAY);
+	printer->parent_type[++printer->depth] = gon_type;
+	gon_printer_done(printer, &w);
 
 	return 0;
 }
 
+int gon_printer_append(GonFilePrinter* printer, int gon_type, const char* name, const char* value) {
+	return gon_printer_append_n(printer, gon_type, name, name ? strlen(name) : 0, value, value ? strlen(value) : 0);
+}
+
 int gon_printer_step_out(GonFilePrinter* printer) {
 	if (printer->depth == 0) {
 		printf("GON printer error: cannot step out of root gon object.");
 		return 1;
 	}
-	fputc(printer->parent_type[printer->depth] == GON_TYPE_ARRAY ? ']' : '}', printer->fp);	// write object / array end token
+	bool array = (printer->parent_type[printer->depth] == GON_TYPE_ARRAY);
+	GonWriter w = gon_printer_writer(printer);
 	printer->depth--;
-	fputc(printer->parent_type[printer->depth] == GON_TYPE_ARRAY ? ' ' : '\n', printer->fp);	// write newline on object/array end (or space if in array)
-	printer->indent -= printer->tab_width;
+	gon_writer_close(&w, array, printer->parent_type[printer->depth] == GON_TYPE_ARRAY);	// write object / array end token, then newline (or space if in array)
+	gon_printer_done(printer, &w);
 	return 0;
-}
\ No newline at end of file
+}
+
+#endif
@@ -0,0 +1,222 @@
+/*
+	uGON C++ Binding
+
+	A header-only layer over ugon.h which generates a loader for each struct from a list of its members.
+	The list is an X-macro, given to UGON_REFLECT() once per struct (at global scope):
+
+		struct Stats  { int hp = 100; double speed = 1.0; };
+		struct Weapon { char name[32] = "unnamed"; int damage = 1; float range = 1.5f; Stats stats; std::vector<int> tags; };
+
+		#define STATS_MEMBERS(X)  X(hp) X(speed)
+		#define WEAPON_MEMBERS(X) X(name) X(damage) X(range) X(stats) X(tags)
+		UGON_REFLECT(Stats,  STATS_MEMBERS)
+		UGON_REFLECT(Weapon, WEAPON_MEMBERS)
+
+		Weapon sword;
+		ugon::load(gon_get_field(gon.fields, "sword"), sword);
+
+	Each member is read from the child of the same name. The names are hashed at compile time (ugon::hash_name() is the same FNV-1a hash as gon_hash_name()),
+	and each struct's loader is one switch over those hashes, so a load is a single walk over the object's children with one hash and one jump per child, and no strcmp against every member.
+	Two member names with the same hash would be two identical case labels, which the compiler rejects, so a collision can never go unnoticed.
+	As with gon_get_field(), only the first child with a given name is used, and the walk stops once every member has been found.
+
+	Members whose field is missing are left alone, so default member initializers act as defaults.
+	Numbers and bools are converted with gon_read_int64(), gon_read_double() and gon_read_bool(). A field that has the wrong type or does not convert prints an error and leaves its member alone, and load() then returns false.
+	Supported members are integers, floating point types, bool, std::string, char[N] (copied and cut short if it does not fit), const char* (pointing into the GonFile, with the same caveats as gon_value()),
+	GonField* (the field itself), other reflected structs, and arrays of any of these as T[N] (filled from the front) or std::vector<T>.
+	Loading allocates nothing except for std::string and std::vector members.
+*/
+
+#ifndef UGON_HPP
+#define UGON_HPP
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "ugon.h"
+
+namespace ugon {
+
+// The same hash as gon_hash_name(), usable as a case label
+constexpr unsigned int hash_name(const char* name, unsigned int hash = 2166136261u) {
+	return *name ? hash_name(name + 1, (hash ^ (unsigned char)*name) * 16777619u) : hash;
+}
+
+// Specialized for each struct by UGON_REFLECT()
+template<typename T> struct Reflect;
+
+// Converts one field into a value of type T, specialized below for each kind of member
+template<typename T, typename Enable = void> struct Loader;
+
+// Loads a field into a value, returning false if the field is missing, has the wrong type or does not convert (the value is then left alone, or partly filled for structs and arrays)
+template<typename T> inline bool load(GonField* field, T& out) {
+	return field && Loader<T>::load(field, out);
+}
+
+namespace detail {
+
+// Called from the switch in Reflect<T>::load_member() when a child's name matches a member
+// Returns 1 for a member seen for the first time, or 0 for a later child with the same name (which is ignored)
+template<typename M> inline int load_member(GonField* child, M& member, int index, const char* name, uint64_t* seen, bool* ok) {
+	uint64_t bit = (uint64_t)1 << (index & 63);
+	if (seen[index >> 6] & bit) return 0;
+	seen[index >> 6] |= bit;
+	if (!Loader<M>::load(child, member)) {
+		printf("GON bind error: field \"%s\" has the wrong type or does not convert\n", name);
+		*ok = false;
+	}
+	return 1;
+}
+
+template<typename T> inline bool load_integer(GonField* field, T& out) {
+	int64_t value;
+	if (gon_field_int64(field, &value)) return false;
+	if (std::numeric_limits<T>::is_signed) {
+		if (value < (int64_t)std::numeric_limits<T>::min() || value > (int64_t)std::numeric_limits<T>::max()) return false;
+	} else {
+		if (value < 0 || (uint64_t)value > (uint64_t)std::numeric_limits<T>::max()) return false;
+	}
+	out = (T)value;
+	return true;
+}
+
+} // namespace detail
+
+// Reflected structs
+template<typename T, typename Enable> struct Loader {
+	static bool load(GonField* object, T& out) {
+		if (object->type != GON_TYPE_OBJECT) return false;
+		typedef Reflect<T> R;
+		uint64_t seen[R::member_count / 64 + 1] = {};
+		int  remaining = R::member_count;
+		bool ok = true;
+		GonField* child = object + 1;
+		#ifdef GON_USING_COMPACT_FIELDS
+		GonField* end = object + object->size + (object->self != 0);
+		while (remaining && child < end) {
+		#else
+		for (int i = 0; remaining && i < object->count; i++) {
+		#endif
+			const char* name   = gon_name(child);
+			size_t      length = gon_name_length(child);
+			remaining -= R::load_member(out, child, name, length, gon_hash_name(name, length), seen, &ok);
+			child += child->type == GON_TYPE_FIELD ? 1 : child->size + 1;
+		}
+		return ok;
+	}
+};
+
+template<typename T> struct Loader<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+	static bool load(GonField* field, T& out) { return detail::load_integer(field, out); }
+};
+
+template<typename T> struct Loader<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+	static bool load(GonField* field, T& out) {
+		double value;
+		if (gon_field_double(field, &value)) return false;
+		out = (T)value;
+		return true;
+	}
+};
+
+template<> struct Loader<bool> {
+	static bool load(GonField* field, bool& out) { return gon_field_bool(field, &out) == GON_VALUE_OK; }
+};
+
+template<> struct Loader<std::string> {
+	static bool load(GonField* field, std::string& out) {
+		if (field->type != GON_TYPE_FIELD) return false;
+		out.assign(gon_value(field), gon_value_length(field));
+		return true;
+	}
+};
+
+template<> struct Loader<const char*> {
+	static bool load(GonField* field, const char*& out) {
+		if (field->type != GON_TYPE_FIELD) return false;
+		out = gon_value(field);
+		return true;
+	}
+};
+
+template<> struct Loader<GonField*> {
+	static bool load(GonField* field, GonField*& out) {
+		out = field;
+		return true;
+	}
+};
+
+template<size_t N> struct Loader<char[N]> {
+	static bool load(GonField* field, char (&out)[N]) {
+		if (field->type != GON_TYPE_FIELD) return false;
+		const char* value  = gon_value(field);
+		size_t      length = gon_value_length(field);
+		if (length >= N) length = N - 1;
+		memcpy(out, value, length);
+		out[length] = '\0';
+		return true;
+	}
+};
+
+// Fills the array from the front, and fails if the GON array has more elements than fit
+template<typename T, size_t N> struct Loader<T[N]> {
+	static bool load(GonField* field, T (&out)[N]) {
+		if (field->type != GON_TYPE_ARRAY) return false;
+		bool   ok    = true;
+		size_t count = 0;
+		GonField* end = field + field->size + 1;
+		for (GonField* element = field + 1; element < end; element += element->type == GON_TYPE_FIELD ? 1 : element->size + 1) {
+			if (count == N) return false;
+			ok &= Loader<T>::load(element, out[count++]);
+		}
+		return ok;
+	}
+};
+
+template<typename T> struct Loader<std::vector<T> > {
+	static bool load(GonField* field, std::vector<T>& out) {
+		if (field->type != GON_TYPE_ARRAY) return false;
+		out.clear();
+		out.reserve(gon_count(field));
+		bool ok = true;
+		GonField* end = field + field->size + 1;
+		for (GonField* element = field + 1; element < end; element += element->type == GON_TYPE_FIELD ? 1 : element->size + 1) {
+			out.push_back(T());
+			ok &= Loader<T>::load(element, out.back());
+		}
+		return ok;
+	}
+};
+
+} // namespace ugon
+
+#define UGON_REFLECT_INDEX(member) member,
+#define UGON_REFLECT_CASE(member)																\
+	case ::ugon::hash_name(#member):															\
+		if (length == sizeof(#member) - 1 && memcmp(name, #member, length) == 0)				\
+			return ::ugon::detail::load_member(child, out.member, Index::member, #member, seen, ok);	\
+		break;
+
+// Generates ugon::Reflect<type> from an X-macro listing its members, which lets ugon::load() fill the struct
+// Must be used at global scope
+#define UGON_REFLECT(type, members)																\
+	namespace ugon {																			\
+	template<> struct Reflect<type> {															\
+		struct Index { enum { members(UGON_REFLECT_INDEX) ugon_member_count_ }; };				\
+		enum { member_count = Index::ugon_member_count_ };										\
+		static int load_member(type& out, GonField* child, const char* name, size_t length, unsigned int hash, uint64_t* seen, bool* ok) {	\
+			switch (hash) {																		\
+			members(UGON_REFLECT_CASE)															\
+			}																					\
+			return 0;																			\
+		}																						\
+	};																							\
+	}
+
+#endif